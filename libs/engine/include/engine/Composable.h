@@ -1,11 +1,15 @@
 #pragma once
 
+#include "engine/DrawState.h"
+
 #include <vulkan/vulkan.hpp>
 #include <glm/glm.hpp>
 
 #include <functional>
 #include <initializer_list>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_set>
 
@@ -20,10 +24,26 @@ public:
 
     [[nodiscard]] bool attached() const noexcept;
     [[nodiscard]] bool hasChild(const std::shared_ptr<Composable>& child) const noexcept;
+    [[nodiscard]] const std::unordered_set<std::shared_ptr<Composable>>& getChildren() const noexcept;
+
+    // A human-readable label, used to identify this composable in GPU timing reports
+    void setName(std::string_view name);
+    [[nodiscard]] const std::string& getName() const noexcept;
 
+    /**
+     * Records drawing commands of this composable and its descendants to the given command buffer, which has been
+     * begun by the Renderer as a secondary command buffer continuing the render pass described by inheritanceInfo.
+     * Composables recording in parallel (e.g. ShadingGroup) begin their own secondary command buffers with the same
+     * inheritance info and return them, the Renderer executes them after the given command buffer.
+     *
+     * The state tracks what has been recorded to the given command buffer so far, the onPipelineBound callback
+     * only has to be invoked once per command buffer to set the dynamic states.
+     */
     [[nodiscard]] virtual std::vector<vk::CommandBuffer> recordDrawingCommands(
         uint32_t frameIndex,
         const vk::CommandBuffer& commandBuffer,
+        DrawState& state,
+        const vk::CommandBufferInheritanceInfo& inheritanceInfo,
         const glm::mat4& cameraMatrix,
         const glm::mat4& currentTransform,
         const std::function<void(const vk::CommandBuffer&)>& onPipelineBound) const = 0;
@@ -31,6 +51,7 @@ public:
     virtual void recordDrawingCommands(
         uint32_t frameIndex,
         const vk::CommandBuffer& commandBuffer,
+        DrawState& state,
         const glm::mat4& cameraMatrix,
         const glm::mat4& currentTransform) const = 0;
 
@@ -44,4 +65,6 @@ protected:
 
     std::weak_ptr<Composable> _parent{};
     std::unordered_set<std::shared_ptr<Composable>> _children{};
+
+    std::string _name{};
 };
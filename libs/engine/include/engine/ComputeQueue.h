@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+
+class ShaderInstance;
+class StorageBuffer;
+
+
+/**
+ * Submits compute jobs to the dedicated compute queue family, if the device has one, so that they run alongside
+ * rendering and presentation rather than between frames. Otherwise, jobs go to the graphics queue, which still works
+ * but no longer overlaps with rendering.
+ *
+ * Each dispatch returns a ticket, increasing with every job. Storage buffers a job writes are released by the compute
+ * queue family, then acquired by the graphics queue family the first time isComplete reports the job finished. From
+ * then on, any frame rendered may read them. Buffers the job only reads must have been built with
+ * StorageBuffer::Builder::concurrent. Buffers built with StorageBuffer::Builder::hostReadable can be read back by the
+ * host as soon as the job has finished, whether they are listed as outputs or not.
+ *
+ * Apart from wait, methods must be called on the thread that renders since they submit to the graphics queue.
+ */
+class ComputeQueue {
+public:
+    /**
+     * Records a dispatch of the shader instance's compute pipeline and submits it right away. The instance's
+     * descriptor set of the first in-flight frame gets bound, storage buffer descriptors are the same for all frames.
+     *
+     * A job may overwrite a buffer that frames already read from, but only once those frames have retired.
+     *
+     * @param instance A ShaderInstance of a shader built with ComputeShader::Builder.
+     * @param groupCountX The number of local workgroups to dispatch in the X dimension.
+     * @param groupCountY The number of local workgroups to dispatch in the Y dimension.
+     * @param groupCountZ The number of local workgroups to dispatch in the Z dimension.
+     * @param pushConstants The contents of the shader's push constant block, if any.
+     * @param pushConstantSize The byte size of the push constants.
+     * @param outputs Storage buffers the job writes and rendering later reads.
+     * @return The ticket of the job.
+     */
+    uint64_t dispatch(
+        const ShaderInstance* instance,
+        uint32_t groupCountX,
+        uint32_t groupCountY = 1,
+        uint32_t groupCountZ = 1,
+        const void* pushConstants = nullptr,
+        uint32_t pushConstantSize = 0,
+        const std::vector<const StorageBuffer*>& outputs = {});
+
+    /**
+     * Checks without blocking whether a job has finished. The first time a job is found finished, its outputs are
+     * handed over to the graphics queue so that frames rendered after this call can read them.
+     *
+     * @param ticket The ticket returned by dispatch.
+     * @return Whether the job has finished and its outputs can be read by rendering.
+     */
+    [[nodiscard]] bool isComplete(uint64_t ticket);
+
+    /**
+     * Blocks until the job has finished on the GPU. Unlike other methods, this can be called from any thread, e.g.
+     * to wake up an event loop with Context::requestRedraw. Rendering may only read the job's outputs after
+     * isComplete has returned true.
+     *
+     * @param ticket The ticket returned by dispatch.
+     */
+    void wait(uint64_t ticket) const;
+
+    /**
+     * @return Whether jobs run on a dedicated compute queue family, overlapping with rendering.
+     */
+    [[nodiscard]] bool isAsync() const noexcept;
+
+    ComputeQueue(const ComputeQueue&) = delete;
+    ComputeQueue& operator=(const ComputeQueue&) = delete;
+
+private:
+    ComputeQueue(
+        const vk::Device& device,
+        const vk::Queue& computeQueue,
+        uint32_t computeFamily,
+        const vk::Queue& graphicsQueue,
+        uint32_t graphicsFamily);
+
+    void acquire(uint64_t ticket);
+    void retire();
+
+    vk::Device _device;
+
+    vk::Queue _computeQueue;
+    uint32_t _computeFamily;
+    vk::Queue _graphicsQueue;
+    uint32_t _graphicsFamily;
+
+    // Jobs are recorded from the compute family pool, ownership acquisitions from the graphics family one
+    vk::CommandPool _computeCommandPool;
+    vk::CommandPool _graphicsCommandPool;
+
+    // The compute timeline reaches a job's ticket when its dispatch has finished, the graphics timeline when its
+    // outputs have been acquired by the graphics queue
+    vk::Semaphore _computeTimeline;
+    vk::Semaphore _graphicsTimeline;
+    uint64_t _ticket{ 0 };
+    uint64_t _acquiredTicket{ 0 };
+
+    // Jobs whose command buffers may still be executing, in ticket order
+    struct Job {
+        uint64_t ticket;
+        vk::CommandBuffer computeBuffer;
+        vk::CommandBuffer acquireBuffer{};
+        std::vector<vk::Buffer> outputs{};
+    };
+    std::deque<Job> _jobs{};
+
+    // Would be better if we have an "internal" access specifier
+    friend class Engine;
+};
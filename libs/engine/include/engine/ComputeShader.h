@@ -9,6 +9,15 @@ public:
     public:
         Builder& computeShader(const std::filesystem::path& path, std::string entryPoint = "main");
 
+        /**
+         * Declares a push constant block for the compute stage, starting at offset 0. Jobs pass its contents with
+         * each dispatch, see ComputeQueue::dispatch.
+         *
+         * @param byteSize The byte size of the push constant block, within the device's limit.
+         * @return this Builder object for chaining calls.
+         */
+        Builder& pushConstantSize(uint32_t byteSize);
+
         [[nodiscard]] Shader* build(const Engine& engine);
 
     private:
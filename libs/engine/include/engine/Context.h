@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string_view>
@@ -10,21 +11,59 @@ using Surface = GLFWwindow;
 
 class Context final {
 public:
-    static std::unique_ptr<Context> create(std::string_view name);
+    static std::unique_ptr<Context> create(std::string_view name, bool visible = true);
     void destroy() const noexcept;
 
     static void setOnMouseClick(const std::function<void(double, double)>& callback);
     static void setOnMouseClick(std::function<void(double, double)>&& callback) noexcept;
 
+    /**
+     * Sets a callback for dragging with the right mouse button held. It is called whenever the cursor moves during a
+     * drag, with the position the drag started at followed by the current position, both in screen coordinates. The
+     * last call of each drag happens on release, with the final argument set to true.
+     */
+    static void setOnMouseDrag(const std::function<void(double, double, double, double, bool)>& callback);
+    static void setOnMouseDrag(std::function<void(double, double, double, double, bool)>&& callback) noexcept;
+
     [[nodiscard]] Surface* getSurface() const;
 
+    /**
+     * Switches the event loop between rendering continuously and rendering on demand. On demand, the loop sleeps in
+     * glfwWaitEvents until input arrives or a redraw is requested, then renders a few frames for the overlay to settle.
+     * Nothing gets rendered while the window is idle, letting the CPU and GPU power down.
+     *
+     * @param enabled Whether to render on demand, disabled by default.
+     */
+    void setRenderOnDemand(bool enabled) noexcept;
+
+    [[nodiscard]] bool isRenderOnDemand() const noexcept;
+
+    /**
+     * Wakes up the event loop when rendering on demand, so that the next frames pick up whatever has changed outside
+     * of input handling, e.g. a background upload or compute job having finished. May be called from any thread.
+     *
+     * @param frameCount The minimum number of frames to render before the loop goes back to sleep.
+     */
+    static void requestRedraw(uint32_t frameCount = 1);
+
     void loop(const std::function<void()>& onFrame) const;
 
+    /**
+     * Runs the event loop, calling beforePoll right before window events are polled each iteration. Blocking there,
+     * e.g. with Renderer::waitForNextFrame, lets input be sampled as late as possible before the frame is recorded.
+     *
+     * @param beforePoll Called before polling events, input callbacks fire after it returns.
+     * @param onFrame Called after polling events.
+     */
+    void loop(const std::function<void()>& beforePoll, const std::function<void()>& onFrame) const;
+
     Context(const Context&) = delete;
     Context& operator=(const Context&) = delete;
 
 private:
-    explicit Context(std::string_view name);
+    Context(std::string_view name, bool visible);
 
     GLFWwindow* _window;
+
+    bool _renderOnDemand{ false };
 };
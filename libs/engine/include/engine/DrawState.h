@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <optional>
+
+
+class IndexBuffer;
+class InstanceBuffer;
+class VertexBuffer;
+
+
+/**
+ * Tracks what has last been recorded to a command buffer, letting consecutive draws skip re-binding the same
+ * pipeline, descriptor set, vertex and index buffers, or re-setting the same dynamic states. Every command buffer
+ * being recorded must have its own DrawState, starting from a default-constructed one.
+ *
+ * All graphics pipelines created by the engine share the same set of dynamic states, which therefore persist across
+ * pipeline binds and only need to be set once per command buffer.
+ */
+struct DrawState {
+    vk::Pipeline pipeline{};
+    vk::PipelineLayout pipelineLayout{};
+    vk::DescriptorSet descriptorSet{};
+    const VertexBuffer* vertexBuffer{ nullptr };
+    const InstanceBuffer* instanceBuffer{ nullptr };
+    const IndexBuffer* indexBuffer{ nullptr };
+    std::optional<vk::PrimitiveTopology> topology{};
+    bool dynamicStatesSet{ false };
+};
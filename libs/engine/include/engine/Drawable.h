@@ -8,6 +8,7 @@
 class Engine;
 class ShaderInstance;
 class IndexBuffer;
+class InstanceBuffer;
 class VertexBuffer;
 
 
@@ -41,6 +42,15 @@ public:
 
         Builder& material(uint32_t meshIndex, const ShaderInstance* instance);
 
+        /**
+         * Draws every primitive of this Drawable once per instance held by the InstanceBuffer, all in a single draw
+         * call. The Drawable's own transform still applies on top of the per-instance data.
+         *
+         * @param buffer The per-instance data, whose binding must not collide with those of the vertex buffers.
+         * @return this Builder object for chaining calls.
+         */
+        Builder& instances(const InstanceBuffer* buffer);
+
         [[nodiscard]] std::shared_ptr<Drawable> build(const Engine& engine);
 
     private:
@@ -48,11 +58,14 @@ public:
 
         std::vector<Primitive> _primitives{};
         std::vector<const ShaderInstance*> _shaderInstances{};
+        const InstanceBuffer* _instanceBuffer{ nullptr };
     };
 
     [[nodiscard]] std::vector<vk::CommandBuffer> recordDrawingCommands(
         uint32_t frameIndex,
         const vk::CommandBuffer& commandBuffer,
+        DrawState& state,
+        const vk::CommandBufferInheritanceInfo& inheritanceInfo,
         const glm::mat4& cameraMatrix,
         const glm::mat4& currentTransform,
         const std::function<void(const vk::CommandBuffer&)>& onPipelineBound) const override;
@@ -60,17 +73,58 @@ public:
     void recordDrawingCommands(
         uint32_t frameIndex,
         const vk::CommandBuffer &commandBuffer,
+        DrawState& state,
         const glm::mat4& cameraMatrix,
         const glm::mat4& currentTransform) const override;
 
+    /**
+     * Records a single primitive of this Drawable, ignoring its children. This is how the Renderer draws the entries
+     * of a Scene's render queue, where primitives are ordered by pipeline rather than by the drawable they belong to.
+     *
+     * @param worldTransform The transform of this Drawable in world space, its local transform included.
+     * @param onPipelineBound Invoked to set dynamic states if the state says they haven't been, may be null.
+     */
+    void recordPrimitive(
+        uint32_t frameIndex,
+        const vk::CommandBuffer& commandBuffer,
+        DrawState& state,
+        const glm::mat4& cameraMatrix,
+        const glm::mat4& worldTransform,
+        uint32_t primitive,
+        const std::function<void(const vk::CommandBuffer&)>* onPipelineBound) const;
+
+    /**
+     * Swaps the ShaderInstance a primitive is drawn with, for example to switch between variants of the same shader.
+     * The Renderer records its drawing commands again on the next frame.
+     *
+     * @param primitive The index of the primitive.
+     * @param instance The ShaderInstance to draw the primitive with from now on.
+     */
+    void setMaterial(uint32_t primitive, const ShaderInstance* instance);
+
+    [[nodiscard]] uint32_t getPrimitiveCount() const noexcept;
+    [[nodiscard]] const ShaderInstance* getShaderInstanceAt(uint32_t primitive) const;
+    [[nodiscard]] const VertexBuffer* getVertexBufferAt(uint32_t primitive) const;
+
     Drawable(
         std::vector<Primitive>&& primitives,
         std::vector<const ShaderInstance*>&& shaderInstances,
+        const InstanceBuffer* instanceBuffer,
         PFN_vkCmdSetVertexInputEXT vkCmdSetVertexInput);
 
 private:
+    // The vertex input of an instanced primitive, merging the bindings and attributes of its vertex buffer with
+    // those of the instance buffer. Built once so that recording doesn't have to
+    struct VertexInput {
+        std::vector<VkVertexInputBindingDescription2EXT> bindings;
+        std::vector<VkVertexInputAttributeDescription2EXT> attributes;
+    };
+
     std::vector<Primitive> _primitives{};
     std::vector<const ShaderInstance*> _shaderInstances{};
 
+    const InstanceBuffer* _instanceBuffer;
+    std::vector<VertexInput> _instancedVertexInputs{};
+
     PFN_vkCmdSetVertexInputEXT _vkCmdSetVertexInput;
 };
@@ -3,15 +3,20 @@
 #include "engine/Buffer.h"
 #include "engine/Context.h"
 #include "engine/Composable.h"
+#include "engine/ComputeQueue.h"
 #include "engine/Image.h"
+#include "engine/MemoryStatistics.h"
 #include "engine/Renderer.h"
 #include "engine/Sampler.h"
 #include "engine/ShaderInstance.h"
+#include "engine/ShadingGroup.h"
 #include "engine/SwapChain.h"
 
+#include <filesystem>
 #include <memory>
 
 
+class DescriptorAllocator;
 class ResourceAllocator;
 
 
@@ -23,7 +28,21 @@ struct EngineFeature {
 
 class Engine final {
 public:
-    static std::unique_ptr<Engine> create(Surface* surface, const EngineFeature& feature = {});
+    /**
+     * Creates an Engine rendering to the specified surface.
+     *
+     * All pipelines the Engine creates go through a single pipeline cache. If a cache directory is given, the cache
+     * gets loaded from a file named after the physical device in that directory, and written back to it when the
+     * Engine is destroyed. A cache file written by another device or driver version is discarded. With no cache
+     * directory, pipelines are still cached within a run but every launch compiles them from scratch.
+     *
+     * @param surface The surface to render to.
+     * @param feature Optional device features to enable.
+     * @param pipelineCacheDirectory The directory to persist the pipeline cache in, created if it doesn't exist.
+     * @return A unique-pointer to the created Engine object.
+     */
+    static std::unique_ptr<Engine> create(
+        Surface* surface, const EngineFeature& feature = {}, const std::filesystem::path& pipelineCacheDirectory = {});
     void destroy() noexcept;
 
     /**
@@ -68,6 +87,24 @@ public:
      */
     void destroyRenderer(const std::unique_ptr<Renderer>& renderer) const noexcept;
 
+    /**
+     * Creates a ComputeQueue submitting to the dedicated compute queue family if the device has one, or to the
+     * graphics queue otherwise.
+     *
+     * @return A unique-pointer to the created ComputeQueue object.
+     */
+    [[nodiscard]] std::unique_ptr<ComputeQueue> createComputeQueue() const;
+
+    /**
+     * Destroys all internal resources associated with the specified ComputeQueue. None of its jobs may still be
+     * executing, which waitIdle guarantees.
+     *
+     * This function must be called prior to Engine::destroy when the program exits to free all native resources.
+     *
+     * @param queue The ComputeQueue to destroy.
+     */
+    void destroyComputeQueue(const std::unique_ptr<ComputeQueue>& queue) const noexcept;
+
     void destroyBuffer(const Buffer* buffer) const noexcept;
 
     void destroyImage(const std::shared_ptr<Image>& image) const noexcept;
@@ -77,13 +114,38 @@ public:
     void destroyShader(const Shader* shader) const noexcept;
     void destroyShaderInstance(const ShaderInstance* instance) const noexcept;
 
+    /**
+     * Destroys the command pools a ShadingGroup records with. The ShadingGroup must no longer be attached to any
+     * rendered scene and none of its command buffers may be pending execution.
+     *
+     * @param group The ShadingGroup to destroy.
+     */
+    void destroyShadingGroup(const std::shared_ptr<ShadingGroup>& group) const noexcept;
+
     void waitIdle() const;
 
+    /**
+     * Queries the current device memory budget of every memory heap via VK_EXT_memory_budget, along with the number
+     * and size of allocations this Engine has made, broken down by ResourceKind. The query is cheap enough to be
+     * made once per frame.
+     *
+     * @return A snapshot of device memory usage.
+     */
+    [[nodiscard]] MemoryStatistics getMemoryStatistics() const;
+
     Engine(const Engine&) = delete;
     Engine& operator=(const Engine&) = delete;
 
     [[nodiscard]] const EngineFeature& getEngineFeature() const;
 
+    [[nodiscard]] uint32_t getGraphicsQueueFamily() const;
+
+    // The dedicated compute family if there is one, the graphics family otherwise
+    [[nodiscard]] uint32_t getComputeQueueFamily() const;
+
+    // Subgroup operations compute shaders may use, none if compute shaders don't support subgroups at all
+    [[nodiscard]] vk::SubgroupFeatureFlags getSubgroupOperations() const;
+
     [[nodiscard]] uint32_t getLimitPushConstantSize() const;
     [[nodiscard]] float getLimitMaxSamplerAnisotropy() const;
     [[nodiscard]] uint32_t getLimitMinUniformBufferOffsetAlignment() const;
@@ -97,11 +159,13 @@ public:
     [[nodiscard]] vk::Device getNativeDevice() const;
     [[nodiscard]] vk::Queue getNativeTransferQueue() const;
     [[nodiscard]] vk::CommandPool getNativeTransferCommandPool() const;
+    [[nodiscard]] vk::PipelineCache getNativePipelineCache() const;
 
     [[nodiscard]] ResourceAllocator* getResourceAllocator() const;
+    [[nodiscard]] DescriptorAllocator* getDescriptorAllocator() const;
 
 private:
-    Engine(GLFWwindow* window, const EngineFeature& feature);
+    Engine(GLFWwindow* window, const EngineFeature& feature, const std::filesystem::path& pipelineCacheDirectory);
     static vk::PhysicalDeviceFeatures2 getPhysicalDeviceFeatures(const EngineFeature& feature);
     static void cleanupPhysicalDeviceFeatures(const vk::PhysicalDeviceFeatures2& deviceFeatures);
 
@@ -128,8 +192,16 @@ private:
     vk::Queue _transferQueue;
     vk::CommandPool _transferCommandPool;
 
+    // Every graphics pipeline and the overlay's pipeline are created through this cache, which gets persisted to a
+    // file in the cache directory, if any, when the Engine is destroyed
+    std::filesystem::path _pipelineCacheDirectory;
+    vk::PipelineCache _pipelineCache;
+
     // Our internal allocator, backed by the VMA library. Note that we cannot use a unique_ptr here because otherwise
     // the compiler would need to see the full definition of ResourceAllocator. This would require the library to
     // expose the VMA and other allocator infrastructure.
     ResourceAllocator* _allocator;
+
+    // Descriptor sets of all ShaderInstances come from the shared, growing pools of this allocator
+    DescriptorAllocator* _descriptorAllocator;
 };
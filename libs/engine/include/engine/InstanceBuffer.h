@@ -0,0 +1,106 @@
+#pragma once
+
+#include "engine/Buffer.h"
+#include "engine/Renderer.h"
+#include "engine/VertexBuffer.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+class Engine;
+
+
+/**
+ * Represents a persistently mapped buffer of per-instance vertex data, such as a transform and a color for each copy
+ * of a mesh. A Drawable given an InstanceBuffer draws each of its primitives once per instance in a single draw call,
+ * reading the instance attributes from a binding whose input rate is per instance.
+ *
+ * Like a UniformBuffer, the buffer conceptually holds a separate copy of the instance data for each in-flight frame,
+ * so that instances can be moved every frame without waiting on the GPU.
+ */
+class InstanceBuffer final : public Buffer {
+public:
+    class Builder {
+    public:
+        /**
+         * Specifies the maximum number of instances this buffer can hold.
+         *
+         * @param count The instance capacity.
+         * @return this Builder object for chaining calls.
+         */
+        Builder& capacity(uint32_t count);
+
+        /**
+         * Specifies the vertex binding this buffer will be bound to. It must not collide with any binding of the
+         * VertexBuffers it is drawn with.
+         *
+         * @param binding The binding number.
+         * @param byteStride The byte size of the data of each instance.
+         * @return this Builder object for chaining calls.
+         */
+        Builder& binding(uint32_t binding, uint32_t byteStride);
+
+        /**
+         * Adds a per-instance attribute. A mat4 attribute takes 4 consecutive locations, each of AttributeFormat::Float4.
+         *
+         * @param location the location of this attribute in the vertex shader code.
+         * @param format The type and number of components of this attribute.
+         * @param byteOffset The byte offset of this attribute within the data of each instance.
+         * @return this Builder object for chaining calls.
+         */
+        Builder& attribute(uint32_t location, AttributeFormat format, uint32_t byteOffset = 0);
+
+        [[nodiscard]] InstanceBuffer* build(const Engine& engine) const;
+
+    private:
+        uint32_t _capacity{ 0 };
+        VkVertexInputBindingDescription2EXT _binding{};
+        std::vector<VkVertexInputAttributeDescription2EXT> _attributes{};
+    };
+
+    /**
+     * Writes the instance data associated with the frame index and sets how many instances will be drawn for that
+     * frame. Intended to be called from the callback of Renderer::render, which provides the frame index.
+     *
+     * Writing new data is nothing more than a memcpy to mapped memory. Only a change in the instance count requires
+     * the Renderer to record its drawing commands again.
+     *
+     * @param frameIndex The frame index provided by the callback of Renderer::render.
+     * @param data The data of instanceCount instances, laid out with the byte stride of this buffer.
+     * @param instanceCount The number of instances to draw, must not exceed the capacity of this buffer.
+     */
+    void setData(uint32_t frameIndex, const void* data, uint32_t instanceCount);
+
+    /**
+     * Writes the instance data of all in-flight frames at once. Like UniformBuffer::setData without a frame index,
+     * this must NOT be called inside the main render loop.
+     */
+    void setData(const void* data, uint32_t instanceCount);
+
+    [[nodiscard]] uint32_t getInstanceCount(uint32_t frameIndex) const;
+    [[nodiscard]] uint32_t getCapacity() const;
+
+    [[nodiscard]] const VkVertexInputBindingDescription2EXT& getBindingDescription() const;
+    [[nodiscard]] const std::vector<VkVertexInputAttributeDescription2EXT>& getAttributeDescriptions() const;
+    [[nodiscard]] vk::DeviceSize getOffset(uint32_t frameIndex) const;
+
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+private:
+    InstanceBuffer(
+        uint32_t capacity,
+        const VkVertexInputBindingDescription2EXT& binding,
+        std::vector<VkVertexInputAttributeDescription2EXT>&& attributes,
+        const vk::Buffer& buffer,
+        void* allocation,
+        std::byte* pMappedData);
+
+    uint32_t _capacity;
+    VkVertexInputBindingDescription2EXT _bindingDescription;
+    std::vector<VkVertexInputAttributeDescription2EXT> _attributeDescriptions;
+
+    std::array<uint32_t, Renderer::getMaxFramesInFlight()> _instanceCounts{};
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+// What a device memory allocation is used for, so that usage can be broken down per kind of resource
+enum class ResourceKind {
+    StorageBuffer,
+    UniformBuffer,
+    GeometryBuffer,
+    Texture,
+    SwapChainTarget,
+    Staging,
+};
+
+static constexpr auto RESOURCE_KIND_COUNT = 6;
+
+constexpr std::string_view getResourceKindName(const ResourceKind kind) {
+    switch (kind) {
+        case ResourceKind::StorageBuffer:   return "Storage buffers";
+        case ResourceKind::UniformBuffer:   return "Uniform buffers";
+        case ResourceKind::GeometryBuffer:  return "Vertex/index buffers";
+        case ResourceKind::Texture:         return "Textures";
+        case ResourceKind::SwapChainTarget: return "Swap chain targets";
+        case ResourceKind::Staging:         return "Staging buffers";
+        default: return "Unknown";
+    }
+}
+
+struct HeapBudget {
+    bool deviceLocal{ false };
+    // Bytes the whole process (including other APIs and allocators) currently uses and may use from this heap,
+    // as reported by VK_EXT_memory_budget
+    uint64_t usage{ 0 };
+    uint64_t budget{ 0 };
+    // Bytes and counts of memory blocks and allocations made by this engine in this heap
+    uint64_t blockBytes{ 0 };
+    uint64_t allocationBytes{ 0 };
+    uint32_t blockCount{ 0 };
+    uint32_t allocationCount{ 0 };
+};
+
+struct ResourceUsage {
+    uint32_t count{ 0 };
+    uint64_t bytes{ 0 };
+};
+
+struct MemoryStatistics {
+    std::vector<HeapBudget> heaps{};
+    std::array<ResourceUsage, RESOURCE_KIND_COUNT> resources{};
+};
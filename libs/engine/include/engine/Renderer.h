@@ -3,8 +3,13 @@
 #include <vulkan/vulkan.hpp>
 
 #include <array>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
 
 class SwapChain;
@@ -14,6 +19,19 @@ class Overlay;
 
 class Renderer {
 public:
+    /**
+     * Rolling averages of GPU execution times in milliseconds, measured with timestamp queries. The drawables list
+     * holds one entry per top-level composable of the rendered scene, identified by Composable::getName, and its
+     * time includes that of all its children, except those recorded by a ShadingGroup into secondary command buffers
+     * of its own, which only count towards the view time.
+     */
+    struct GpuTimings {
+        float frame{ 0.0f };
+        float view{ 0.0f };
+        float overlay{ 0.0f };
+        std::vector<std::pair<std::string, float>> drawables{};
+    };
+
     void render(
         const std::unique_ptr<View>& view,
         const std::shared_ptr<SwapChain>& swapChain,
@@ -27,21 +45,89 @@ public:
 
     static constexpr int getMaxFramesInFlight() { return MAX_FRAMES_IN_FLIGHT; }
 
+    static constexpr int getDefaultFramesInFlight() { return DEFAULT_FRAMES_IN_FLIGHT; }
+
+    /**
+     * Sets how many frames the CPU may record ahead of the GPU, between 1 and getMaxFramesInFlight. A single frame in
+     * flight minimizes input latency at the cost of throughput, since the CPU then waits for the GPU every frame,
+     * while the maximum of 3 lets the CPU absorb the occasional slow frame. Frame indices passed to onFrameBegin stay
+     * below the count, so resources sized for the maximum remain valid.
+     *
+     * @param count The number of frames in flight. Counts of 0 are raised to 1, counts above getMaxFramesInFlight are
+     * lowered to it.
+     */
+    void setFramesInFlight(uint32_t count) noexcept;
+
+    [[nodiscard]] uint32_t getFramesInFlight() const noexcept;
+
+    /**
+     * Blocks until the GPU has finished the frame whose resources the next render call will reuse. Rendering
+     * performs the same wait anyway, calling this before polling for input merely moves it earlier, so that input
+     * gets sampled as late as possible before it is recorded.
+     */
+    void waitForNextFrame() const;
+
+    /**
+     * Marks that user input has just been received. The time from this call until the GPU finishes the first frame
+     * submitted afterward is reported by getInputLatency. Only the earliest input per frame is tracked.
+     */
+    void markInput() noexcept;
+
+    /**
+     * Returns a rolling average of the latency between input marked with markInput and the completion of the frame
+     * reflecting it on the GPU. Presentation and display scan-out add to this, depending on the present mode.
+     *
+     * @return The input-to-GPU-completion latency in milliseconds, zero until input has been marked.
+     */
+    [[nodiscard]] float getInputLatency() const noexcept;
+
+    /**
+     * Returns the GPU timings of recently completed frames. Results are read back only once the frame that produced
+     * them has retired, so they lag the current frame by as many frames as are in flight but never stall rendering.
+     *
+     * @return Rolling GPU timings, all zeros if the graphics queue does not support timestamp queries.
+     */
+    [[nodiscard]] const GpuTimings& getGpuTimings() const noexcept;
+
+    [[nodiscard]] bool isGpuTimingSupported() const noexcept;
+
+    /**
+     * Drops all cached view command buffers, forcing the next frames to record the view from scratch.
+     *
+     * The Renderer re-records a view only when something baked into its commands has changed: the composable tree,
+     * transforms, the scene, the view and its camera, or the descriptors written to shader instances. Otherwise the
+     * command buffers recorded for the same in-flight frame are executed again. Changing the contents of buffers
+     * and textures doesn't require re-recording. Call this method after any other change that should show up in
+     * the recorded commands.
+     */
+    void invalidate() noexcept;
+
 private:
     Renderer(
         const vk::CommandPool& graphicsCommandPool,
         const vk::Queue& graphicsQueue,
         const vk::Device& device,
-        PFN_vkCmdSetPolygonModeEXT vkCmdSetPolygonMode);
+        PFN_vkCmdSetPolygonModeEXT vkCmdSetPolygonMode,
+        float timestampPeriod,
+        uint32_t timestampValidBits);
+
+    void renderFrame(
+        const std::unique_ptr<View>& view,
+        Overlay* overlay,
+        const std::shared_ptr<SwapChain>& swapChain,
+        const std::function<void(uint32_t)>& onFrameBegin);
 
-    void renderView(const std::unique_ptr<View>& view) const;
-    void renderOverlay(const std::shared_ptr<Overlay>& overlay) const;
+    [[nodiscard]] std::vector<vk::CommandBuffer> renderView(
+        const std::unique_ptr<View>& view, const vk::CommandBufferInheritanceInfo& inheritanceInfo);
+    [[nodiscard]] vk::CommandBuffer renderOverlay(
+        Overlay* overlay, const vk::CommandBufferInheritanceInfo& inheritanceInfo) const;
 
     bool beginFrame(
         const std::shared_ptr<SwapChain>& swapChain,
         const std::function<void(uint32_t)>& onFrameBegin,
-        uint32_t* imageIndex) const;
-    void endFrame(uint32_t imageIndex, const std::shared_ptr<SwapChain>& swapChain) const;
+        uint32_t* imageIndex);
+    void endFrame(uint32_t imageIndex, const std::shared_ptr<SwapChain>& swapChain);
+    void collectInputLatency();
 
     vk::CommandPool _graphicsCommandPool;
     vk::Queue _graphicsQueue;
@@ -50,12 +136,43 @@ private:
     // the Renderer better off get its own copy of it
     vk::Device _device;
 
-    // Each in-flight frame will has its own command buffer, semaphore set, and in-flight fence
-    static constexpr auto MAX_FRAMES_IN_FLIGHT = 2;
+    // Each in-flight frame will has its own command buffer and semaphore set. Arrays are sized to the maximum,
+    // of which only the first _framesInFlight slots are used
+    static constexpr auto MAX_FRAMES_IN_FLIGHT = 3;
+    static constexpr auto DEFAULT_FRAMES_IN_FLIGHT = 2;
+    uint32_t _framesInFlight{ DEFAULT_FRAMES_IN_FLIGHT };
     std::array<vk::CommandBuffer, MAX_FRAMES_IN_FLIGHT> _drawingCommandBuffers;
+
+    // The render pass contents are recorded to secondary command buffers which the primary drawing command buffer
+    // then executes. Composables recording inline write to the view buffer, while ShadingGroups return their own
+    // buffers recorded in parallel. The overlay buffer is executed last and also closes the view timing.
+    std::array<vk::CommandBuffer, MAX_FRAMES_IN_FLIGHT> _viewCommandBuffers;
+    std::array<vk::CommandBuffer, MAX_FRAMES_IN_FLIGHT> _overlayCommandBuffers;
+
+    // The view buffers, along with those handed back by ShadingGroups, are kept for as long as the render revision
+    // they were recorded at stays current. Each in-flight frame caches its own set since its descriptor sets differ
+    struct ViewCache {
+        const View* view{ nullptr };
+        vk::RenderPass renderPass{};
+        uint64_t revision{ 0 };
+        bool valid{ false };
+        std::vector<vk::CommandBuffer> buffers{};
+    };
+    std::array<ViewCache, MAX_FRAMES_IN_FLIGHT> _viewCaches{};
     std::array<vk::Semaphore, MAX_FRAMES_IN_FLIGHT> _imageAvailableSemaphores;
     std::array<vk::Semaphore, MAX_FRAMES_IN_FLIGHT> _renderFinishedSemaphores;
-    std::array<vk::Fence, MAX_FRAMES_IN_FLIGHT> _drawingFences;
+
+    // Every submission signals the next value of a single timeline semaphore. A frame slot may be reused once the
+    // timeline has reached the value its last submission signaled
+    vk::Semaphore _frameTimeline;
+    uint64_t _frameTimelineValue{ 0 };
+    std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> _frameTimelineValues{};
+
+    // Input marked but not yet submitted, and the timeline value of the submission that first reflects it
+    using Clock = std::chrono::steady_clock;
+    std::optional<Clock::time_point> _pendingInput{};
+    std::optional<std::pair<Clock::time_point, uint64_t>> _submittedInput{};
+    float _inputLatency{ 0.0f };
 
     // Which in-flight frame we are current at (frame index)
     uint32_t _currentFrame{ 0 };
@@ -71,6 +188,31 @@ private:
         vk::ClearDepthStencilValue{ /* depth */ 1.0f, /* stencil */ 0 },  // for the depth/stencil attachment
     };
 
+    // Each in-flight frame writes its timestamps to its own query pool. The pool is read back right after the frame's
+    // timeline value is waited on in beginFrame, at which point all its queries are guaranteed to have completed
+    static constexpr uint32_t MAX_TIMESTAMP_QUERIES = 128;
+    static constexpr uint32_t FRAME_BEGIN_QUERY = 0;
+    static constexpr uint32_t FRAME_END_QUERY = 1;
+    static constexpr uint32_t VIEW_BEGIN_QUERY = 2;
+    static constexpr uint32_t VIEW_END_QUERY = 3;
+    static constexpr uint32_t OVERLAY_BEGIN_QUERY = 4;
+    static constexpr uint32_t OVERLAY_END_QUERY = 5;
+    static constexpr uint32_t FIRST_DRAWABLE_QUERY = 6;
+
+    void resetTimestamps();
+    void writeTimestamp(const vk::CommandBuffer& commandBuffer, vk::PipelineStageFlagBits stage, uint32_t query) const;
+    void collectTimestamps();
+
+    std::array<vk::QueryPool, MAX_FRAMES_IN_FLIGHT> _timestampQueryPools{};
+    std::array<uint32_t, MAX_FRAMES_IN_FLIGHT> _timestampQueryCounts{};
+    std::array<std::vector<std::string>, MAX_FRAMES_IN_FLIGHT> _timedDrawables{};
+
+    // Nanoseconds per timestamp tick, zero when timestamps are not supported on the graphics queue
+    float _timestampPeriod;
+    uint64_t _timestampMask;
+
+    GpuTimings _gpuTimings{};
+
     // Would be better if we have an "internal" access specifier
     friend class Engine;
 };
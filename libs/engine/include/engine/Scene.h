@@ -1,14 +1,42 @@
 #pragma once
 
+#include <glm/glm.hpp>
+
+#include <cstdint>
 #include <functional>
 #include <memory>
-#include <unordered_set>
+#include <vector>
 
 
 class Composable;
+class Drawable;
+class Transformable;
+
 
 class Scene final {
 public:
+    /**
+     * A compact entry of a Scene's render queue. Drawables are flattened into one record per primitive, while any
+     * other composable, such as a ShadingGroup, gets a single record and takes care of recording its own subtree.
+     */
+    struct DrawRecord {
+        // Orders records by pipeline, then shader instance, then vertex buffer so that consecutive draws share as
+        // much command buffer state as possible. Composables recording themselves sort last
+        uint64_t sortKey;
+
+        // The top-level composable this record descends from
+        const Composable* root;
+
+        // Either drawable is set and primitive tells which of its primitives to draw, or composable is set
+        const Drawable* drawable;
+        uint32_t primitive;
+        const Composable* composable;
+
+        // Index of the cached world transform to draw with. For a self-recording composable, this is the world
+        // transform of its parent since its own local transform gets applied while recording
+        uint32_t transform;
+    };
+
     [[nodiscard]] static std::shared_ptr<Scene> create();
 
     void insert(const std::shared_ptr<Composable>& composable);
@@ -16,10 +44,42 @@ public:
 
     void forEach(const std::function<void(const std::shared_ptr<Composable>&)>& f) const;
 
+    /**
+     * Returns this scene flattened into draw records, sorted by DrawRecord::sortKey. The queue is only rebuilt after
+     * composables have been inserted, removed, attached or detached anywhere in the engine. When only transforms
+     * have changed, the cached world transforms are refreshed in a single pass instead.
+     *
+     * @return The sorted render queue, valid until the next call.
+     */
+    [[nodiscard]] const std::vector<DrawRecord>& getRenderQueue();
+
+    /**
+     * @param index The DrawRecord::transform of a record from the current render queue.
+     * @return The cached world transform at the index.
+     */
+    [[nodiscard]] const glm::mat4& getWorldTransform(uint32_t index) const;
+
     Scene() = default;
     Scene(const Scene&) = delete;
     Scene& operator=(const Scene&) = delete;
 
 private:
-    std::unordered_set<std::shared_ptr<Composable>> _composables{};
+    void rebuildRenderQueue();
+    void refreshWorldTransforms();
+    void flatten(const std::shared_ptr<Composable>& composable, const Composable* root, uint32_t parentTransform);
+
+    // Kept in insertion order, which also breaks ties between records of equal sort keys
+    std::vector<std::shared_ptr<Composable>> _composables{};
+
+    std::vector<DrawRecord> _renderQueue{};
+
+    // World transforms are laid out so that parents always come before their children, index 0 being the identity.
+    // A refresh is then a single linear pass: world[i] = world[parent[i]] * local[i]
+    std::vector<const Transformable*> _transformables{};
+    std::vector<uint32_t> _transformParents{};
+    std::vector<glm::mat4> _worldTransforms{};
+
+    // Revisions the render queue and world transforms were last built at, see RenderRevision
+    uint64_t _structureRevision{ UINT64_MAX };
+    uint64_t _transformRevision{ UINT64_MAX };
 };
@@ -3,9 +3,12 @@
 #include <vulkan/vulkan.hpp>
 #include <plog/Log.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <type_traits>
 #include <vector>
 
 
@@ -42,6 +45,34 @@ public:
             return *static_cast<T*>(this);
         }
 
+        /**
+         * Sets the value of a specialization constant, declared in GLSL as layout(constant_id = id) const. The value
+         * gets baked into the pipeline when it is built, so the driver compiles it like a literal: loops bounded by
+         * a specialization constant can be unrolled and branches on one are eliminated. The constant applies to all
+         * stages of the shader, stages not declaring it simply ignore it.
+         *
+         * Building copies of the same Builder with different values gives shader variants sharing the same descriptor
+         * and push constant layout.
+         *
+         * @param constantId The constant_id of the constant in the shader code.
+         * @param value A 32-bit value: int, uint, float or vk::Bool32 for a GLSL bool.
+         * @return this Builder object for chaining calls.
+         */
+        template <typename V> requires (sizeof(V) == sizeof(uint32_t) && std::is_trivially_copyable_v<V>)
+        T& specializationConstant(const uint32_t constantId, const V value) {
+            const auto entry = std::ranges::find(
+                _specializationEntries, constantId, &vk::SpecializationMapEntry::constantID);
+            if (entry != _specializationEntries.end()) {
+                std::memcpy(_specializationData.data() + entry->offset, &value, sizeof(V));
+            } else {
+                const auto offset = static_cast<uint32_t>(_specializationData.size());
+                _specializationData.resize(offset + sizeof(V));
+                std::memcpy(_specializationData.data() + offset, &value, sizeof(V));
+                _specializationEntries.emplace_back(constantId, offset, sizeof(V));
+            }
+            return *static_cast<T*>(this);
+        }
+
         virtual ~Builder() = default;
 
     protected:
@@ -50,11 +81,35 @@ public:
             return *static_cast<T*>(this);
         }
 
+        [[nodiscard]] vk::DescriptorSetLayout createDescriptorSetLayout(const vk::Device& device) const {
+            // Pools must be created for update-after-bind as soon as a single binding is declared with it
+            const auto bindingFlagInfo = vk::DescriptorSetLayoutBindingFlagsCreateInfo{
+                static_cast<uint32_t>(_descriptorBindingFlags.size()), _descriptorBindingFlags.data() };
+            const auto updateAfterBind = std::ranges::any_of(_descriptorBindingFlags, [](const auto flags) {
+                return static_cast<bool>(flags & vk::DescriptorBindingFlagBits::eUpdateAfterBind);
+            });
+            const auto layoutFlags = updateAfterBind
+                ? vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool
+                : vk::DescriptorSetLayoutCreateFlags{};
+            return device.createDescriptorSetLayout({
+                layoutFlags, static_cast<uint32_t>(_descriptorBindings.size()), _descriptorBindings.data(),
+                &bindingFlagInfo });
+        }
+
+        [[nodiscard]] const vk::SpecializationInfo* getSpecializationInfo() {
+            _specializationInfo = vk::SpecializationInfo{
+                static_cast<uint32_t>(_specializationEntries.size()), _specializationEntries.data(),
+                _specializationData.size(), _specializationData.data() };
+            return _specializationEntries.empty() ? nullptr : &_specializationInfo;
+        }
+
         Shader* buildShader(
             const vk::DescriptorSetLayout& descriptorSetLayout,
             const vk::PipelineLayout& pipelineLayout,
             const vk::Pipeline& pipeline) {
-            return new Shader{ descriptorSetLayout, pipelineLayout, pipeline, std::move(_descriptorBindings) };
+            return new Shader{
+                descriptorSetLayout, pipelineLayout, pipeline,
+                std::move(_descriptorBindings), std::move(_descriptorBindingFlags) };
         }
 
         [[nodiscard]] static std::vector<char> readShaderFile(const std::filesystem::path& path) {
@@ -80,6 +135,11 @@ public:
         std::vector<vk::DescriptorSetLayoutBinding> _descriptorBindings{};
         std::vector<vk::DescriptorBindingFlags> _descriptorBindingFlags{};
         std::vector<vk::PushConstantRange> _pushConstantRanges{};
+
+        // Set with specializationConstant, left empty if the shader has none
+        std::vector<vk::SpecializationMapEntry> _specializationEntries{};
+        std::vector<std::byte> _specializationData{};
+        vk::SpecializationInfo _specializationInfo{};
     };
 
     Shader(const Shader&) = delete;
@@ -93,6 +153,8 @@ public:
     [[nodiscard]] vk::PipelineLayout getNativePipelineLayout() const;
     [[nodiscard]] vk::Pipeline getNativePipeline() const;
 
+    [[nodiscard]] vk::DescriptorBindingFlags getDescriptorBindingFlags(uint32_t binding) const;
+
     [[nodiscard]] static vk::ShaderStageFlags getNativeShaderStage(Stage stage);
 
 private:
@@ -100,7 +162,8 @@ private:
         const vk::DescriptorSetLayout& descriptorSetLayout,
         const vk::PipelineLayout& pipelineLayout,
         const vk::Pipeline& pipeline,
-        std::vector<vk::DescriptorSetLayoutBinding>&& descriptorBindings);
+        std::vector<vk::DescriptorSetLayoutBinding>&& descriptorBindings,
+        std::vector<vk::DescriptorBindingFlags>&& descriptorBindingFlags);
 
     vk::DescriptorSetLayout _descriptorSetLayout;
     vk::PipelineLayout _pipelineLayout;
@@ -108,4 +171,7 @@ private:
 
     // We need binding information to create ShaderInstance
     std::vector<vk::DescriptorSetLayoutBinding> _descriptorBindings;
+
+    // Tells ShaderInstance which bindings can be updated without invalidating recorded command buffers
+    std::vector<vk::DescriptorBindingFlags> _descriptorBindingFlags;
 };
@@ -26,22 +26,49 @@ public:
 
     void setDescriptor(uint32_t binding, const UniformBuffer* uniformBuffer, const Engine& engine) const;
     void setDescriptor(uint32_t binding, const std::vector<StorageBuffer*>& buffers, const Engine& engine) const;
+
+    /**
+     * Writes a single element of a storage buffer array, in the descriptor sets of all in-flight frames, leaving the
+     * other elements untouched. Like UniformBuffer::setData without a frame index, this must NOT be called inside the
+     * main render loop.
+     *
+     * If the binding was declared with vk::DescriptorBindingFlagBits::eUpdateAfterBind, recorded drawing commands
+     * remain valid and the Renderer keeps reusing them. Otherwise, they get recorded again on the next frame.
+     *
+     * @param binding The binding of the storage buffer array.
+     * @param arrayElement The index of the element to write.
+     * @param buffer The storage buffer to bind at that element.
+     * @param engine The Engine the ShaderInstance was created with.
+     */
+    void setDescriptor(uint32_t binding, uint32_t arrayElement, const StorageBuffer* buffer, const Engine& engine) const;
+
+    /**
+     * Writes a single element of a storage buffer array in the descriptor set of one frame only. Intended to be
+     * called from the callback of Renderer::render, for every frame index in turn, when swapping buffers while
+     * rendering: the descriptor set of the provided frame index is no longer in use by the GPU at that point.
+     *
+     * @param frameIndex The frame index provided by the callback of Renderer::render.
+     */
+    void setDescriptor(
+        uint32_t frameIndex, uint32_t binding, uint32_t arrayElement, const StorageBuffer* buffer,
+        const Engine& engine) const;
     void setDescriptor(uint32_t binding, const std::shared_ptr<Texture>& texture, const std::unique_ptr<Sampler>& sampler, const Engine& engine) const;
 
     [[nodiscard]] const Shader* getShader() const;
 
-    [[nodiscard]] vk::DescriptorPool getNativeDescriptorPool() const;
     [[nodiscard]] const vk::DescriptorSet& getNativeDescriptorSetAt(uint32_t frame) const;
     [[nodiscard]] const std::array<vk::DescriptorSet, Renderer::getMaxFramesInFlight()>& getNativeDescriptorSets() const;
 
 private:
     ShaderInstance(
         const Shader* shader,
-        const vk::DescriptorPool& descriptorPool,
         const std::array<vk::DescriptorSet, Renderer::getMaxFramesInFlight()>& descriptorSets);
 
+    // Recorded drawing commands referring to our descriptor sets are invalidated by any write, except to bindings
+    // declared with UPDATE_AFTER_BIND
+    void invalidate(uint32_t binding) const;
+
     const Shader* _shader;
-    vk::DescriptorPool _descriptorPool;
 
     std::array<vk::DescriptorSet, Renderer::getMaxFramesInFlight()> _descriptorSets;
 };
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "engine/Transformable.h"
+
+#include <memory>
+#include <vector>
+
+
+class Engine;
+class Shader;
+class SwapChain;
+class WorkerPool;
+
+
+/**
+ * A ShadingGroup gathers Drawables sharing the same Shader. Its children are split across a set of worker threads,
+ * each recording its share into its own secondary command buffer with the group's pipeline bound once. The buffers
+ * are handed back to the Renderer, which executes them from the frame's primary command buffer.
+ *
+ * Children of a ShadingGroup are recorded without their own descendants, so they should be leaves. Every
+ * ShadingGroup must be destroyed with Engine::destroyShadingGroup prior to Engine::destroy.
+ */
+class ShadingGroup final : public Transformable {
+public:
+    class Builder {
+    public:
+        Builder& shader(const Shader* shader);
+
+        /**
+         * Sets the number of worker threads recording this group. Defaults to the hardware concurrency, capped
+         * at MAX_THREAD_COUNT.
+         */
+        Builder& threadCount(uint32_t count);
+
+        [[nodiscard]] std::shared_ptr<ShadingGroup> build(const Engine& engine, const SwapChain& swapChain);
+
+    private:
+        const Shader* _shader{ nullptr };
+        uint32_t _threadCount{ 0 };
+    };
+
+    static constexpr uint32_t MAX_THREAD_COUNT = 8;
+
+    [[nodiscard]] std::vector<vk::CommandBuffer> recordDrawingCommands(
+        uint32_t frameIndex,
+        const vk::CommandBuffer& commandBuffer,
+        DrawState& state,
+        const vk::CommandBufferInheritanceInfo& inheritanceInfo,
+        const glm::mat4& cameraMatrix,
+        const glm::mat4& currentTransform,
+        const std::function<void(const vk::CommandBuffer&)>& onPipelineBound) const override;
+
+    void recordDrawingCommands(
+        uint32_t frameIndex,
+        const vk::CommandBuffer& commandBuffer,
+        DrawState& state,
+        const glm::mat4& cameraMatrix,
+        const glm::mat4& currentTransform) const override;
+
+    ShadingGroup(
+        const Shader* shader,
+        const vk::Device& device,
+        std::vector<vk::CommandPool>&& commandPools,
+        std::vector<vk::CommandBuffer>&& commandBuffers,
+        uint32_t threadCount);
+
+    ~ShadingGroup() override;
+
+private:
+    void bindPipeline(const vk::CommandBuffer& commandBuffer, DrawState& state) const;
+
+    const Shader* _shader;
+    vk::Device _device;
+    uint32_t _threadCount;
+
+    // One command pool and one secondary command buffer per worker thread and in-flight frame, stored at
+    // [frameIndex * _threadCount + workerIndex]. A command pool must never be used from two threads at once,
+    // giving each worker its own pool spares us any locking while recording.
+    std::vector<vk::CommandPool> _commandPools;
+    std::vector<vk::CommandBuffer> _commandBuffers;
+
+    std::unique_ptr<WorkerPool> _workerPool;
+
+    friend class Engine;
+};
@@ -9,18 +9,82 @@ public:
     public:
         Builder& byteSize(std::size_t size);
 
+        /**
+         * Makes the buffer accessible from shaders through a 64-bit pointer, see getDeviceAddress. Such a buffer is
+         * meant to be read with GL_EXT_buffer_reference rather than through a descriptor, and may therefore exceed
+         * the maximum storage buffer range.
+         *
+         * @return this Builder object for chaining calls.
+         */
+        Builder& deviceAddress();
+
+        /**
+         * Lets the buffer be accessed from the graphics and the compute queue at the same time, without transferring
+         * its ownership between queue families. Intended for inputs shared by rendering and compute jobs, such as a
+         * spectral cube. Outputs of compute jobs are better left exclusive and handed over by the ComputeQueue.
+         *
+         * Has no effect if compute work goes to the graphics queue family anyway.
+         *
+         * @return this Builder object for chaining calls.
+         */
+        Builder& concurrent();
+
+        /**
+         * Places the buffer in persistently mapped memory the host can read efficiently, so that results written by
+         * shaders can be read back with getData. Meant for small outputs such as statistics, as such memory is
+         * usually slower for the device to access.
+         *
+         * @return this Builder object for chaining calls.
+         */
+        Builder& hostReadable();
+
         [[nodiscard]] StorageBuffer* build(const Engine& engine) const;
 
     private:
         std::size_t _bufferSize{ 0 };
+        bool _deviceAddress{ false };
+        bool _concurrent{ false };
+        bool _hostReadable{ false };
     };
 
     void setData(const void* data, const Engine& engine) const;
 
-    [[nodiscard]] uint32_t getBufferSize() const;
+    /**
+     * Uploads data to a sub-range of this buffer, leaving the rest untouched. Lets a large buffer be streamed in
+     * pieces without ever staging all of it at once.
+     *
+     * @param data The data to upload.
+     * @param byteOffset Where the data goes in this buffer.
+     * @param byteSize The byte size of the data.
+     * @param engine The Engine the buffer was built with.
+     */
+    void setData(const void* data, std::size_t byteOffset, std::size_t byteSize, const Engine& engine) const;
+
+    /**
+     * Reads back the start of a buffer built with hostReadable. Whatever wrote the data must have completed and
+     * made its writes available to the host, as compute jobs of a ComputeQueue do.
+     *
+     * @param data Where the data is copied to.
+     * @param byteSize How many bytes to read, from the start of this buffer.
+     * @param engine The Engine the buffer was built with.
+     */
+    void getData(void* data, std::size_t byteSize, const Engine& engine) const;
+
+    [[nodiscard]] std::size_t getBufferSize() const;
+
+    /**
+     * @return The address of this buffer for shaders to read it through, or 0 if it wasn't built with deviceAddress.
+     */
+    [[nodiscard]] vk::DeviceAddress getDeviceAddress() const;
 
 private:
-    StorageBuffer(std::size_t bufferSize, const vk::Buffer& buffer, void* allocation);
+    StorageBuffer(
+        std::size_t bufferSize,
+        const vk::Buffer& buffer,
+        void* allocation,
+        vk::DeviceAddress address,
+        std::byte* pMappedData);
 
     std::size_t _bufferSize;
+    vk::DeviceAddress _deviceAddress;
 };
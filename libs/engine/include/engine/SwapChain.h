@@ -30,6 +30,28 @@ public:
         x64,
     };
 
+    /**
+     * How presented images are queued for display, trading latency against tearing and power usage.
+     */
+    enum class PresentMode {
+        Fifo,       // v-synced queue, never tears, lowest power, up to a few frames of latency
+        Mailbox,    // v-synced but always shows the newest image, low latency at the cost of rendering unshown frames
+        Immediate,  // no v-sync, lowest latency but may tear
+    };
+
+    /**
+     * Requests a present mode, which takes effect when the native swap chain gets recreated after the next present.
+     * A mode the surface doesn't support falls back to Mailbox, then to Fifo which is always supported.
+     *
+     * @param mode The present mode to request.
+     */
+    void setPresentMode(PresentMode mode);
+
+    /**
+     * @return The present mode the native swap chain was actually created with.
+     */
+    [[nodiscard]] PresentMode getPresentMode() const;
+
     void setOnFramebufferResize(const std::function<void(uint32_t, uint32_t)>& callback);
     void setOnFramebufferResize(std::function<void(uint32_t, uint32_t)>&& callback) noexcept;
 
@@ -73,10 +95,10 @@ private:
 
     // Helpful static methods
     using SurfaceFormat = vk::SurfaceFormatKHR;
-    using PresentMode = vk::PresentModeKHR;
     using SurfaceCapabilities = vk::SurfaceCapabilitiesKHR;
     [[nodiscard]] static SurfaceFormat chooseSwapSurfaceFormat(const std::vector<SurfaceFormat>& availableFormats);
-    [[nodiscard]] static PresentMode chooseSwapPresentMode(const std::vector<PresentMode>& availablePresentModes);
+    [[nodiscard]] static vk::PresentModeKHR chooseSwapPresentMode(
+        const std::vector<vk::PresentModeKHR>& availablePresentModes, PresentMode requestedMode);
     [[nodiscard]] static vk::Extent2D chooseSwapExtent(const SurfaceCapabilities& capabilities, GLFWwindow* window);
     [[nodiscard]] static vk::SampleCountFlagBits getSampleCount(MSAA msaaLevel);
     [[nodiscard]] static vk::SampleCountFlagBits getOrFallbackSampleCount(MSAA level, vk::SampleCountFlagBits maxSampleCount);
@@ -88,6 +110,11 @@ private:
     std::function<void(uint32_t, uint32_t)> _customFramebufferResizeCallback{ [](uint32_t, uint32_t) {} };
     static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
 
+    // Mailbox by default, changing it recreates the native swap chain after the next present
+    PresentMode _requestedPresentMode{ PresentMode::Mailbox };
+    vk::PresentModeKHR _presentMode{ vk::PresentModeKHR::eFifo };
+    bool _presentModeChanged{ false };
+
     vk::PhysicalDevice _physicalDevice;
     std::optional<uint32_t> _graphicsFamily;
     std::optional<uint32_t> _presentFamily;
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+
+
+/**
+ * Collects CPU-side timing scopes and exports them in the Chrome trace event format, which can be opened with
+ * chrome://tracing or https://ui.perfetto.dev. Tracing is disabled until Trace::start is called, in which case
+ * a Trace::Scope costs no more than a relaxed atomic load.
+ */
+class Trace final {
+public:
+    /**
+     * Enables tracing. Events are kept in memory and only written out to the specified file by Trace::stop.
+     *
+     * @param path The file to write the trace to.
+     */
+    static void start(const std::filesystem::path& path);
+
+    /**
+     * Disables tracing and writes all events recorded so far to the file specified in Trace::start.
+     */
+    static void stop();
+
+    [[nodiscard]] static bool enabled() noexcept;
+
+    /**
+     * Records a complete event spanning the lifetime of this object. The name and category must outlive the trace,
+     * string literals are what they are meant for.
+     */
+    class Scope final {
+    public:
+        explicit Scope(const char* name, const char* category = "engine") noexcept;
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* _name;
+        const char* _category;
+        std::chrono::steady_clock::time_point _begin{};
+    };
+
+private:
+    static void record(
+        const char* name, const char* category,
+        std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+};
@@ -9,6 +9,7 @@ class Transformable : public Composable {
 public:
     void setTransform(const glm::mat4& transform);
     void setTransform(glm::mat4&& transform) noexcept;
+    [[nodiscard]] const glm::mat4& getTransform() const noexcept;
 
     Transformable(const Transformable&) = delete;
     Transformable& operator=(const Transformable&) = delete;
@@ -133,6 +133,9 @@ public:
     private:
         static vk::Format getFormat(AttributeFormat format);
 
+        // Shares the attribute format mapping
+        friend class InstanceBuffer;
+
         std::vector<VkVertexInputBindingDescription2EXT> _bindings{};
         std::vector<VkVertexInputAttributeDescription2EXT> _attributes{};
 
@@ -153,6 +156,12 @@ public:
     [[nodiscard]] const std::vector<VkVertexInputAttributeDescription2EXT>& getAttributeDescriptions() const;
     [[nodiscard]] const std::vector<vk::DeviceSize>& getOffsets() const;
 
+    /**
+     * Returns the native buffer repeated once per binding, ready to be passed along with getOffsets to
+     * vkCmdBindVertexBuffers without building a new array for every draw.
+     */
+    [[nodiscard]] const std::vector<vk::Buffer>& getNativeBuffers() const;
+
     VertexBuffer(const VertexBuffer&) = delete;
     VertexBuffer& operator=(const VertexBuffer&) = delete;
 
@@ -168,6 +177,7 @@ private:
     std::vector<VkVertexInputBindingDescription2EXT> _bindingDescriptions;
     std::vector<VkVertexInputAttributeDescription2EXT> _attributeDescriptions;
     std::vector<vk::DeviceSize> _offsets;
+    std::vector<vk::Buffer> _nativeBuffers;
 
     uint32_t _vertexCount;
 };
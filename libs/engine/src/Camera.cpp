@@ -1,5 +1,7 @@
 #include "engine/Camera.h"
 
+#include "RenderRevision.h"
+
 #include <glm/gtc/matrix_transform.hpp>
 
 
@@ -14,6 +16,7 @@ void Camera::setLookAt(const glm::vec3& position, const glm::vec3& target, const
 void Camera::setLookAt(const glm::mat4& view) {
     _view = view;
     _cameraMatrix = _proj * _view;
+    RenderRevision::bump();
 }
 
 void Camera::setProjection(const float left, const float right, const float top, const float bottom, const float near, const float far) {
@@ -32,6 +35,7 @@ void Camera::setProjection(const float fov, const float aspect, const float near
 void Camera::setProjection(const glm::mat4& proj) {
     _proj = proj;
     _cameraMatrix = _proj * _view;
+    RenderRevision::bump();
 }
 
 const glm::mat4& Camera::getCameraMatrix() const & {
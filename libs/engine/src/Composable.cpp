@@ -1,5 +1,7 @@
 #include "engine/Composable.h"
 
+#include "RenderRevision.h"
+
 #include <algorithm>
 
 
@@ -13,6 +15,7 @@ void Composable::attach(const std::shared_ptr<Composable>& child) {
     if (child.get() != this && !child->attached()) {
         child->_parent = shared_from_this();
         _children.insert(child);
+        RenderRevision::bumpStructure();
     }
 }
 
@@ -21,6 +24,7 @@ void Composable::detach(const std::shared_ptr<Composable>& child) noexcept {
     if (hasChild(child)) {
         child->_parent.reset();
         _children.erase(child);
+        RenderRevision::bumpStructure();
     }
 }
 
@@ -40,6 +44,19 @@ bool Composable::hasChild(const std::shared_ptr<Composable>& child) const noexce
     return _children.contains(child);
 }
 
+const std::unordered_set<std::shared_ptr<Composable>>& Composable::getChildren() const noexcept {
+    return _children;
+}
+
+void Composable::setName(const std::string_view name) {
+    _name = name;
+    RenderRevision::bump();
+}
+
+const std::string& Composable::getName() const noexcept {
+    return _name;
+}
+
 Composable::~Composable() {
     if (attached()) {
         _parent.lock()->detach(shared_from_this());
@@ -0,0 +1,171 @@
+#include "engine/ComputeQueue.h"
+#include "engine/Shader.h"
+#include "engine/ShaderInstance.h"
+#include "engine/StorageBuffer.h"
+#include "engine/Trace.h"
+
+#include <plog/Log.h>
+
+#include <limits>
+#include <ranges>
+
+
+ComputeQueue::ComputeQueue(
+    const vk::Device& device,
+    const vk::Queue& computeQueue,
+    const uint32_t computeFamily,
+    const vk::Queue& graphicsQueue,
+    const uint32_t graphicsFamily
+) : _device{ device },
+    _computeQueue{ computeQueue },
+    _computeFamily{ computeFamily },
+    _graphicsQueue{ graphicsQueue },
+    _graphicsFamily{ graphicsFamily } {
+    // Command buffers are recorded once per job and freed when it retires
+    _computeCommandPool = _device.createCommandPool({ vk::CommandPoolCreateFlagBits::eTransient, _computeFamily });
+    _graphicsCommandPool = _device.createCommandPool({ vk::CommandPoolCreateFlagBits::eTransient, _graphicsFamily });
+
+    const auto timelineInfo = vk::SemaphoreTypeCreateInfo{ vk::SemaphoreType::eTimeline, 0 };
+    _computeTimeline = _device.createSemaphore({ {}, &timelineInfo });
+    _graphicsTimeline = _device.createSemaphore({ {}, &timelineInfo });
+}
+
+uint64_t ComputeQueue::dispatch(
+    const ShaderInstance* const instance,
+    const uint32_t groupCountX,
+    const uint32_t groupCountY,
+    const uint32_t groupCountZ,
+    const void* const pushConstants,
+    const uint32_t pushConstantSize,
+    const std::vector<const StorageBuffer*>& outputs
+) {
+    const auto scope = Trace::Scope{ "Dispatch compute job" };
+    retire();
+
+    const auto allocInfo = vk::CommandBufferAllocateInfo{ _computeCommandPool, vk::CommandBufferLevel::ePrimary, 1 };
+    const auto commandBuffer = _device.allocateCommandBuffers(allocInfo)[0];
+    commandBuffer.begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+    const auto shader = instance->getShader();
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, shader->getNativePipeline());
+    commandBuffer.bindDescriptorSets(
+        vk::PipelineBindPoint::eCompute, shader->getNativePipelineLayout(), 0, instance->getNativeDescriptorSetAt(0), {});
+    if (pushConstants != nullptr && pushConstantSize > 0) {
+        commandBuffer.pushConstants(
+            shader->getNativePipelineLayout(), vk::ShaderStageFlagBits::eCompute, 0, pushConstantSize, pushConstants);
+    }
+    commandBuffer.dispatch(groupCountX, groupCountY, groupCountZ);
+
+    // Later jobs on this queue see what this one wrote. Sharing the graphics queue, so do later frames since a
+    // barrier covers every command submitted after it. The host sees it too once the job's ticket has been reached,
+    // signaling a semaphore alone doesn't make writes available to the host
+    using Stage = vk::PipelineStageFlagBits;
+    const auto dstStages = isAsync()
+        ? Stage::eComputeShader | Stage::eHost
+        : Stage::eComputeShader | Stage::eVertexShader | Stage::eFragmentShader | Stage::eHost;
+    const auto memoryBarrier = vk::MemoryBarrier{
+        vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eHostRead };
+    commandBuffer.pipelineBarrier(Stage::eComputeShader, dstStages, {}, memoryBarrier, {}, {});
+
+    // On a dedicated family, the outputs are released to the graphics family. The matching acquire is submitted to
+    // the graphics queue by isComplete, the destination stage and access mask are ignored here
+    auto outputBuffers = outputs | std::views::transform(&StorageBuffer::getNativeBuffer) | std::ranges::to<std::vector>();
+    if (isAsync() && !outputBuffers.empty()) {
+        const auto releaseBarriers = outputBuffers | std::views::transform([this](const auto& buffer) {
+            return vk::BufferMemoryBarrier{
+                vk::AccessFlagBits::eShaderWrite, {}, _computeFamily, _graphicsFamily, buffer, 0, vk::WholeSize };
+        }) | std::ranges::to<std::vector>();
+        commandBuffer.pipelineBarrier(Stage::eComputeShader, Stage::eBottomOfPipe, {}, {}, releaseBarriers, {});
+    }
+
+    commandBuffer.end();
+
+    // Signal the job's ticket on the compute timeline once it has finished
+    const auto ticket = ++_ticket;
+    const auto timelineSubmitInfo = vk::TimelineSemaphoreSubmitInfo{ 0, nullptr, 1, &ticket };
+    const auto submitInfo = vk::SubmitInfo{ 0, nullptr, nullptr, 1, &commandBuffer, 1, &_computeTimeline, &timelineSubmitInfo };
+    _computeQueue.submit(submitInfo);
+
+    _jobs.push_back({ ticket, commandBuffer, {}, std::move(outputBuffers) });
+    return ticket;
+}
+
+bool ComputeQueue::isComplete(const uint64_t ticket) {
+    if (ticket <= _acquiredTicket) return true;
+
+    const auto completed = _device.getSemaphoreCounterValue(_computeTimeline);
+    if (completed < ticket) return false;
+
+    // Hand over the outputs of every job finished so far, not just the one asked about
+    acquire(completed);
+    retire();
+    return true;
+}
+
+void ComputeQueue::wait(const uint64_t ticket) const {
+    const auto waitInfo = vk::SemaphoreWaitInfo{ {}, 1, &_computeTimeline, &ticket };
+    [[maybe_unused]] const auto result = _device.waitSemaphores(waitInfo, std::numeric_limits<uint64_t>::max());
+}
+
+bool ComputeQueue::isAsync() const noexcept {
+    return _computeFamily != _graphicsFamily;
+}
+
+void ComputeQueue::acquire(const uint64_t ticket) {
+    const auto first = _acquiredTicket;
+    _acquiredTicket = ticket;
+    if (!isAsync()) return;
+
+    // Each released buffer must be acquired with a barrier matching the release, readable from any shader stage.
+    // Jobs with outputs are never retired before being acquired, the last of them keeps the acquire command buffer
+    auto acquireBarriers = std::vector<vk::BufferMemoryBarrier>{};
+    auto owner = static_cast<Job*>(nullptr);
+    for (auto& job : _jobs) {
+        if (job.ticket <= first || job.ticket > ticket || job.outputs.empty()) continue;
+        for (const auto& buffer : job.outputs) {
+            acquireBarriers.emplace_back(
+                vk::AccessFlags{}, vk::AccessFlagBits::eShaderRead, _computeFamily, _graphicsFamily,
+                buffer, 0, vk::WholeSize);
+        }
+        owner = &job;
+    }
+    if (owner == nullptr) return;
+
+    const auto allocInfo = vk::CommandBufferAllocateInfo{ _graphicsCommandPool, vk::CommandBufferLevel::ePrimary, 1 };
+    const auto commandBuffer = _device.allocateCommandBuffers(allocInfo)[0];
+    commandBuffer.begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+    using Stage = vk::PipelineStageFlagBits;
+    commandBuffer.pipelineBarrier(
+        Stage::eTopOfPipe, Stage::eVertexShader | Stage::eFragmentShader | Stage::eComputeShader, {},
+        {}, acquireBarriers, {});
+    commandBuffer.end();
+
+    // The release has already executed, but waiting on it is what orders the acquire after it. Frames submitted
+    // after this point execute after the acquire barrier, which is all that rendering needs
+    const auto waitStage = vk::PipelineStageFlags{ Stage::eTopOfPipe };
+    const auto timelineSubmitInfo = vk::TimelineSemaphoreSubmitInfo{ 1, &ticket, 1, &ticket };
+    const auto submitInfo = vk::SubmitInfo{
+        1, &_computeTimeline, &waitStage, 1, &commandBuffer, 1, &_graphicsTimeline, &timelineSubmitInfo };
+    _graphicsQueue.submit(submitInfo);
+
+    owner->acquireBuffer = commandBuffer;
+}
+
+void ComputeQueue::retire() {
+    const auto computeCompleted = _device.getSemaphoreCounterValue(_computeTimeline);
+    const auto graphicsCompleted = _device.getSemaphoreCounterValue(_graphicsTimeline);
+
+    while (!_jobs.empty()) {
+        const auto& job = _jobs.front();
+        // Jobs retire in order: once finished, and once their outputs have been acquired if there is anything to acquire
+        if (job.ticket > computeCompleted || (job.acquireBuffer && job.ticket > graphicsCompleted)) break;
+        if (isAsync() && !job.outputs.empty() && job.ticket > _acquiredTicket) break;
+
+        _device.freeCommandBuffers(_computeCommandPool, job.computeBuffer);
+        if (job.acquireBuffer) {
+            _device.freeCommandBuffers(_graphicsCommandPool, job.acquireBuffer);
+        }
+        _jobs.pop_front();
+    }
+}
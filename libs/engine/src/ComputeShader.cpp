@@ -1,4 +1,7 @@
 #include "engine/ComputeShader.h"
+#include "engine/Engine.h"
+
+#include <plog/Log.h>
 
 
 ComputeShader::Builder& ComputeShader::Builder::computeShader(const std::filesystem::path& path, std::string entryPoint) {
@@ -7,6 +10,43 @@ ComputeShader::Builder& ComputeShader::Builder::computeShader(const std::filesys
     return *this;
 }
 
+ComputeShader::Builder& ComputeShader::Builder::pushConstantSize(const uint32_t byteSize) {
+    if (byteSize == 0 || !_pushConstantRanges.empty()) {
+        PLOGE << "Received a zero-sized or a second push constant block for a compute shader";
+        throw std::invalid_argument("A compute shader takes a single, non-empty push constant block");
+    }
+    return pushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, byteSize);
+}
+
 Shader* ComputeShader::Builder::build(const Engine& engine) {
-    return nullptr;
+    if (_shaderCode.empty()) {
+        PLOGE << "Creating a compute pipeline with an empty compute shader";
+        throw std::runtime_error("A compute pipeline must have a compute shader");
+    }
+
+    // Ensure that the push constant block is within the device's limit
+    if (const auto psLimit = engine.getLimitPushConstantSize();
+        !_pushConstantRanges.empty() && _pushConstantRanges[0].size > psLimit) {
+        PLOGE << "Detected a push constant range whose size exceeds " << psLimit << " bytes";
+        throw std::runtime_error("Push constant range (offset + size) must be less than the allowed limit");
+    }
+
+    // Descriptor set layout and pipeline layout
+    const auto device = engine.getNativeDevice();
+    const auto descriptorSetLayout = createDescriptorSetLayout(device);
+    const auto pipelineLayout = device.createPipelineLayout(
+        { {}, 1, &descriptorSetLayout, static_cast<uint32_t>(_pushConstantRanges.size()), _pushConstantRanges.data() });
+
+    // A compute pipeline has a single stage and no fixed-function state
+    const auto shaderModule = device.createShaderModule(
+        { {}, _shaderCode.size(), reinterpret_cast<const uint32_t*>(_shaderCode.data()) });
+    const auto stage = vk::PipelineShaderStageCreateInfo{
+        {}, vk::ShaderStageFlagBits::eCompute, shaderModule, _shaderEntryPoint.data(), getSpecializationInfo() };
+    const auto pipelineInfo = vk::ComputePipelineCreateInfo{ {}, stage, pipelineLayout };
+    const auto pipeline = device.createComputePipeline(engine.getNativePipelineCache(), pipelineInfo).value;
+
+    // We no longer need the shader module once the pipeline is created
+    device.destroyShaderModule(shaderModule);
+
+    return buildShader(descriptorSetLayout, pipelineLayout, pipeline);
 }
@@ -2,14 +2,33 @@
 
 #include <GLFW/glfw3.h>
 
+#include <atomic>
+#include <optional>
+#include <utility>
+
 
 static std::function<void(double, double)> mMouseClickCallback{ [](auto, auto) {} };
+static std::function<void(double, double, double, double, bool)> mMouseDragCallback{ [](auto, auto, auto, auto, auto) {} };
+
+// Where the ongoing right button drag started, if any
+static std::optional<std::pair<double, double>> mDragOrigin{};
+
+// Frames left to render before an on-demand loop may sleep again, requested from any thread
+static std::atomic_uint32_t mRedrawFrameCount{ 0 };
+
+// Dear ImGui needs a couple of frames after an input to settle, e.g. to update hover states or close popups
+static constexpr uint32_t SETTLE_FRAME_COUNT = 3;
 
-std::unique_ptr<Context> Context::create(const std::string_view name) {
-    return std::unique_ptr<Context>{ new Context(name) };
+static void raiseRedrawFrameCount(const uint32_t frameCount) {
+    auto current = mRedrawFrameCount.load();
+    while (current < frameCount && !mRedrawFrameCount.compare_exchange_weak(current, frameCount)) {}
 }
 
-Context::Context(const std::string_view name) {
+std::unique_ptr<Context> Context::create(const std::string_view name, const bool visible) {
+    return std::unique_ptr<Context>{ new Context(name, visible) };
+}
+
+Context::Context(const std::string_view name, const bool visible) {
     glfwInit();
 
     // Get the primary monitor and the video mode
@@ -17,10 +36,13 @@ Context::Context(const std::string_view name) {
     const auto mode = glfwGetVideoMode(monitor);
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);  // don't create an OpenGL context
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);  // hidden windows serve as offscreen targets
 
     // Create a window and maximize it
     _window = glfwCreateWindow(mode->width, mode->height, name.data(), nullptr, nullptr);
-    glfwMaximizeWindow(_window);
+    if (visible) {
+        glfwMaximizeWindow(_window);
+    }
 
     glfwSetMouseButtonCallback(_window, [](const auto window, const auto button, const auto action, auto mods) {
         if (button == GLFW_MOUSE_BUTTON_LEFT) {
@@ -29,6 +51,22 @@ Context::Context(const std::string_view name) {
                 glfwGetCursorPos(window, &xPos, &yPos);
                 mMouseClickCallback(xPos, yPos);
             }
+        } else if (button == GLFW_MOUSE_BUTTON_RIGHT) {
+            double xPos, yPos;
+            glfwGetCursorPos(window, &xPos, &yPos);
+            if (action == GLFW_PRESS) {
+                mDragOrigin = { xPos, yPos };
+            } else if (action == GLFW_RELEASE && mDragOrigin) {
+                const auto [xOrigin, yOrigin] = *mDragOrigin;
+                mDragOrigin.reset();
+                mMouseDragCallback(xOrigin, yOrigin, xPos, yPos, true);
+            }
+        }
+    });
+
+    glfwSetCursorPosCallback(_window, []([[maybe_unused]] const auto window, const auto xPos, const auto yPos) {
+        if (mDragOrigin) {
+            mMouseDragCallback(mDragOrigin->first, mDragOrigin->second, xPos, yPos, false);
         }
     });
 }
@@ -46,13 +84,53 @@ void Context::setOnMouseClick(std::function<void(double, double)>&& callback) no
     mMouseClickCallback = std::move(callback);
 }
 
+void Context::setOnMouseDrag(const std::function<void(double, double, double, double, bool)>& callback) {
+    mMouseDragCallback = callback;
+}
+
+void Context::setOnMouseDrag(std::function<void(double, double, double, double, bool)>&& callback) noexcept {
+    mMouseDragCallback = std::move(callback);
+}
+
 Surface* Context::getSurface() const {
     return _window;
 }
 
 void Context::loop(const std::function<void()> &onFrame) const {
+    loop([] {}, onFrame);
+}
+
+void Context::setRenderOnDemand(const bool enabled) noexcept {
+    _renderOnDemand = enabled;
+}
+
+bool Context::isRenderOnDemand() const noexcept {
+    return _renderOnDemand;
+}
+
+void Context::requestRedraw(const uint32_t frameCount) {
+    raiseRedrawFrameCount(frameCount);
+
+    // Unblocks glfwWaitEvents on the main thread
+    glfwPostEmptyEvent();
+}
+
+void Context::loop(const std::function<void()>& beforePoll, const std::function<void()>& onFrame) const {
     while (!glfwWindowShouldClose(_window)) {
-        glfwPollEvents();
+        beforePoll();
+
+        // Any event wakes us up, be it input, a resize, the window being exposed, or a posted redraw request
+        if (_renderOnDemand && mRedrawFrameCount.load() == 0) {
+            glfwWaitEvents();
+            raiseRedrawFrameCount(SETTLE_FRAME_COUNT);
+        } else {
+            glfwPollEvents();
+        }
+
         onFrame();
+
+        // Input keeps arriving while rendering, the loop then wakes up right away once the frames are consumed
+        auto current = mRedrawFrameCount.load();
+        while (current > 0 && !mRedrawFrameCount.compare_exchange_weak(current, current - 1)) {}
     }
 }
@@ -2,8 +2,11 @@
 #include "engine/Engine.h"
 #include "engine/ShaderInstance.h"
 #include "engine/IndexBuffer.h"
+#include "engine/InstanceBuffer.h"
 #include "engine/VertexBuffer.h"
 
+#include "RenderRevision.h"
+
 #include <glm/gtc/type_ptr.hpp>
 #include <plog/Log.h>
 
@@ -31,13 +34,29 @@ Drawable::Builder& Drawable::Builder::material(const uint32_t meshIndex, const S
     return *this;
 }
 
+Drawable::Builder& Drawable::Builder::instances(const InstanceBuffer* const buffer) {
+    _instanceBuffer = buffer;
+    return *this;
+}
+
 std::shared_ptr<Drawable> Drawable::Builder::build([[maybe_unused]] const Engine& engine) {
     if (std::ranges::any_of(_shaderInstances, [](const auto it) { return it == nullptr; })) {
         PLOGE << "Constructing a Drawable with missing shader instance(s)";
         throw std::runtime_error("Missing shader instance");
     }
+    if (_instanceBuffer) {
+        const auto instanceBinding = _instanceBuffer->getBindingDescription().binding;
+        const auto collides = [instanceBinding](const Primitive& primitive) {
+            return std::ranges::any_of(primitive.vertexBuffer->getBindingDescriptions(),
+                [instanceBinding](const auto& it) { return it.binding == instanceBinding; });
+        };
+        if (std::ranges::any_of(_primitives, collides)) {
+            PLOGE << "Constructing a Drawable whose instance binding " << instanceBinding << " is used by a vertex buffer";
+            throw std::runtime_error("Colliding instance buffer binding");
+        }
+    }
     const auto func = reinterpret_cast<PFN_vkCmdSetVertexInputEXT>(vkGetInstanceProcAddr(engine.getNativeInstance(), "vkCmdSetVertexInputEXT"));
-    return std::make_shared<Drawable>(std::move(_primitives), std::move(_shaderInstances), func);
+    return std::make_shared<Drawable>(std::move(_primitives), std::move(_shaderInstances), _instanceBuffer, func);
 }
 
 vk::PrimitiveTopology Drawable::Builder::getPrimitiveTopology(const Topology topology) {
@@ -55,76 +74,50 @@ vk::PrimitiveTopology Drawable::Builder::getPrimitiveTopology(const Topology top
 Drawable::Drawable(
     std::vector<Primitive>&& primitives,
     std::vector<const ShaderInstance*>&& shaderInstances,
+    const InstanceBuffer* const instanceBuffer,
     PFN_vkCmdSetVertexInputEXT vkCmdSetVertexInput
 ) : _primitives{ std::move(primitives) },
     _shaderInstances{ shaderInstances },
+    _instanceBuffer{ instanceBuffer },
     _vkCmdSetVertexInput{ vkCmdSetVertexInput } {
+    if (_instanceBuffer == nullptr) return;
+
+    for (const auto& primitive : _primitives) {
+        const auto& instanceAttributes = _instanceBuffer->getAttributeDescriptions();
+        auto input = VertexInput{
+            primitive.vertexBuffer->getBindingDescriptions(), primitive.vertexBuffer->getAttributeDescriptions() };
+        input.bindings.push_back(_instanceBuffer->getBindingDescription());
+        input.attributes.insert(input.attributes.end(), instanceAttributes.begin(), instanceAttributes.end());
+        _instancedVertexInputs.push_back(std::move(input));
+    }
 }
 
 std::vector<vk::CommandBuffer> Drawable::recordDrawingCommands(
     const uint32_t frameIndex,
     const vk::CommandBuffer& commandBuffer,
+    DrawState& state,
+    const vk::CommandBufferInheritanceInfo& inheritanceInfo,
     const glm::mat4& cameraMatrix,
     const glm::mat4& currentTransform,
     const std::function<void(const vk::CommandBuffer&)>& onPipelineBound
 ) const {
     // Propagate down the transform
-    const auto mvp = ModelViewProjection{ cameraMatrix, currentTransform * _localTransform };
+    const auto worldTransform = currentTransform * _localTransform;
 
-    // Draw all primitives specified for this drawable
-    for (std::size_t i = 0; i < _primitives.size(); ++i) {
-        // Bind the graphics pipeline
-        const auto instance = _shaderInstances[i];
-        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, instance->getShader()->getNativePipeline());
-
-        // Tell the renderer it's time to set dynamic states
-        onPipelineBound(commandBuffer);
-
-        // Our turn to record drawing commands
-        const auto& [topology, vertexBuffer, indexBuffer, indexCount, firstIndex, vertexOffset] = _primitives[i];
-
-        // Specify the remaining pipeline dynamic states
-        const auto bindingDescriptions = vertexBuffer->getBindingDescriptions();
-        const auto attributeDescriptions = vertexBuffer->getAttributeDescriptions();
-        _vkCmdSetVertexInput(commandBuffer,
-            static_cast<uint32_t>(bindingDescriptions.size()), bindingDescriptions.data(),
-            static_cast<uint32_t>(attributeDescriptions.size()), attributeDescriptions.data()
-        );
-        commandBuffer.setPrimitiveTopology(topology);
-
-        // We only have a single VkBuffer and bindings are controlled through offsets
-        const auto vertexBuffers = std::vector(vertexBuffer->getBindingDescriptions().size(), vertexBuffer->getNativeBuffer());
-        commandBuffer.bindVertexBuffers(0, vertexBuffers, vertexBuffer->getOffsets());
-
-        // Bind the index buffer
-        commandBuffer.bindIndexBuffer(indexBuffer->getNativeBuffer(), 0, indexBuffer->getNativeIndexType());
-
-        // Set the transform component through push constant
-        // layout(push_constant, std430) uniform ModelViewProjection {
-        //     mat4 cameraMat;
-        //     mat4 transform;
-        // } mvp;
-        commandBuffer.pushConstants(
-            instance->getShader()->getNativePipelineLayout(), vk::ShaderStageFlagBits::eVertex,
-            /* byte offset */ 0, /* byte size */ sizeof(ModelViewProjection), &mvp);
-
-        // Bind descriptor sets
-        commandBuffer.bindDescriptorSets(
-            vk::PipelineBindPoint::eGraphics, instance->getShader()->getNativePipelineLayout(),
-            0, instance->getNativeDescriptorSetAt(frameIndex), {});
-
-        // The official draw call
-        commandBuffer.drawIndexed(indexCount, 1, firstIndex, vertexOffset, 0);
+    // Draw all primitives specified for this drawable, the renderer gets to set dynamic states if it hasn't already
+    for (uint32_t i = 0; i < _primitives.size(); ++i) {
+        recordPrimitive(frameIndex, commandBuffer, state, cameraMatrix, worldTransform, i, &onPipelineBound);
     }
 
     // The return value is meant for ShadingGroup where secondary buffers would be created to record drawing commands
     // and they would be returned to the renderer. For a Drawable, we won't be using any secondary command buffers,
     // but it's possible that this Composable has a ShadingGroup child and we will have to accumulate its buffers.
+    // An empty vector doesn't allocate, so leaf drawables cost nothing here.
     auto buffers = std::vector<vk::CommandBuffer>{};
     for (const auto& composable : _children) {
-        auto childBuffers = composable->recordDrawingCommands(
-            frameIndex, commandBuffer, cameraMatrix, mvp.transform, onPipelineBound);
-        buffers.insert(buffers.end(), std::make_move_iterator(childBuffers.begin()), std::make_move_iterator(childBuffers.end()));
+        const auto childBuffers = composable->recordDrawingCommands(
+            frameIndex, commandBuffer, state, inheritanceInfo, cameraMatrix, worldTransform, onPipelineBound);
+        buffers.insert(buffers.end(), childBuffers.begin(), childBuffers.end());
     }
     return buffers;
 }
@@ -132,43 +125,124 @@ std::vector<vk::CommandBuffer> Drawable::recordDrawingCommands(
 void Drawable::recordDrawingCommands(
     const uint32_t frameIndex,
     const vk::CommandBuffer& commandBuffer,
+    DrawState& state,
     const glm::mat4& cameraMatrix,
     const glm::mat4& currentTransform
 ) const {
     // Propagate down the transform
-    const auto mvp = ModelViewProjection{ cameraMatrix, currentTransform * _localTransform };
+    const auto worldTransform = currentTransform * _localTransform;
 
-    // For this overload, we won't bother binding the graphics pipeline or signaling the renderer to set the
-    // dynamic states. This overload is meant for ShadingGroup where those operations have already happen.
-    for (std::size_t i = 0; i < _primitives.size(); ++i) {
-        const auto& [topology, vertexBuffer, indexBuffer, indexCount, firstIndex, vertexOffset] = _primitives[i];
+    // For this overload, we won't signal the renderer to set the dynamic states. This overload is meant for
+    // ShadingGroup where that has already happened.
+    for (uint32_t i = 0; i < _primitives.size(); ++i) {
+        recordPrimitive(frameIndex, commandBuffer, state, cameraMatrix, worldTransform, i, nullptr);
+    }
+}
 
-        // Specify the remaining pipeline dynamic states
-        const auto bindingDescriptions = vertexBuffer->getBindingDescriptions();
-        const auto attributeDescriptions = vertexBuffer->getAttributeDescriptions();
+void Drawable::recordPrimitive(
+    const uint32_t frameIndex,
+    const vk::CommandBuffer& commandBuffer,
+    DrawState& state,
+    const glm::mat4& cameraMatrix,
+    const glm::mat4& worldTransform,
+    const uint32_t primitive,
+    const std::function<void(const vk::CommandBuffer&)>* const onPipelineBound
+) const {
+    // Every command below is skipped when the command buffer already holds the same state, which is typically the
+    // case for consecutive primitives and drawables sharing a material or a geometry
+    const auto& [topology, vertexBuffer, indexBuffer, indexCount, firstIndex, vertexOffset] = _primitives[primitive];
+    const auto instance = _shaderInstances[primitive];
+    const auto pipeline = instance->getShader()->getNativePipeline();
+    const auto pipelineLayout = instance->getShader()->getNativePipelineLayout();
+
+    // Bind the graphics pipeline. A pipeline with another layout disturbs the bound descriptor set
+    if (pipeline != state.pipeline) {
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+        state.pipeline = pipeline;
+        if (pipelineLayout != state.pipelineLayout) {
+            state.pipelineLayout = pipelineLayout;
+            state.descriptorSet = nullptr;
+        }
+    }
+
+    // Tell the renderer it's time to set dynamic states. All our pipelines share the same dynamic states,
+    // which therefore survive pipeline binds and only need to be set once per command buffer
+    if (onPipelineBound && !state.dynamicStatesSet) {
+        (*onPipelineBound)(commandBuffer);
+        state.dynamicStatesSet = true;
+    }
+
+    // Specify the remaining pipeline dynamic states and bind the vertex buffer. We only have a single VkBuffer
+    // and bindings are controlled through offsets
+    if (vertexBuffer != state.vertexBuffer || _instanceBuffer != state.instanceBuffer) {
+        const auto& bindingDescriptions = _instanceBuffer
+            ? _instancedVertexInputs[primitive].bindings : vertexBuffer->getBindingDescriptions();
+        const auto& attributeDescriptions = _instanceBuffer
+            ? _instancedVertexInputs[primitive].attributes : vertexBuffer->getAttributeDescriptions();
         _vkCmdSetVertexInput(commandBuffer,
             static_cast<uint32_t>(bindingDescriptions.size()), bindingDescriptions.data(),
             static_cast<uint32_t>(attributeDescriptions.size()), attributeDescriptions.data()
         );
+        commandBuffer.bindVertexBuffers(0, vertexBuffer->getNativeBuffers(), vertexBuffer->getOffsets());
+
+        // Each in-flight frame reads its own copy of the instance data
+        if (_instanceBuffer) {
+            commandBuffer.bindVertexBuffers(
+                _instanceBuffer->getBindingDescription().binding,
+                _instanceBuffer->getNativeBuffer(), _instanceBuffer->getOffset(frameIndex));
+        }
+        state.vertexBuffer = vertexBuffer;
+        state.instanceBuffer = _instanceBuffer;
+    }
+    if (topology != state.topology) {
         commandBuffer.setPrimitiveTopology(topology);
+        state.topology = topology;
+    }
 
-        // Bind the vertex and index buffer
-        const auto vertexBuffers = std::vector(vertexBuffer->getBindingDescriptions().size(), vertexBuffer->getNativeBuffer());
-        commandBuffer.bindVertexBuffers(0, vertexBuffers, vertexBuffer->getOffsets());
+    // Bind the index buffer
+    if (indexBuffer != state.indexBuffer) {
         commandBuffer.bindIndexBuffer(indexBuffer->getNativeBuffer(), 0, indexBuffer->getNativeIndexType());
+        state.indexBuffer = indexBuffer;
+    }
 
-        // Transform component
-        const auto instance = _shaderInstances[i];
-        commandBuffer.pushConstants(
-            instance->getShader()->getNativePipelineLayout(), vk::ShaderStageFlagBits::eVertex,
-            /* byte offset */ 0, /* byte size */ sizeof(ModelViewProjection), &mvp);
+    // Set the transform component through push constant
+    // layout(push_constant, std430) uniform ModelViewProjection {
+    //     mat4 cameraMat;
+    //     mat4 transform;
+    // } mvp;
+    const auto mvp = ModelViewProjection{ cameraMatrix, worldTransform };
+    commandBuffer.pushConstants(
+        pipelineLayout, vk::ShaderStageFlagBits::eVertex,
+        /* byte offset */ 0, /* byte size */ sizeof(ModelViewProjection), &mvp);
+
+    // Bind descriptor sets
+    const auto& descriptorSet = instance->getNativeDescriptorSetAt(frameIndex);
+    if (descriptorSet != state.descriptorSet) {
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, descriptorSet, {});
+        state.descriptorSet = descriptorSet;
+    }
 
-        // Descriptor sets
-        commandBuffer.bindDescriptorSets(
-            vk::PipelineBindPoint::eGraphics, instance->getShader()->getNativePipelineLayout(),
-            0, instance->getNativeDescriptorSetAt(frameIndex), {});
+    // The official draw call, drawing all instances at once
+    const auto instanceCount = _instanceBuffer ? _instanceBuffer->getInstanceCount(frameIndex) : 1;
+    commandBuffer.drawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, 0);
+}
 
-        // Issue the draw call
-        commandBuffer.drawIndexed(indexCount, 1, firstIndex, vertexOffset, 0);
-    }
+uint32_t Drawable::getPrimitiveCount() const noexcept {
+    return static_cast<uint32_t>(_primitives.size());
+}
+
+void Drawable::setMaterial(const uint32_t primitive, const ShaderInstance* const instance) {
+    if (_shaderInstances[primitive] == instance) return;
+    _shaderInstances[primitive] = instance;
+
+    // Render queues are sorted by pipeline and shader instance, they must be rebuilt
+    RenderRevision::bumpStructure();
+}
+
+const ShaderInstance* Drawable::getShaderInstanceAt(const uint32_t primitive) const {
+    return _shaderInstances[primitive];
+}
+
+const VertexBuffer* Drawable::getVertexBufferAt(const uint32_t primitive) const {
+    return _primitives[primitive].vertexBuffer;
 }
@@ -1,5 +1,9 @@
 #include "engine/Engine.h"
 
+#include "PipelineCache.h"
+#include "RenderRevision.h"
+
+#include "allocator/DescriptorAllocator.h"
 #include "allocator/ResourceAllocator.h"
 
 #include "bootstrap/DeviceBuilder.h"
@@ -51,11 +55,19 @@ static constexpr std::array mDeviceExtensions{
 };
 
 
-std::unique_ptr<Engine> Engine::create(Surface* const surface, const EngineFeature& feature) {
-    return std::unique_ptr<Engine>(new Engine{ surface, feature });
+std::unique_ptr<Engine> Engine::create(
+    Surface* const surface,
+    const EngineFeature& feature,
+    const std::filesystem::path& pipelineCacheDirectory
+) {
+    return std::unique_ptr<Engine>(new Engine{ surface, feature, pipelineCacheDirectory });
 }
 
-Engine::Engine(GLFWwindow* const window, const EngineFeature& feature) {
+Engine::Engine(
+    GLFWwindow* const window,
+    const EngineFeature& feature,
+    const std::filesystem::path& pipelineCacheDirectory
+) : _pipelineCacheDirectory{ pipelineCacheDirectory } {
     // Create a Vulkan instance
     _instance = InstanceBuilder()
         .applicationName("pan")
@@ -113,11 +125,16 @@ Engine::Engine(GLFWwindow* const window, const EngineFeature& feature) {
         vk::CommandPoolCreateFlagBits::eTransient, _swapChain->_graphicsFamily.value() };
     _transferCommandPool = _device.createCommandPool(transferPoolInfo);
 
+    // Reuse pipelines compiled by previous runs on the same device and driver
+    _pipelineCache = PipelineCache::load(_pipelineCacheDirectory, _swapChain->_physicalDevice, _device);
+
     // Create a resource allocator
     _allocator = ResourceAllocator::Builder()
-        .flags(VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT | VMA_ALLOCATOR_CREATE_EXT_MEMORY_PRIORITY_BIT)
+        .flags(VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT | VMA_ALLOCATOR_CREATE_EXT_MEMORY_PRIORITY_BIT |
+               VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT)
         .vulkanApiVersion(VK_API_VERSION_1_3)
         .build(_instance, _swapChain->_physicalDevice, _device);
+    _descriptorAllocator = new DescriptorAllocator{ _device };
 
     // The physical device features structure were dynamically allocated
     cleanupPhysicalDeviceFeatures(deviceFeatures);
@@ -136,6 +153,7 @@ vk::PhysicalDeviceFeatures2 Engine::getPhysicalDeviceFeatures(const EngineFeatur
     if (feature.samplerAnisotropy) {
         basicFeatures.samplerAnisotropy = vk::True;
     }
+    basicFeatures.shaderInt64 = vk::True;       // for buffer device address arithmetic in shaders
 
     // Vertex input dynamic state features
     auto vertexInputDynamicStateFeatures = new vk::PhysicalDeviceVertexInputDynamicStateFeaturesEXT{};
@@ -144,6 +162,10 @@ vk::PhysicalDeviceFeatures2 Engine::getPhysicalDeviceFeatures(const EngineFeatur
     // Explicitly required by the application
     auto descriptorIndexingFeatures = new vk::PhysicalDeviceDescriptorIndexingFeatures{};
     descriptorIndexingFeatures->descriptorBindingVariableDescriptorCount = vk::True;
+    // Let storage buffer arrays be partially written, and single elements be swapped without re-recording
+    descriptorIndexingFeatures->descriptorBindingPartiallyBound = vk::True;
+    descriptorIndexingFeatures->descriptorBindingStorageBufferUpdateAfterBind = vk::True;
+    descriptorIndexingFeatures->descriptorBindingUpdateUnusedWhilePending = vk::True;
 
     // Extended dynamic state features: cull mode, front face, primitive topology
     auto extendedDynamicStateFeatures = new vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT{};
@@ -157,6 +179,14 @@ vk::PhysicalDeviceFeatures2 Engine::getPhysicalDeviceFeatures(const EngineFeatur
     auto extendedDynamicState3Features = new vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT{};
     extendedDynamicState3Features->extendedDynamicState3PolygonMode = vk::True;  // explicitly required by the Engine
 
+    // Let shaders access storage buffers through 64-bit pointers, bypassing descriptors
+    auto bufferDeviceAddressFeatures = new vk::PhysicalDeviceBufferDeviceAddressFeatures{};
+    bufferDeviceAddressFeatures->bufferDeviceAddress = vk::True;
+
+    // The Renderer paces in-flight frames and measures input latency on a single timeline semaphore
+    auto timelineSemaphoreFeatures = new vk::PhysicalDeviceTimelineSemaphoreFeatures{};
+    timelineSemaphoreFeatures->timelineSemaphore = vk::True;
+
     // Any update to this feature chain must also get updated in the PhysicalDeviceSelector::checkFeatureSupport method
     auto deviceFeatures = vk::PhysicalDeviceFeatures2{};
     deviceFeatures.features = basicFeatures;
@@ -165,6 +195,8 @@ vk::PhysicalDeviceFeatures2 Engine::getPhysicalDeviceFeatures(const EngineFeatur
     descriptorIndexingFeatures->pNext = extendedDynamicStateFeatures;
     extendedDynamicStateFeatures->pNext = extendedDynamicState2Features;
     extendedDynamicState2Features->pNext = extendedDynamicState3Features;
+    extendedDynamicState3Features->pNext = bufferDeviceAddressFeatures;
+    bufferDeviceAddressFeatures->pNext = timelineSemaphoreFeatures;
 
     return deviceFeatures;
 }
@@ -175,7 +207,11 @@ void Engine::cleanupPhysicalDeviceFeatures(const vk::PhysicalDeviceFeatures2& de
     const auto extendedDynamicStateFeatures = static_cast<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT*>(descriptorIndexingFeatures->pNext);
     const auto extendedDynamicState2Features = static_cast<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT*>(extendedDynamicStateFeatures->pNext);
     const auto extendedDynamicState3Features = static_cast<vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT*>(extendedDynamicState2Features->pNext);
+    const auto bufferDeviceAddressFeatures = static_cast<vk::PhysicalDeviceBufferDeviceAddressFeatures*>(extendedDynamicState3Features->pNext);
+    const auto timelineSemaphoreFeatures = static_cast<vk::PhysicalDeviceTimelineSemaphoreFeatures*>(bufferDeviceAddressFeatures->pNext);
 
+    delete timelineSemaphoreFeatures;
+    delete bufferDeviceAddressFeatures;
     delete extendedDynamicState3Features;
     delete extendedDynamicState2Features;
     delete extendedDynamicStateFeatures;
@@ -184,11 +220,18 @@ void Engine::cleanupPhysicalDeviceFeatures(const vk::PhysicalDeviceFeatures2& de
 }
 
 void Engine::destroy() noexcept {
+    delete _descriptorAllocator;
+    _descriptorAllocator = nullptr;
+
     delete _allocator;
     _allocator = nullptr;
 
     _device.destroyCommandPool(_transferCommandPool);
 
+    // By now the cache has seen every pipeline this run has created
+    PipelineCache::save(_pipelineCacheDirectory, _swapChain->_physicalDevice, _device, _pipelineCache);
+    _device.destroyPipelineCache(_pipelineCache);
+
     _device.destroy(nullptr);
 
     _swapChain.reset();
@@ -219,17 +262,40 @@ std::unique_ptr<Renderer> Engine::createRenderer() const {
         { vk::CommandPoolCreateFlagBits::eResetCommandBuffer, _swapChain->getGraphicsQueueFamily() });
     const auto graphicsQueue = _device.getQueue(_swapChain->getGraphicsQueueFamily(), 0);
     const auto func = reinterpret_cast<PFN_vkCmdSetPolygonModeEXT>(vkGetInstanceProcAddr(_instance, "vkCmdSetPolygonModeEXT"));
-    return std::unique_ptr<Renderer>(new Renderer{ graphicsCommandPool, graphicsQueue, _device, func });
+
+    // Timestamp queries are only usable if the graphics queue family reports some valid bits
+    const auto timestampPeriod = _swapChain->_physicalDevice.getProperties().limits.timestampPeriod;
+    const auto queueFamilies = _swapChain->_physicalDevice.getQueueFamilyProperties();
+    const auto timestampValidBits = queueFamilies[_swapChain->getGraphicsQueueFamily()].timestampValidBits;
+
+    return std::unique_ptr<Renderer>(new Renderer{
+        graphicsCommandPool, graphicsQueue, _device, func, timestampPeriod, timestampValidBits });
 }
 
 void Engine::destroyRenderer(const std::unique_ptr<Renderer>& renderer) const noexcept {
     using namespace std::ranges;
-    for_each(renderer->_drawingFences, [this](const auto& it) { _device.destroyFence(it); });
+    _device.destroySemaphore(renderer->_frameTimeline);
     for_each(renderer->_renderFinishedSemaphores, [this](const auto& it) { _device.destroySemaphore(it); });
     for_each(renderer->_imageAvailableSemaphores, [this](const auto& it) { _device.destroySemaphore(it); });
+    for_each(renderer->_timestampQueryPools, [this](const auto& it) { if (it) _device.destroyQueryPool(it); });
     _device.destroyCommandPool(renderer->_graphicsCommandPool);
 }
 
+std::unique_ptr<ComputeQueue> Engine::createComputeQueue() const {
+    const auto graphicsFamily = getGraphicsQueueFamily();
+    const auto computeFamily = getComputeQueueFamily();
+    return std::unique_ptr<ComputeQueue>(new ComputeQueue{
+        _device, _device.getQueue(computeFamily, 0), computeFamily, _device.getQueue(graphicsFamily, 0), graphicsFamily });
+}
+
+void Engine::destroyComputeQueue(const std::unique_ptr<ComputeQueue>& queue) const noexcept {
+    // Destroying the pools frees the command buffers of jobs that haven't been retired
+    _device.destroySemaphore(queue->_graphicsTimeline);
+    _device.destroySemaphore(queue->_computeTimeline);
+    _device.destroyCommandPool(queue->_graphicsCommandPool);
+    _device.destroyCommandPool(queue->_computeCommandPool);
+}
+
 
 void Engine::destroyBuffer(const Buffer* const buffer) const noexcept {
     _allocator->destroyBuffer(buffer->getNativeBuffer(), static_cast<VmaAllocation>(buffer->getAllocation()));
@@ -248,15 +314,32 @@ void Engine::destroySampler(const std::unique_ptr<Sampler>& sampler) const noexc
 void Engine::destroyShader(const Shader* const shader) const noexcept {
     _device.destroyPipeline(shader->getNativePipeline());
     _device.destroyPipelineLayout(shader->getNativePipelineLayout());
+    _descriptorAllocator->forget(shader->getNativeDescriptorSetLayout());
     _device.destroyDescriptorSetLayout(shader->getNativeDescriptorSetLayout());
     delete shader;
 }
 
 void Engine::destroyShaderInstance(const ShaderInstance* const instance) const noexcept {
-    _device.destroyDescriptorPool(instance->getNativeDescriptorPool());
+    // The sets go back to the allocator to be handed out to the next instance of the same shader
+    const auto& sets = instance->getNativeDescriptorSets();
+    _descriptorAllocator->release(instance->getShader()->getNativeDescriptorSetLayout(), { sets.begin(), sets.end() });
     delete instance;
 }
 
+void Engine::destroyShadingGroup(const std::shared_ptr<ShadingGroup>& group) const noexcept {
+    // Destroying a pool frees all command buffers allocated from it
+    std::ranges::for_each(group->_commandPools, [this](const auto& it) { _device.destroyCommandPool(it); });
+    group->_commandPools.clear();
+    group->_commandBuffers.clear();
+
+    // Renderers must not execute the freed buffers from their caches
+    RenderRevision::bumpStructure();
+}
+
+
+MemoryStatistics Engine::getMemoryStatistics() const {
+    return _allocator->getStatistics();
+}
 
 void Engine::waitIdle() const {
     _device.waitIdle();
@@ -267,6 +350,23 @@ const EngineFeature & Engine::getEngineFeature() const {
     return _feature;
 }
 
+uint32_t Engine::getGraphicsQueueFamily() const {
+    return _swapChain->getGraphicsQueueFamily();
+}
+
+uint32_t Engine::getComputeQueueFamily() const {
+    return _swapChain->_computeFamily.value_or(_swapChain->getGraphicsQueueFamily());
+}
+
+vk::SubgroupFeatureFlags Engine::getSubgroupOperations() const {
+    const auto properties = _swapChain->_physicalDevice.getProperties2<
+        vk::PhysicalDeviceProperties2, vk::PhysicalDeviceSubgroupProperties>();
+    const auto& subgroup = properties.get<vk::PhysicalDeviceSubgroupProperties>();
+    return subgroup.supportedStages & vk::ShaderStageFlagBits::eCompute
+        ? subgroup.supportedOperations
+        : vk::SubgroupFeatureFlags{};
+}
+
 uint32_t Engine::getLimitPushConstantSize() const {
     return _swapChain->_physicalDevice.getProperties().limits.maxPushConstantsSize;
 }
@@ -315,6 +415,14 @@ vk::CommandPool Engine::getNativeTransferCommandPool() const {
     return _transferCommandPool;
 }
 
+vk::PipelineCache Engine::getNativePipelineCache() const {
+    return _pipelineCache;
+}
+
 ResourceAllocator* Engine::getResourceAllocator() const {
     return _allocator;
 }
+
+DescriptorAllocator* Engine::getDescriptorAllocator() const {
+    return _descriptorAllocator;
+}
@@ -53,10 +53,7 @@ Shader* GraphicShader::Builder::build(const Engine& engine, const SwapChain& swa
     }
 
     // Descriptor set layout and pipeline layout
-    const auto bindingFlagInfo = vk::DescriptorSetLayoutBindingFlagsCreateInfo{
-        static_cast<uint32_t>(_descriptorBindingFlags.size()), _descriptorBindingFlags.data() };
-    const auto descriptorSetLayout = device.createDescriptorSetLayout(
-        { {}, static_cast<uint32_t>(_descriptorBindings.size()), _descriptorBindings.data(), &bindingFlagInfo });
+    const auto descriptorSetLayout = createDescriptorSetLayout(device);
     const auto pipelineLayout = device.createPipelineLayout(
         { {}, 1, &descriptorSetLayout, static_cast<uint32_t>(_pushConstantRanges.size()), _pushConstantRanges.data() });
 
@@ -71,11 +68,13 @@ Shader* GraphicShader::Builder::build(const Engine& engine, const SwapChain& swa
         { {}, _vertShaderCode.size(), reinterpret_cast<const uint32_t*>(_vertShaderCode.data()) });
     const auto fragShaderModule = device.createShaderModule(
         { {}, _fragShaderCode.size(), reinterpret_cast<const uint32_t*>(_fragShaderCode.data()) });
+    // Both stages share the same specialization constants
+    const auto pSpecializationInfo = getSpecializationInfo();
     const auto shaderStages = std::array{
         vk::PipelineShaderStageCreateInfo{
-            {}, vk::ShaderStageFlagBits::eVertex, vertShaderModule, _vertShaderEntryPoint.data(), nullptr },
+            {}, vk::ShaderStageFlagBits::eVertex, vertShaderModule, _vertShaderEntryPoint.data(), pSpecializationInfo },
         vk::PipelineShaderStageCreateInfo{
-            {}, vk::ShaderStageFlagBits::eFragment, fragShaderModule, _fragShaderEntryPoint.data(), nullptr },
+            {}, vk::ShaderStageFlagBits::eFragment, fragShaderModule, _fragShaderEntryPoint.data(), pSpecializationInfo },
     };
 
     // These properties by default must be able to change at runtime
@@ -177,7 +176,7 @@ Shader* GraphicShader::Builder::build(const Engine& engine, const SwapChain& swa
     pipelineInfo.basePipelineHandle = nullptr;
     pipelineInfo.basePipelineIndex = -1;
 
-    const auto pipeline = device.createGraphicsPipeline(nullptr, pipelineInfo).value;
+    const auto pipeline = device.createGraphicsPipeline(engine.getNativePipelineCache(), pipelineInfo).value;
 
     // We no longer need the shader modules once the pipeline is created
     device.destroyShaderModule(fragShaderModule);
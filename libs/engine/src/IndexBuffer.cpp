@@ -23,7 +23,7 @@ IndexBuffer* IndexBuffer::Builder::build(const Engine& engine) const {
     // Allocate a dedicated buffer in the GPU
     const auto allocator = engine.getResourceAllocator();
     auto allocation = VmaAllocation{};
-    const auto buffer = allocator->allocateDedicatedBuffer(bufferSize, usage, &allocation);
+    const auto buffer = allocator->allocateDedicatedBuffer(bufferSize, usage, ResourceKind::GeometryBuffer, &allocation);
 
     return new IndexBuffer{
         static_cast<uint32_t>(_indexCount), getIndexType(_indexType), bufferSize, buffer, allocation };
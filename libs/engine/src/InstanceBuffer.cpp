@@ -0,0 +1,126 @@
+#include "engine/InstanceBuffer.h"
+#include "engine/Engine.h"
+
+#include "RenderRevision.h"
+
+#include "allocator/ResourceAllocator.h"
+
+#include <plog/Log.h>
+
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+
+InstanceBuffer::Builder& InstanceBuffer::Builder::capacity(const uint32_t count) {
+    _capacity = count;
+    return *this;
+}
+
+InstanceBuffer::Builder& InstanceBuffer::Builder::binding(const uint32_t binding, const uint32_t byteStride) {
+    _binding.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT;
+    _binding.binding = binding;
+    _binding.stride = byteStride;
+    _binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    _binding.divisor = 1;
+
+    // Attributes added before the binding was known must follow it
+    for (auto& attribute : _attributes) {
+        attribute.binding = binding;
+    }
+    return *this;
+}
+
+InstanceBuffer::Builder& InstanceBuffer::Builder::attribute(
+    const uint32_t location,
+    const AttributeFormat format,
+    const uint32_t byteOffset
+) {
+    auto attributeDescription = VkVertexInputAttributeDescription2EXT{};
+    attributeDescription.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT;
+    attributeDescription.binding = _binding.binding;
+    attributeDescription.location = location;
+    attributeDescription.format = static_cast<VkFormat>(VertexBuffer::Builder::getFormat(format));
+    attributeDescription.offset = byteOffset;
+
+    _attributes.push_back(attributeDescription);
+    return *this;
+}
+
+InstanceBuffer* InstanceBuffer::Builder::build(const Engine& engine) const {
+    if (_capacity == 0 || _binding.stride == 0) {
+        PLOGE << std::format("Constructing an InstanceBuffer with capacity {} and byte stride {}", _capacity, _binding.stride);
+        throw std::invalid_argument("Invalid instance buffer size");
+    }
+
+    // Instance data is rewritten by the host as often as every frame, so we keep a copy per in-flight frame in a single
+    // persistently mapped buffer, the same way UniformBuffer does. Vertex buffer offsets have no alignment requirement
+    // other than that of the attribute formats, which the stride already satisfies.
+    const auto frameSize = static_cast<std::size_t>(_capacity) * _binding.stride;
+    constexpr auto usage = vk::BufferUsageFlagBits::eVertexBuffer;
+
+    const auto allocator = engine.getResourceAllocator();
+    auto allocation = VmaAllocation{};
+    auto allocationInfo = VmaAllocationInfo{};
+    const auto buffer = allocator->allocatePersistentBuffer(
+        frameSize * Renderer::getMaxFramesInFlight(), usage, ResourceKind::GeometryBuffer, &allocation, &allocationInfo);
+
+    auto attributes = _attributes;
+    return new InstanceBuffer{
+        _capacity, _binding, std::move(attributes), buffer, allocation, static_cast<std::byte*>(allocationInfo.pMappedData) };
+}
+
+InstanceBuffer::InstanceBuffer(
+    const uint32_t capacity,
+    const VkVertexInputBindingDescription2EXT& binding,
+    std::vector<VkVertexInputAttributeDescription2EXT>&& attributes,
+    const vk::Buffer& buffer,
+    void* const allocation,
+    std::byte* const pMappedData
+) : Buffer{ buffer, allocation, pMappedData },
+    _capacity{ capacity },
+    _bindingDescription{ binding },
+    _attributeDescriptions{ std::move(attributes) } {
+}
+
+void InstanceBuffer::setData(const uint32_t frameIndex, const void* const data, const uint32_t instanceCount) {
+    if (instanceCount > _capacity) {
+        PLOGE << std::format("Received {} instances for an InstanceBuffer of capacity {}", instanceCount, _capacity);
+        throw std::out_of_range("Instance count exceeds capacity");
+    }
+
+    // See UniformBuffer::setData on why we don't flush
+    std::memcpy(_pMappedData + getOffset(frameIndex), data, static_cast<std::size_t>(instanceCount) * _bindingDescription.stride);
+
+    // The instance count is baked into the recorded draw calls
+    if (_instanceCounts[frameIndex] != instanceCount) {
+        _instanceCounts[frameIndex] = instanceCount;
+        RenderRevision::bump();
+    }
+}
+
+void InstanceBuffer::setData(const void* const data, const uint32_t instanceCount) {
+    for (uint32_t index = 0; index < Renderer::getMaxFramesInFlight(); ++index) {
+        setData(index, data, instanceCount);
+    }
+}
+
+uint32_t InstanceBuffer::getInstanceCount(const uint32_t frameIndex) const {
+    return _instanceCounts[frameIndex];
+}
+
+uint32_t InstanceBuffer::getCapacity() const {
+    return _capacity;
+}
+
+const VkVertexInputBindingDescription2EXT& InstanceBuffer::getBindingDescription() const {
+    return _bindingDescription;
+}
+
+const std::vector<VkVertexInputAttributeDescription2EXT>& InstanceBuffer::getAttributeDescriptions() const {
+    return _attributeDescriptions;
+}
+
+vk::DeviceSize InstanceBuffer::getOffset(const uint32_t frameIndex) const {
+    return static_cast<vk::DeviceSize>(frameIndex) * _capacity * _bindingDescription.stride;
+}
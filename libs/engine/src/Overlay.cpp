@@ -52,7 +52,7 @@ void Overlay::init(Surface* const surface, const Engine& engine, const SwapChain
     initInfo.RenderPass = swapChain.getNativeRenderPass();
     initInfo.Subpass = 0;
     initInfo.MSAASamples = static_cast<VkSampleCountFlagBits>(swapChain.getNativeSampleCount());
-    initInfo.PipelineCache = VK_NULL_HANDLE;
+    initInfo.PipelineCache = engine.getNativePipelineCache();
     initInfo.DescriptorPool = m_pool;
     initInfo.Allocator = nullptr;              // optional
     initInfo.CheckVkResultFn = checkVkResult;  // optional
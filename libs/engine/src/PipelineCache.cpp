@@ -0,0 +1,135 @@
+#include "PipelineCache.h"
+
+#include <plog/Log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <vector>
+
+
+struct PipelineCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t dataSize;
+};
+
+static constexpr uint32_t mMagic = 0x48434E50;  // "PNCH" in little endian
+static constexpr uint32_t mVersion = 1;
+
+static PipelineCacheHeader makeHeader(const vk::PhysicalDeviceProperties& properties, const uint64_t dataSize) {
+    auto header = PipelineCacheHeader{ mMagic, mVersion, properties.vendorID, properties.deviceID, properties.driverVersion };
+    std::ranges::copy(properties.pipelineCacheUUID, header.pipelineCacheUUID);
+    header.dataSize = dataSize;
+    return header;
+}
+
+static std::filesystem::path getFilePath(
+    const std::filesystem::path& directory,
+    const vk::PhysicalDeviceProperties& properties
+) {
+    return directory / std::format("pipeline-{:04x}-{:04x}.cache", properties.vendorID, properties.deviceID);
+}
+
+static std::vector<char> readCacheData(const std::filesystem::path& path, const vk::PhysicalDeviceProperties& properties) {
+    auto file = std::ifstream{ path, std::ios::binary };
+    if (!file.is_open()) {
+        PLOGI << "No pipeline cache found at " << path.string() << ", pipelines will be compiled from scratch";
+        return {};
+    }
+
+    auto header = PipelineCacheHeader{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        PLOGW << "Ignoring truncated pipeline cache at " << path.string();
+        return {};
+    }
+
+    const auto expected = makeHeader(properties, header.dataSize);
+    if (header.magic != expected.magic || header.version != expected.version) {
+        PLOGW << "Ignoring pipeline cache of unknown format at " << path.string();
+        return {};
+    }
+    if (header.vendorID != expected.vendorID || header.deviceID != expected.deviceID ||
+        header.driverVersion != expected.driverVersion ||
+        std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        PLOGI << "Pipeline cache at " << path.string() << " was written by another device or driver, discarding it";
+        return {};
+    }
+
+    // A corrupted size must not allocate more than the file could possibly hold
+    const auto dataBegin = file.tellg();
+    file.seekg(0, std::ios::end);
+    const auto remaining = static_cast<uint64_t>(file.tellg() - dataBegin);
+    file.seekg(dataBegin);
+    if (header.dataSize > remaining) {
+        PLOGW << "Ignoring pipeline cache at " << path.string() << ", it claims " << header.dataSize
+            << " bytes of data but only " << remaining << " follow its header";
+        return {};
+    }
+
+    auto data = std::vector<char>(header.dataSize);
+    if (!file.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+        PLOGW << "Ignoring truncated pipeline cache at " << path.string();
+        return {};
+    }
+    return data;
+}
+
+vk::PipelineCache PipelineCache::load(
+    const std::filesystem::path& directory,
+    const vk::PhysicalDevice& physicalDevice,
+    const vk::Device& device
+) {
+    auto data = std::vector<char>{};
+    if (!directory.empty()) {
+        const auto properties = physicalDevice.getProperties();
+        data = readCacheData(getFilePath(directory, properties), properties);
+    }
+
+    // The driver validates the data once more against its own header, and falls back to an empty cache on mismatch
+    const auto cacheInfo = vk::PipelineCacheCreateInfo{ {}, data.size(), data.data() };
+    const auto cache = device.createPipelineCache(cacheInfo);
+    if (!data.empty()) {
+        PLOGD << "Loaded " << data.size() << " bytes of pipeline cache";
+    }
+    return cache;
+}
+
+void PipelineCache::save(
+    const std::filesystem::path& directory,
+    const vk::PhysicalDevice& physicalDevice,
+    const vk::Device& device,
+    const vk::PipelineCache& cache
+) noexcept {
+    if (directory.empty()) return;
+
+    try {
+        const auto properties = physicalDevice.getProperties();
+        const auto data = device.getPipelineCacheData(cache);
+        const auto header = makeHeader(properties, data.size());
+
+        // Write to a temporary file first so that a crash midway never leaves a corrupted cache behind
+        std::filesystem::create_directories(directory);
+        const auto path = getFilePath(directory, properties);
+        auto tempPath = path;
+        tempPath += ".tmp";
+        {
+            auto file = std::ofstream{ tempPath, std::ios::binary | std::ios::trunc };
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file) {
+                PLOGW << "Could not write pipeline cache to " << tempPath.string();
+                return;
+            }
+        }
+        std::filesystem::rename(tempPath, path);
+        PLOGD << "Saved " << data.size() << " bytes of pipeline cache to " << path.string();
+    } catch (const std::exception& e) {
+        PLOGW << "Could not save pipeline cache: " << e.what();
+    }
+}
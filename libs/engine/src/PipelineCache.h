@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <filesystem>
+
+
+// Loads and saves a VkPipelineCache to a file named after the physical device, so that pipelines compiled in one run
+// can be reused by the next. Each file starts with a small header recording the vendor, device, driver version and
+// pipeline cache UUID it was written with. A file that doesn't match the current device or driver, or that is
+// truncated, gets ignored and the cache starts out empty.
+class PipelineCache final {
+public:
+    // An empty directory creates an empty, in-memory cache
+    [[nodiscard]] static vk::PipelineCache load(
+        const std::filesystem::path& directory, const vk::PhysicalDevice& physicalDevice, const vk::Device& device);
+
+    // Writes the cache out, silently skipping the write if the directory is empty. Failures are logged, not thrown,
+    // since this runs while the engine is shutting down
+    static void save(
+        const std::filesystem::path& directory,
+        const vk::PhysicalDevice& physicalDevice,
+        const vk::Device& device,
+        const vk::PipelineCache& cache) noexcept;
+
+    PipelineCache() = delete;
+};
@@ -0,0 +1,34 @@
+#include "RenderRevision.h"
+
+#include <atomic>
+
+
+static std::atomic_uint64_t mRevision{ 0 };
+static std::atomic_uint64_t mStructureRevision{ 0 };
+static std::atomic_uint64_t mTransformRevision{ 0 };
+
+void RenderRevision::bump() noexcept {
+    mRevision.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RenderRevision::bumpStructure() noexcept {
+    mStructureRevision.fetch_add(1, std::memory_order_relaxed);
+    bump();
+}
+
+void RenderRevision::bumpTransform() noexcept {
+    mTransformRevision.fetch_add(1, std::memory_order_relaxed);
+    bump();
+}
+
+uint64_t RenderRevision::get() noexcept {
+    return mRevision.load(std::memory_order_relaxed);
+}
+
+uint64_t RenderRevision::getStructure() noexcept {
+    return mStructureRevision.load(std::memory_order_relaxed);
+}
+
+uint64_t RenderRevision::getTransform() noexcept {
+    return mTransformRevision.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Process-wide counters bumped by every edit that would be baked into recorded drawing commands: the composable
+// trees and their transforms, scenes, views, cameras, and descriptor writes. The Renderer compares the overall
+// revision against the value it recorded with to decide whether cached command buffers are still valid, while
+// Scenes use the structure and transform revisions to tell whether their render queue must be rebuilt or only
+// needs its world transforms refreshed. Edits to the contents of bound buffers and textures don't count since
+// recorded commands only refer to them.
+class RenderRevision final {
+public:
+    static void bump() noexcept;
+    static void bumpStructure() noexcept;
+    static void bumpTransform() noexcept;
+
+    [[nodiscard]] static uint64_t get() noexcept;
+    [[nodiscard]] static uint64_t getStructure() noexcept;
+    [[nodiscard]] static uint64_t getTransform() noexcept;
+
+    RenderRevision() = delete;
+};
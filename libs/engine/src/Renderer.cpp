@@ -1,37 +1,66 @@
 #include "engine/Renderer.h"
 #include "engine/Composable.h"
+#include "engine/Drawable.h"
 #include "engine/Overlay.h"
 #include "engine/Scene.h"
 #include "engine/SwapChain.h"
+#include "engine/Trace.h"
 #include "engine/View.h"
 
+#include "RenderRevision.h"
+
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_vulkan.h>
 
+#include <algorithm>
+#include <format>
 #include <limits>
+#include <optional>
 
 
 Renderer::Renderer(
     const vk::CommandPool& graphicsCommandPool,
     const vk::Queue& graphicsQueue,
     const vk::Device& device,
-    PFN_vkCmdSetPolygonModeEXT vkCmdSetPolygonMode
+    PFN_vkCmdSetPolygonModeEXT vkCmdSetPolygonMode,
+    const float timestampPeriod,
+    const uint32_t timestampValidBits
 ) : _graphicsCommandPool{ graphicsCommandPool },
     _graphicsQueue{ graphicsQueue },
     _device{ device },
-    _vkCmdSetPolygonMode{ vkCmdSetPolygonMode } {
+    _vkCmdSetPolygonMode{ vkCmdSetPolygonMode },
+    _timestampPeriod{ timestampValidBits > 0 ? timestampPeriod : 0.0f },
+    _timestampMask{ timestampValidBits >= 64 ? std::numeric_limits<uint64_t>::max() : (1ull << timestampValidBits) - 1 } {
     // Allocate drawing command buffers for each in-flight frame
     const auto allocInfo = vk::CommandBufferAllocateInfo{
         _graphicsCommandPool, vk::CommandBufferLevel::ePrimary, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT) };
     auto commandBuffers = _device.allocateCommandBuffers(allocInfo);
     std::ranges::move(commandBuffers, _drawingCommandBuffers.begin());
 
+    // Together with secondary command buffers for the view and overlay contents
+    const auto secondaryAllocInfo = vk::CommandBufferAllocateInfo{
+        _graphicsCommandPool, vk::CommandBufferLevel::eSecondary, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT) };
+    auto viewCommandBuffers = _device.allocateCommandBuffers(secondaryAllocInfo);
+    std::ranges::move(viewCommandBuffers, _viewCommandBuffers.begin());
+    auto overlayCommandBuffers = _device.allocateCommandBuffers(secondaryAllocInfo);
+    std::ranges::move(overlayCommandBuffers, _overlayCommandBuffers.begin());
+
     // Create sync objects
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         _imageAvailableSemaphores[i] = _device.createSemaphore({});
         _renderFinishedSemaphores[i] = _device.createSemaphore({});
-        _drawingFences[i] = _device.createFence({ vk::FenceCreateFlagBits::eSignaled });
+    }
+
+    // The timeline starts at zero, which every frame slot is initially waiting for
+    const auto timelineInfo = vk::SemaphoreTypeCreateInfo{ vk::SemaphoreType::eTimeline, 0 };
+    _frameTimeline = _device.createSemaphore({ {}, &timelineInfo });
+
+    // Create timestamp query pools, provided the graphics queue supports them
+    if (isGpuTimingSupported()) {
+        for (auto& pool : _timestampQueryPools) {
+            pool = _device.createQueryPool({ {}, vk::QueryType::eTimestamp, MAX_TIMESTAMP_QUERIES });
+        }
     }
 }
 
@@ -40,32 +69,7 @@ void Renderer::render(
     const std::shared_ptr<SwapChain>& swapChain,
     const std::function<void(uint32_t)>& onFrameBegin
 ) {
-    // Try acquire an image from the swap chain
-    uint32_t imageIndex;
-    if (!beginFrame(swapChain, onFrameBegin, &imageIndex)) return;
-
-    // We can start record drawing commands to the buffer
-    _drawingCommandBuffers[_currentFrame].reset();
-    _drawingCommandBuffers[_currentFrame].begin(vk::CommandBufferBeginInfo{});
-
-    // Begine the render pass
-    const auto renderPassInfo = vk::RenderPassBeginInfo{
-        swapChain->getNativeRenderPass(), swapChain->getNativeFramebufferAt(imageIndex),
-        { { 0, 0 }, swapChain->getNativeSwapImageExtent() }, CLEAR_VALUES };
-    // Right now we're not using any secondary command buffer, hence vk::SubpassContents::eInline
-    _drawingCommandBuffers[_currentFrame].beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
-
-    renderView(view);
-
-    // End the render pass and finish recording the command buffer
-    _drawingCommandBuffers[_currentFrame].endRenderPass();
-    _drawingCommandBuffers[_currentFrame].end();
-
-    // Submit the rendered frame to the swap chain for presentation
-    endFrame(imageIndex, swapChain);
-
-    // Advance to the next frame
-    _currentFrame = (_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    renderFrame(view, nullptr, swapChain, onFrameBegin);
 }
 
 void Renderer::render(
@@ -74,64 +78,93 @@ void Renderer::render(
     const std::shared_ptr<SwapChain>& swapChain,
     const std::function<void(uint32_t)>& onFrameBegin
 ) {
+    renderFrame(view, overlay.get(), swapChain, onFrameBegin);
+}
+
+void Renderer::renderFrame(
+    const std::unique_ptr<View>& view,
+    Overlay* const overlay,
+    const std::shared_ptr<SwapChain>& swapChain,
+    const std::function<void(uint32_t)>& onFrameBegin
+) {
+    const auto frameScope = Trace::Scope{ "Frame" };
+
     // Try to acquire an image from the swap chain
     uint32_t imageIndex;
     if (!beginFrame(swapChain, onFrameBegin, &imageIndex)) return;
 
     // We can now start record drawing commands to the buffer
-    _drawingCommandBuffers[_currentFrame].reset();
-    _drawingCommandBuffers[_currentFrame].begin(vk::CommandBufferBeginInfo{});
-
-    // Begin the render pass
+    auto recordScope = std::optional<Trace::Scope>{ std::in_place, "Record commands" };
+    const auto& commandBuffer = _drawingCommandBuffers[_currentFrame];
+    commandBuffer.reset();
+    commandBuffer.begin(vk::CommandBufferBeginInfo{});
+    resetTimestamps();
+
+    // Begin the render pass. All of its contents come from secondary command buffers, which is what allows
+    // ShadingGroups to record their share of the scene on worker threads
     const auto renderPassInfo = vk::RenderPassBeginInfo{
         swapChain->getNativeRenderPass(), swapChain->getNativeFramebufferAt(imageIndex),
         { { 0, 0 }, swapChain->getNativeSwapImageExtent() }, CLEAR_VALUES };
-    // Right now we're not using any secondary command buffer, hence vk::SubpassContents::eInline
-    _drawingCommandBuffers[_currentFrame].beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+    commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+
+    // Secondary command buffers must know which render pass and subpass they will be executed within. Specifying
+    // the framebuffer is optional but may let the driver generate better code for them. We leave it out for the view
+    // buffers since they are cached and reused with whichever swap image gets acquired
+    const auto viewInheritanceInfo = vk::CommandBufferInheritanceInfo{
+        swapChain->getNativeRenderPass(), /* subpass */ 0, /* framebuffer */ nullptr };
+    const auto overlayInheritanceInfo = vk::CommandBufferInheritanceInfo{
+        swapChain->getNativeRenderPass(), /* subpass */ 0, swapChain->getNativeFramebufferAt(imageIndex) };
 
-    renderView(view);
-    renderOverlay(overlay);
+    auto secondaryBuffers = renderView(view, viewInheritanceInfo);
+    secondaryBuffers.push_back(renderOverlay(overlay, overlayInheritanceInfo));
+    commandBuffer.executeCommands(secondaryBuffers);
 
     // End the render pass and finish recording the command buffer
-    _drawingCommandBuffers[_currentFrame].endRenderPass();
-    _drawingCommandBuffers[_currentFrame].end();
+    commandBuffer.endRenderPass();
+    writeTimestamp(commandBuffer, vk::PipelineStageFlagBits::eBottomOfPipe, FRAME_END_QUERY);
+    commandBuffer.end();
+    recordScope.reset();
 
     // Submit the rendered frame to the swap chain for presentation
     endFrame(imageIndex, swapChain);
 
     // Advance to the next frame
-    _currentFrame = (_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    _currentFrame = (_currentFrame + 1) % _framesInFlight;
 }
 
 bool Renderer::beginFrame(
     const std::shared_ptr<SwapChain>& swapChain,
     const std::function<void(uint32_t)>& onFrameBegin,
     uint32_t* imageIndex
-) const {
+) {
     using limits = std::numeric_limits<uint64_t>;
 
     // At the start of the frame, we want to wait until the command buffer has finished all the rendering work
-    // which was recorded for the previous frame
-    [[maybe_unused]] const auto result = _device.waitForFences(_drawingFences[_currentFrame], vk::True, limits::max());
+    // which was recorded for the previous frame. This returns immediately if the call site already waited
+    waitForNextFrame();
+
+    // The previous submission of this frame has retired, its timestamps can be read back without blocking
+    collectTimestamps();
+    collectInputLatency();
 
     // We acquire an image from the swapchain and provide a semaphore for the swap chain to signal when the image
     // becomes available. That’s the point in time where we can start drawing to it.
-    if (!swapChain->acquire(_device, limits::max(), _imageAvailableSemaphores[_currentFrame], imageIndex)) {
+    if (const auto scope = Trace::Scope{ "Acquire image" };
+        !swapChain->acquire(_device, limits::max(), _imageAvailableSemaphores[_currentFrame], imageIndex)) {
         // The swap chain tells us to try again in the next rendering iteration
         return false;
     }
 
-    // If we indeed acquired a swap chain image, we can start draw stuff to it. The drawing fence for this frame
-    // can now be reset so that the command buffer later can signal it
-    _device.resetFences(_drawingFences[_currentFrame]);
-
     // Give the call site a chance to update any frame-specific resource
-    onFrameBegin(_currentFrame);
+    {
+        const auto scope = Trace::Scope{ "Frame begin callback" };
+        onFrameBegin(_currentFrame);
+    }
 
     return true;
 }
 
-void Renderer::endFrame(const uint32_t imageIndex, const std::shared_ptr<SwapChain>& swapChain) const {
+void Renderer::endFrame(const uint32_t imageIndex, const std::shared_ptr<SwapChain>& swapChain) {
     // With a fully recorded command buffer, we can now submit it. First we need to specify which semaphores to wait on
     // before execution can begin. It should be the semaphore we gave the swap chain which will signal it when the
     // acquired image is available
@@ -147,49 +180,302 @@ void Renderer::endFrame(const uint32_t imageIndex, const std::shared_ptr<SwapCha
     // eTopOfPipe, but it't better to synchronize this implicit subpass through subpass dependencies
     constexpr vk::PipelineStageFlags waitStages[]{ vk::PipelineStageFlagBits::eColorAttachmentOutput };
 
+    // Besides the binary semaphore the presentation waits on, the submission signals the next timeline value when all
+    // its operations have finished, allowing us to know when it is safe for the command buffer to be reused. The
+    // value given for the binary semaphore is ignored
+    _frameTimelineValues[_currentFrame] = ++_frameTimelineValue;
+    const auto signalSemaphores = std::array{ _renderFinishedSemaphores[_currentFrame], _frameTimeline };
+    const auto signalValues = std::array<uint64_t, 2>{ 0, _frameTimelineValue };
+    const auto timelineSubmitInfo = vk::TimelineSemaphoreSubmitInfo{
+        0, nullptr, static_cast<uint32_t>(signalValues.size()), signalValues.data() };
+
     const auto drawingSubmitInfo = vk::SubmitInfo{
         static_cast<uint32_t>(waitSemaphores.size()), waitSemaphores.data(), waitStages,
-        1, &_drawingCommandBuffers[_currentFrame], 1, &_renderFinishedSemaphores[_currentFrame] };
-    // Submit drawing commands to the queue and specify which fence to signal when all the operations have finished,
-    // allowing us to know when it is safe for the command buffer to be reused
-    _graphicsQueue.submit(drawingSubmitInfo, _drawingFences[_currentFrame]);
+        1, &_drawingCommandBuffers[_currentFrame],
+        static_cast<uint32_t>(signalSemaphores.size()), signalSemaphores.data(), &timelineSubmitInfo };
+    {
+        const auto scope = Trace::Scope{ "Submit" };
+        _graphicsQueue.submit(drawingSubmitInfo);
+    }
+
+    // This is the first submission that could reflect input marked since the last one. While a measurement is still
+    // outstanding, newer input is dropped rather than attributed to a later frame
+    if (_pendingInput && !_submittedInput) {
+        _submittedInput = std::pair{ *_pendingInput, _frameTimelineValue };
+    }
+    _pendingInput.reset();
 
     // The last step is to instruct the swap chain to present the drawn image. We also need to tell the swap chain
     // which semaphore it should wait on before presenting.
+    const auto scope = Trace::Scope{ "Present" };
     swapChain->present(_device, imageIndex, _renderFinishedSemaphores[_currentFrame]);
 }
 
-void Renderer::renderView(const std::unique_ptr<View>& view) const {
+std::vector<vk::CommandBuffer> Renderer::renderView(
+    const std::unique_ptr<View>& view,
+    const vk::CommandBufferInheritanceInfo& inheritanceInfo
+) {
+    // Nothing baked into the commands has changed since this frame's buffers were last recorded, execute them again.
+    // The previous submission of this frame has retired in beginFrame, so they are no longer pending
+    auto& cache = _viewCaches[_currentFrame];
+    const auto revision = RenderRevision::get();
+    if (cache.valid && cache.view == view.get() && cache.renderPass == inheritanceInfo.renderPass &&
+        cache.revision == revision) {
+        // The cached buffers write the same drawable timestamps as when they were recorded
+        const auto timedCount = static_cast<uint32_t>(_timedDrawables[_currentFrame].size());
+        _timestampQueryCounts[_currentFrame] = FIRST_DRAWABLE_QUERY + 2 * timedCount;
+        return cache.buffers;
+    }
+
+    const auto scope = Trace::Scope{ "Record view" };
+    _timedDrawables[_currentFrame].clear();
+
+    // Without the one-time-submit flag, the buffer can be executed again in later frames
+    const auto& commandBuffer = _viewCommandBuffers[_currentFrame];
+    commandBuffer.reset();
+    commandBuffer.begin({ vk::CommandBufferUsageFlagBits::eRenderPassContinue, &inheritanceInfo });
+    writeTimestamp(commandBuffer, vk::PipelineStageFlagBits::eTopOfPipe, VIEW_BEGIN_QUERY);
+
+    // Dynamic states are set once per command buffer, right after its first pipeline bind. ShadingGroups invoke
+    // this from their worker threads, so it must not touch anything but the view
+    const auto onPipelineBound = std::function{ [this, &view](const vk::CommandBuffer& buffer) {
+        buffer.setViewport(0, view->getNativeViewport());
+        buffer.setScissor(0, view->getNativeScissor());
+        _vkCmdSetPolygonMode(buffer, static_cast<VkPolygonMode>(view->getNativePolygonMode()));
+        buffer.setCullMode(view->getNativeCullMode());
+        buffer.setFrontFace(view->getNativeFrontFace());
+        buffer.setPrimitiveRestartEnable(view->getNativePrimitiveRestartEnabled());
+        buffer.setLineWidth(view->getLineWidth());
+    } };
+
+    // Time each top-level composable for as long as there are queries left in the pool. The render queue is sorted
+    // by pipeline rather than by composable, so a composable may be timed over several runs of records
+    auto timedRoots = std::vector<const Composable*>{};
+    auto timedRoot = static_cast<const Composable*>(nullptr);
+    auto timedQuery = std::optional<uint32_t>{};
+    const auto timeRoot = [&](const Composable* const root) {
+        if (timedQuery) {
+            writeTimestamp(commandBuffer, vk::PipelineStageFlagBits::eBottomOfPipe, *timedQuery + 1);
+            timedQuery.reset();
+        }
+        timedRoot = root;
+
+        const auto query = _timestampQueryCounts[_currentFrame];
+        if (root == nullptr || !isGpuTimingSupported() || query + 2 > MAX_TIMESTAMP_QUERIES) return;
+
+        // Runs of the same composable are added up under the same label
+        auto label = root->getName();
+        if (label.empty()) {
+            const auto found = std::ranges::find(timedRoots, root);
+            label = std::format("Drawable {}", std::distance(timedRoots.begin(), found));
+            if (found == timedRoots.end()) timedRoots.push_back(root);
+        }
+        _timedDrawables[_currentFrame].push_back(std::move(label));
+        _timestampQueryCounts[_currentFrame] += 2;
+        writeTimestamp(commandBuffer, vk::PipelineStageFlagBits::eTopOfPipe, query);
+        timedQuery = query;
+    };
+
+    // The view buffer goes first, followed by whatever secondary buffers the composables hand back
+    auto buffers = std::vector{ commandBuffer };
+    auto state = DrawState{};
     const auto scene = view->getScene();
-    scene->forEach([this, &view](const std::shared_ptr<Composable>& composable) {
-        const auto buffers = composable->recordDrawingCommands(
-            _currentFrame, _drawingCommandBuffers[_currentFrame], view->getCamera()->getCameraMatrix(),
-            /* current transform */ { 1.0f }, [this, &view](const vk::CommandBuffer& buffer) {
-                // Set all dynamic states
-                buffer.setViewport(0, view->getNativeViewport());
-                buffer.setScissor(0, view->getNativeScissor());
-                _vkCmdSetPolygonMode(buffer, static_cast<VkPolygonMode>(view->getNativePolygonMode()));
-                buffer.setCullMode(view->getNativeCullMode());
-                buffer.setFrontFace(view->getNativeFrontFace());
-                buffer.setPrimitiveRestartEnable(view->getNativePrimitiveRestartEnabled());
-                buffer.setLineWidth(view->getLineWidth());
-            });
-    });
-}
-
-void Renderer::renderOverlay(const std::shared_ptr<Overlay>& overlay) const {
-    // Start the Dear ImGui frame
-    ImGui_ImplVulkan_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
-
-    // Define the layout
-    overlay->define();
-
-    // Rendering
-    ImGui::Render();
-    const auto drawData = ImGui::GetDrawData();
-
-    // Record dear imgui primitives into command buffer
-    ImGui_ImplVulkan_RenderDrawData(drawData, _drawingCommandBuffers[_currentFrame]);
+    const auto& cameraMatrix = view->getCamera()->getCameraMatrix();
+    for (const auto& record : scene->getRenderQueue()) {
+        if (record.root != timedRoot) {
+            timeRoot(record.root);
+        }
+
+        const auto& worldTransform = scene->getWorldTransform(record.transform);
+        if (record.drawable) {
+            record.drawable->recordPrimitive(
+                _currentFrame, commandBuffer, state, cameraMatrix, worldTransform, record.primitive, &onPipelineBound);
+        } else {
+            const auto childBuffers = record.composable->recordDrawingCommands(
+                _currentFrame, commandBuffer, state, inheritanceInfo, cameraMatrix, worldTransform, onPipelineBound);
+            buffers.insert(buffers.end(), childBuffers.begin(), childBuffers.end());
+        }
+    }
+    timeRoot(nullptr);
+
+    commandBuffer.end();
+
+    cache = { view.get(), inheritanceInfo.renderPass, revision, true, buffers };
+    return buffers;
+}
+
+vk::CommandBuffer Renderer::renderOverlay(
+    Overlay* const overlay,
+    const vk::CommandBufferInheritanceInfo& inheritanceInfo
+) const {
+    const auto& commandBuffer = _overlayCommandBuffers[_currentFrame];
+    commandBuffer.reset();
+    using Usage = vk::CommandBufferUsageFlagBits;
+    commandBuffer.begin({ Usage::eRenderPassContinue | Usage::eOneTimeSubmit, &inheritanceInfo });
+
+    // This buffer executes after all view buffers, including those recorded by ShadingGroups
+    writeTimestamp(commandBuffer, vk::PipelineStageFlagBits::eBottomOfPipe, VIEW_END_QUERY);
+
+    if (overlay) {
+        writeTimestamp(commandBuffer, vk::PipelineStageFlagBits::eTopOfPipe, OVERLAY_BEGIN_QUERY);
+
+        // Start the Dear ImGui frame
+        ImGui_ImplVulkan_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+
+        // Define the layout
+        overlay->define();
+
+        // Rendering
+        ImGui::Render();
+        const auto drawData = ImGui::GetDrawData();
+
+        // Record dear imgui primitives into command buffer
+        ImGui_ImplVulkan_RenderDrawData(drawData, commandBuffer);
+
+        writeTimestamp(commandBuffer, vk::PipelineStageFlagBits::eBottomOfPipe, OVERLAY_END_QUERY);
+    }
+
+    commandBuffer.end();
+    return commandBuffer;
+}
+
+void Renderer::resetTimestamps() {
+    if (!isGpuTimingSupported()) return;
+
+    // Queries must be reset outside of a render pass before they can be written again
+    const auto& commandBuffer = _drawingCommandBuffers[_currentFrame];
+    commandBuffer.resetQueryPool(_timestampQueryPools[_currentFrame], 0, MAX_TIMESTAMP_QUERIES);
+    _timestampQueryCounts[_currentFrame] = FIRST_DRAWABLE_QUERY;
+
+    writeTimestamp(commandBuffer, vk::PipelineStageFlagBits::eTopOfPipe, FRAME_BEGIN_QUERY);
+}
+
+void Renderer::writeTimestamp(
+    const vk::CommandBuffer& commandBuffer,
+    const vk::PipelineStageFlagBits stage,
+    const uint32_t query
+) const {
+    if (!isGpuTimingSupported()) return;
+    commandBuffer.writeTimestamp(stage, _timestampQueryPools[_currentFrame], query);
+}
+
+void Renderer::collectTimestamps() {
+    const auto queryCount = _timestampQueryCounts[_currentFrame];
+    if (!isGpuTimingSupported() || queryCount == 0) return;
+
+    // Each result is followed by its availability so that unwritten queries (e.g. the overlay pass when rendering
+    // without an overlay) don't invalidate the others
+    struct QueryResult {
+        uint64_t timestamp;
+        uint64_t available;
+    };
+    auto results = std::array<QueryResult, MAX_TIMESTAMP_QUERIES>{};
+    [[maybe_unused]] const auto result = _device.getQueryPoolResults(
+        _timestampQueryPools[_currentFrame], 0, queryCount, sizeof(QueryResult) * queryCount, results.data(),
+        sizeof(QueryResult), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+    // Make sure we don't count the same results twice if the next beginFrame bails out early
+    _timestampQueryCounts[_currentFrame] = 0;
+
+    const auto measure = [this, &results](const uint32_t begin, const uint32_t end) -> std::optional<float> {
+        if (results[begin].available == 0 || results[end].available == 0) return std::nullopt;
+        const auto ticks = (results[end].timestamp - results[begin].timestamp) & _timestampMask;
+        return static_cast<float>(ticks) * _timestampPeriod / 1'000'000.0f;
+    };
+
+    // An exponential moving average smooths out per-frame jitter
+    const auto smooth = [](const float sample, float* average) {
+        static constexpr auto SMOOTHING = 0.05f;
+        *average = *average == 0.0f ? sample : *average + (sample - *average) * SMOOTHING;
+    };
+
+    const auto elapsed = [&measure, &smooth](const uint32_t begin, const uint32_t end, float* average) {
+        if (const auto sample = measure(begin, end)) smooth(*sample, average);
+    };
+
+    elapsed(FRAME_BEGIN_QUERY, FRAME_END_QUERY, &_gpuTimings.frame);
+    elapsed(VIEW_BEGIN_QUERY, VIEW_END_QUERY, &_gpuTimings.view);
+    elapsed(OVERLAY_BEGIN_QUERY, OVERLAY_END_QUERY, &_gpuTimings.overlay);
+
+    // Add up the runs of each composable first
+    auto samples = std::vector<std::pair<std::string, float>>{};
+    for (uint32_t i = 0; i < _timedDrawables[_currentFrame].size(); ++i) {
+        const auto sample = measure(FIRST_DRAWABLE_QUERY + i * 2, FIRST_DRAWABLE_QUERY + i * 2 + 1);
+        if (!sample) continue;
+
+        const auto& name = _timedDrawables[_currentFrame][i];
+        const auto found = std::ranges::find(samples, name, &std::pair<std::string, float>::first);
+        if (found != samples.end()) {
+            found->second += *sample;
+        } else {
+            samples.emplace_back(name, *sample);
+        }
+    }
+
+    // Then carry over averages of drawables that are still being rendered, drop those that are not
+    auto drawables = std::vector<std::pair<std::string, float>>{};
+    drawables.reserve(samples.size());
+    for (auto& [name, sample] : samples) {
+        const auto found = std::ranges::find(_gpuTimings.drawables, name, &std::pair<std::string, float>::first);
+        auto average = found != _gpuTimings.drawables.end() ? found->second : 0.0f;
+        smooth(sample, &average);
+        drawables.emplace_back(std::move(name), average);
+    }
+    _gpuTimings.drawables = std::move(drawables);
+}
+
+void Renderer::collectInputLatency() {
+    if (!_submittedInput) return;
+
+    // Polled right after waiting on the timeline, when the frame carrying the input has most likely just completed
+    const auto& [inputTime, timelineValue] = *_submittedInput;
+    if (_device.getSemaphoreCounterValue(_frameTimeline) < timelineValue) return;
+
+    const auto sample = std::chrono::duration<float, std::milli>(Clock::now() - inputTime).count();
+    static constexpr auto SMOOTHING = 0.2f;
+    _inputLatency = _inputLatency == 0.0f ? sample : _inputLatency + (sample - _inputLatency) * SMOOTHING;
+    _submittedInput.reset();
+}
+
+void Renderer::setFramesInFlight(const uint32_t count) noexcept {
+    _framesInFlight = std::clamp(count, 1u, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT));
+
+    // Slots beyond the new count simply stop being used, their last submissions retire on their own
+    if (_currentFrame >= _framesInFlight) {
+        _currentFrame = 0;
+    }
+}
+
+uint32_t Renderer::getFramesInFlight() const noexcept {
+    return _framesInFlight;
+}
+
+void Renderer::waitForNextFrame() const {
+    const auto scope = Trace::Scope{ "Wait for frame" };
+    const auto waitInfo = vk::SemaphoreWaitInfo{ {}, 1, &_frameTimeline, &_frameTimelineValues[_currentFrame] };
+    [[maybe_unused]] const auto result = _device.waitSemaphores(waitInfo, std::numeric_limits<uint64_t>::max());
+}
+
+void Renderer::markInput() noexcept {
+    if (!_pendingInput) {
+        _pendingInput = Clock::now();
+    }
+}
+
+float Renderer::getInputLatency() const noexcept {
+    return _inputLatency;
+}
+
+const Renderer::GpuTimings& Renderer::getGpuTimings() const noexcept {
+    return _gpuTimings;
+}
+
+bool Renderer::isGpuTimingSupported() const noexcept {
+    return _timestampPeriod > 0.0f;
+}
+
+void Renderer::invalidate() noexcept {
+    std::ranges::for_each(_viewCaches, [](auto& it) { it.valid = false; });
 }
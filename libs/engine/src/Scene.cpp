@@ -1,6 +1,11 @@
 #include "engine/Scene.h"
+#include "engine/Drawable.h"
+#include "engine/ShaderInstance.h"
+
+#include "RenderRevision.h"
 
 #include <algorithm>
+#include <unordered_map>
 
 
 std::shared_ptr<Scene> Scene::create() {
@@ -8,13 +13,105 @@ std::shared_ptr<Scene> Scene::create() {
 }
 
 void Scene::insert(const std::shared_ptr<Composable>& composable) {
-    _composables.insert(composable);
+    if (std::ranges::find(_composables, composable) != _composables.end()) return;
+    _composables.push_back(composable);
+    RenderRevision::bumpStructure();
 }
 
 void Scene::remove(const std::shared_ptr<Composable>& composable) {
-    _composables.erase(composable);
+    if (std::erase(_composables, composable) > 0) {
+        RenderRevision::bumpStructure();
+    }
 }
 
 void Scene::forEach(const std::function<void(const std::shared_ptr<Composable>&)>& f) const {
     std::ranges::for_each(_composables, f);
 }
+
+const std::vector<Scene::DrawRecord>& Scene::getRenderQueue() {
+    if (const auto revision = RenderRevision::getStructure(); revision != _structureRevision) {
+        // Read the transform revision first, any transform edit made while we rebuild triggers another refresh
+        _transformRevision = RenderRevision::getTransform();
+        _structureRevision = revision;
+        rebuildRenderQueue();
+    } else if (const auto transformRevision = RenderRevision::getTransform(); transformRevision != _transformRevision) {
+        _transformRevision = transformRevision;
+        refreshWorldTransforms();
+    }
+    return _renderQueue;
+}
+
+const glm::mat4& Scene::getWorldTransform(const uint32_t index) const {
+    return _worldTransforms[index];
+}
+
+void Scene::rebuildRenderQueue() {
+    _renderQueue.clear();
+    _transformables.assign(1, nullptr);
+    _transformParents.assign(1, 0);
+
+    for (const auto& composable : _composables) {
+        flatten(composable, composable.get(), 0);
+    }
+
+    // Replace pipeline, shader instance and vertex buffer pointers with dense ranks in order of first appearance,
+    // small enough to be packed into a single 64-bit key
+    auto pipelineRanks = std::unordered_map<VkPipeline, uint64_t>{};
+    auto instanceRanks = std::unordered_map<const ShaderInstance*, uint64_t>{};
+    auto vertexBufferRanks = std::unordered_map<const VertexBuffer*, uint64_t>{};
+    const auto rank = []<typename T>(std::unordered_map<T, uint64_t>& ranks, const T key) {
+        return ranks.try_emplace(key, ranks.size()).first->second;
+    };
+
+    static constexpr auto RANK_BITS = 20;
+    static constexpr auto RANK_MASK = (1ull << RANK_BITS) - 1;
+    for (auto& record : _renderQueue) {
+        if (record.drawable == nullptr) {
+            record.sortKey = UINT64_MAX;
+            continue;
+        }
+        const auto instance = record.drawable->getShaderInstanceAt(record.primitive);
+        const auto pipeline = static_cast<VkPipeline>(instance->getShader()->getNativePipeline());
+        record.sortKey =
+            (rank(pipelineRanks, pipeline) & RANK_MASK) << 2 * RANK_BITS |
+            (rank(instanceRanks, instance) & RANK_MASK) << RANK_BITS |
+            (rank(vertexBufferRanks, record.drawable->getVertexBufferAt(record.primitive)) & RANK_MASK);
+    }
+
+    // A stable sort keeps records of equal keys in insertion and tree order
+    std::ranges::stable_sort(_renderQueue, {}, &DrawRecord::sortKey);
+
+    _worldTransforms.resize(_transformables.size());
+    refreshWorldTransforms();
+}
+
+void Scene::refreshWorldTransforms() {
+    _worldTransforms[0] = glm::mat4{ 1.0f };
+    for (std::size_t i = 1; i < _transformables.size(); ++i) {
+        _worldTransforms[i] = _worldTransforms[_transformParents[i]] * _transformables[i]->getTransform();
+    }
+}
+
+void Scene::flatten(
+    const std::shared_ptr<Composable>& composable,
+    const Composable* const root,
+    const uint32_t parentTransform
+) {
+    // Anything but a Drawable records its own subtree through the Composable interface
+    const auto drawable = dynamic_cast<const Drawable*>(composable.get());
+    if (drawable == nullptr) {
+        _renderQueue.push_back({ 0, root, nullptr, 0, composable.get(), parentTransform });
+        return;
+    }
+
+    const auto transform = static_cast<uint32_t>(_transformables.size());
+    _transformables.push_back(drawable);
+    _transformParents.push_back(parentTransform);
+
+    for (uint32_t i = 0; i < drawable->getPrimitiveCount(); ++i) {
+        _renderQueue.push_back({ 0, root, drawable, i, nullptr, transform });
+    }
+    for (const auto& child : drawable->getChildren()) {
+        flatten(child, root, transform);
+    }
+}
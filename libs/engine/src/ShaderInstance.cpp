@@ -3,39 +3,46 @@
 #include "engine/UniformBuffer.h"
 #include "engine/Texture.h"
 #include "engine/Sampler.h"
+#include "engine/StorageBuffer.h"
+
+#include "RenderRevision.h"
 
 #include <ranges>
-#include <engine/StorageBuffer.h>
 
 
 ShaderInstance::ShaderInstance(
     const Shader* const shader,
-    const vk::DescriptorPool& descriptorPool,
     const std::array<vk::DescriptorSet, Renderer::getMaxFramesInFlight()>& descriptorSets
 ) : _shader{ shader },
-    _descriptorPool{ descriptorPool },
     _descriptorSets{ descriptorSets } {
 }
 
+void ShaderInstance::invalidate(const uint32_t binding) const {
+    if (!(_shader->getDescriptorBindingFlags(binding) & vk::DescriptorBindingFlagBits::eUpdateAfterBind)) {
+        RenderRevision::bump();
+    }
+}
+
 void ShaderInstance::setDescriptor(
     const uint32_t binding,
     const UniformBuffer* const uniformBuffer,
     const Engine& engine
 ) const {
-    const auto device = engine.getNativeDevice();
-
+    auto bufferInfos = std::array<vk::DescriptorBufferInfo, Renderer::getMaxFramesInFlight()>{};
+    auto descriptorWrites = std::array<vk::WriteDescriptorSet, Renderer::getMaxFramesInFlight()>{};
     for (uint32_t i = 0; i < Renderer::getMaxFramesInFlight(); ++i) {
-        const auto bufferInfo = vk::DescriptorBufferInfo{
+        bufferInfos[i] = vk::DescriptorBufferInfo{
             uniformBuffer->getNativeBuffer(),
             i * uniformBuffer->getBufferSize(),  // byte offset to the buffer for the i-th frame
             uniformBuffer->getDataSize()         // we are actually binding a subset of this buffer portion
         };
-
-        const auto descriptorWrites = std::array{
-            vk::WriteDescriptorSet{ _descriptorSets[i], binding, 0, 1, vk::DescriptorType::eUniformBuffer, {}, &bufferInfo },
-        };
-        device.updateDescriptorSets(descriptorWrites, {});
+        descriptorWrites[i] = vk::WriteDescriptorSet{
+            _descriptorSets[i], binding, 0, 1, vk::DescriptorType::eUniformBuffer, {}, &bufferInfos[i] };
     }
+
+    // A single call for all frames
+    engine.getNativeDevice().updateDescriptorSets(descriptorWrites, {});
+    invalidate(binding);
 }
 
 void ShaderInstance::setDescriptor(
@@ -43,8 +50,6 @@ void ShaderInstance::setDescriptor(
     const std::vector<StorageBuffer*>& buffers,
     const Engine& engine
 ) const {
-    const auto device = engine.getNativeDevice();
-
     const auto toDescriptorBufferInfo = [](const StorageBuffer* buffer) {
         auto bufferInfo = vk::DescriptorBufferInfo{};
         bufferInfo.buffer = buffer->getNativeBuffer();
@@ -52,20 +57,56 @@ void ShaderInstance::setDescriptor(
         bufferInfo.range = buffer->getBufferSize();
         return bufferInfo;
     };
-    for (uint32_t i = 0; i < Renderer::getMaxFramesInFlight(); ++i) {
-        const auto bufferInfos = buffers | std::views::transform(toDescriptorBufferInfo) | std::ranges::to<std::vector>();
 
-        auto writeDescriptor = vk::WriteDescriptorSet{};
+    // Storage buffers are the same for every frame, the buffer infos can be shared by all writes
+    const auto bufferInfos = buffers | std::views::transform(toDescriptorBufferInfo) | std::ranges::to<std::vector>();
+    auto descriptorWrites = std::array<vk::WriteDescriptorSet, Renderer::getMaxFramesInFlight()>{};
+    for (uint32_t i = 0; i < Renderer::getMaxFramesInFlight(); ++i) {
+        auto& writeDescriptor = descriptorWrites[i];
         writeDescriptor.dstSet = _descriptorSets[i];
         writeDescriptor.dstBinding = binding;
         writeDescriptor.dstArrayElement = 0;
         writeDescriptor.descriptorCount = static_cast<uint32_t>(buffers.size());
         writeDescriptor.descriptorType = vk::DescriptorType::eStorageBuffer;
         writeDescriptor.pBufferInfo = bufferInfos.data();
+    }
+
+    engine.getNativeDevice().updateDescriptorSets(descriptorWrites, {});
+    invalidate(binding);
+}
 
-        const auto descriptorWrites = std::array{ writeDescriptor };
-        device.updateDescriptorSets(descriptorWrites, {});
+void ShaderInstance::setDescriptor(
+    const uint32_t binding,
+    const uint32_t arrayElement,
+    const StorageBuffer* const buffer,
+    const Engine& engine
+) const {
+    const auto bufferInfo = vk::DescriptorBufferInfo{ buffer->getNativeBuffer(), 0, buffer->getBufferSize() };
+    auto descriptorWrites = std::array<vk::WriteDescriptorSet, Renderer::getMaxFramesInFlight()>{};
+    for (uint32_t i = 0; i < Renderer::getMaxFramesInFlight(); ++i) {
+        descriptorWrites[i] = vk::WriteDescriptorSet{
+            _descriptorSets[i], binding, arrayElement, 1, vk::DescriptorType::eStorageBuffer, {}, &bufferInfo };
     }
+
+    engine.getNativeDevice().updateDescriptorSets(descriptorWrites, {});
+    invalidate(binding);
+}
+
+void ShaderInstance::setDescriptor(
+    const uint32_t frameIndex,
+    const uint32_t binding,
+    const uint32_t arrayElement,
+    const StorageBuffer* const buffer,
+    const Engine& engine
+) const {
+    const auto bufferInfo = vk::DescriptorBufferInfo{ buffer->getNativeBuffer(), 0, buffer->getBufferSize() };
+    const auto descriptorWrites = std::array{
+        vk::WriteDescriptorSet{
+            _descriptorSets[frameIndex], binding, arrayElement, 1, vk::DescriptorType::eStorageBuffer, {}, &bufferInfo },
+    };
+
+    engine.getNativeDevice().updateDescriptorSets(descriptorWrites, {});
+    invalidate(binding);
 }
 
 void ShaderInstance::setDescriptor(
@@ -74,27 +115,22 @@ void ShaderInstance::setDescriptor(
     const std::unique_ptr<Sampler>& sampler,
     const Engine& engine
 ) const {
-    const auto device = engine.getNativeDevice();
-
+    const auto imageInfo = vk::DescriptorImageInfo{
+        sampler->getNativeSampler(), texture->getNativeImageView(), vk::ImageLayout::eShaderReadOnlyOptimal };
+    auto descriptorWrites = std::array<vk::WriteDescriptorSet, Renderer::getMaxFramesInFlight()>{};
     for (uint32_t i = 0; i < Renderer::getMaxFramesInFlight(); ++i) {
-        const auto imageInfo = vk::DescriptorImageInfo{
-            sampler->getNativeSampler(), texture->getNativeImageView(), vk::ImageLayout::eShaderReadOnlyOptimal };
-
-        const auto descriptorWrites = std::array{
-            vk::WriteDescriptorSet{ _descriptorSets[i], binding, 0, 1, vk::DescriptorType::eCombinedImageSampler, &imageInfo },
-        };
-        device.updateDescriptorSets(descriptorWrites, {});
+        descriptorWrites[i] = vk::WriteDescriptorSet{
+            _descriptorSets[i], binding, 0, 1, vk::DescriptorType::eCombinedImageSampler, &imageInfo };
     }
+
+    engine.getNativeDevice().updateDescriptorSets(descriptorWrites, {});
+    invalidate(binding);
 }
 
 const Shader* ShaderInstance::getShader() const {
     return _shader;
 }
 
-vk::DescriptorPool ShaderInstance::getNativeDescriptorPool() const {
-    return _descriptorPool;
-}
-
 const vk::DescriptorSet& ShaderInstance::getNativeDescriptorSetAt(const uint32_t frame) const {
     return _descriptorSets[frame];
 }
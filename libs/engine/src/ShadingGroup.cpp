@@ -0,0 +1,144 @@
+#include "engine/ShadingGroup.h"
+#include "engine/Engine.h"
+#include "engine/Renderer.h"
+#include "engine/Shader.h"
+#include "engine/SwapChain.h"
+#include "engine/Trace.h"
+
+#include "WorkerPool.h"
+
+#include <plog/Log.h>
+
+#include <algorithm>
+#include <thread>
+
+
+ShadingGroup::Builder& ShadingGroup::Builder::shader(const Shader* const shader) {
+    _shader = shader;
+    return *this;
+}
+
+ShadingGroup::Builder& ShadingGroup::Builder::threadCount(const uint32_t count) {
+    if (count == 0) {
+        PLOGE << "Received zero thread count for a ShadingGroup";
+        throw std::invalid_argument("Thread count is zero");
+    }
+    _threadCount = std::min(count, MAX_THREAD_COUNT);
+    return *this;
+}
+
+std::shared_ptr<ShadingGroup> ShadingGroup::Builder::build(const Engine& engine, const SwapChain& swapChain) {
+    if (_shader == nullptr) {
+        PLOGE << "Constructing a ShadingGroup without a shader";
+        throw std::runtime_error("Missing shader");
+    }
+
+    const auto threadCount = _threadCount > 0
+        ? _threadCount
+        : std::clamp(std::thread::hardware_concurrency(), 1u, MAX_THREAD_COUNT);
+
+    // Each worker resets its whole pool at the start of a frame, which is cheaper than resetting individual buffers
+    const auto device = engine.getNativeDevice();
+    auto commandPools = std::vector<vk::CommandPool>{};
+    auto commandBuffers = std::vector<vk::CommandBuffer>{};
+    for (uint32_t i = 0; i < threadCount * Renderer::getMaxFramesInFlight(); ++i) {
+        const auto pool = device.createCommandPool(
+            { vk::CommandPoolCreateFlagBits::eTransient, swapChain.getGraphicsQueueFamily() });
+        const auto allocInfo = vk::CommandBufferAllocateInfo{ pool, vk::CommandBufferLevel::eSecondary, 1 };
+        commandPools.push_back(pool);
+        commandBuffers.push_back(device.allocateCommandBuffers(allocInfo)[0]);
+    }
+
+    return std::make_shared<ShadingGroup>(_shader, device, std::move(commandPools), std::move(commandBuffers), threadCount);
+}
+
+ShadingGroup::ShadingGroup(
+    const Shader* const shader,
+    const vk::Device& device,
+    std::vector<vk::CommandPool>&& commandPools,
+    std::vector<vk::CommandBuffer>&& commandBuffers,
+    const uint32_t threadCount
+) : _shader{ shader },
+    _device{ device },
+    _threadCount{ threadCount },
+    _commandPools{ std::move(commandPools) },
+    _commandBuffers{ std::move(commandBuffers) },
+    _workerPool{ std::make_unique<WorkerPool>(threadCount) } {
+}
+
+// Defined here where WorkerPool is a complete type
+ShadingGroup::~ShadingGroup() = default;
+
+std::vector<vk::CommandBuffer> ShadingGroup::recordDrawingCommands(
+    const uint32_t frameIndex,
+    [[maybe_unused]] const vk::CommandBuffer& commandBuffer,
+    [[maybe_unused]] DrawState& state,
+    const vk::CommandBufferInheritanceInfo& inheritanceInfo,
+    const glm::mat4& cameraMatrix,
+    const glm::mat4& currentTransform,
+    const std::function<void(const vk::CommandBuffer&)>& onPipelineBound
+) const {
+    if (_children.empty()) return {};
+
+    // Take a stable snapshot of the children so that workers can index into it
+    const auto children = std::vector(_children.begin(), _children.end());
+    const auto transform = currentTransform * _localTransform;
+
+    const auto workerCount = std::min(_threadCount, static_cast<uint32_t>(children.size()));
+    const auto chunkSize = (static_cast<uint32_t>(children.size()) + workerCount - 1) / workerCount;
+
+    _workerPool->parallelFor(workerCount, [&](const uint32_t worker) {
+        const auto scope = Trace::Scope{ "Record shading group" };
+        const auto slot = frameIndex * _threadCount + worker;
+        _device.resetCommandPool(_commandPools[slot]);
+
+        // Secondary command buffers don't inherit any state from the primary, we have to bind the pipeline and
+        // set all dynamic states for each of them. The Renderer may execute them again in later frames
+        const auto& buffer = _commandBuffers[slot];
+        buffer.begin({ vk::CommandBufferUsageFlagBits::eRenderPassContinue, &inheritanceInfo });
+        auto workerState = DrawState{};
+        bindPipeline(buffer, workerState);
+        onPipelineBound(buffer);
+        workerState.dynamicStatesSet = true;
+
+        const auto first = worker * chunkSize;
+        const auto last = std::min(first + chunkSize, static_cast<uint32_t>(children.size()));
+        for (auto i = first; i < last; ++i) {
+            children[i]->recordDrawingCommands(frameIndex, buffer, workerState, cameraMatrix, transform);
+        }
+
+        buffer.end();
+    });
+
+    const auto first = _commandBuffers.begin() + frameIndex * _threadCount;
+    return std::vector<vk::CommandBuffer>(first, first + workerCount);
+}
+
+void ShadingGroup::recordDrawingCommands(
+    const uint32_t frameIndex,
+    const vk::CommandBuffer& commandBuffer,
+    DrawState& state,
+    const glm::mat4& cameraMatrix,
+    const glm::mat4& currentTransform
+) const {
+    // When nested in another group, we record inline into that group's buffer. Dynamic states set for the outer
+    // pipeline remain valid after binding ours since all graphics pipelines share the same set of dynamic states.
+    bindPipeline(commandBuffer, state);
+
+    const auto transform = currentTransform * _localTransform;
+    for (const auto& child : _children) {
+        child->recordDrawingCommands(frameIndex, commandBuffer, state, cameraMatrix, transform);
+    }
+}
+
+void ShadingGroup::bindPipeline(const vk::CommandBuffer& commandBuffer, DrawState& state) const {
+    const auto pipeline = _shader->getNativePipeline();
+    if (pipeline == state.pipeline) return;
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+    state.pipeline = pipeline;
+    if (_shader->getNativePipelineLayout() != state.pipelineLayout) {
+        state.pipelineLayout = _shader->getNativePipelineLayout();
+        state.descriptorSet = nullptr;
+    }
+}
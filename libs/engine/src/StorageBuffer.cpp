@@ -11,34 +11,100 @@ StorageBuffer::Builder & StorageBuffer::Builder::byteSize(const std::size_t size
     return *this;
 }
 
+StorageBuffer::Builder& StorageBuffer::Builder::deviceAddress() {
+    _deviceAddress = true;
+    return *this;
+}
+
+StorageBuffer::Builder& StorageBuffer::Builder::concurrent() {
+    _concurrent = true;
+    return *this;
+}
+
+StorageBuffer::Builder& StorageBuffer::Builder::hostReadable() {
+    _hostReadable = true;
+    return *this;
+}
+
 StorageBuffer* StorageBuffer::Builder::build(const Engine& engine) const {
-    if (_bufferSize > engine.getLimitMaxStorageBufferRange()) {
+    // Buffers read through device addresses are not limited by the range a descriptor can cover
+    if (!_deviceAddress && _bufferSize > engine.getLimitMaxStorageBufferRange()) {
         PLOGE << "Buffer byte size is bigger than the maximum limit of: " << engine.getLimitMaxStorageBufferRange();
         throw std::runtime_error("Buffer byte size is too big");
     }
 
-    constexpr auto usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst;
+    auto usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst;
+    if (_deviceAddress) {
+        usage |= vk::BufferUsageFlagBits::eShaderDeviceAddress;
+    }
 
-    // Allocate a dedicated buffer in the GPU
     const auto allocator = engine.getResourceAllocator();
     auto allocation = VmaAllocation{};
-    const auto buffer = allocator->allocateDedicatedBuffer(_bufferSize, usage, &allocation);
+    if (_hostReadable) {
+        auto allocationInfo = VmaAllocationInfo{};
+        const auto buffer = allocator->allocateReadbackBuffer(
+            _bufferSize, usage, ResourceKind::StorageBuffer, &allocation, &allocationInfo);
+        const auto address = _deviceAddress ? engine.getNativeDevice().getBufferAddress({ buffer }) : vk::DeviceAddress{ 0 };
+        return new StorageBuffer{ _bufferSize, buffer, allocation, address, static_cast<std::byte*>(allocationInfo.pMappedData) };
+    }
 
-    return new StorageBuffer{ _bufferSize, buffer, allocation };
+    // Allocate a dedicated buffer in the GPU
+    auto queueFamilies = std::vector<uint32_t>{};
+    if (_concurrent && engine.getComputeQueueFamily() != engine.getGraphicsQueueFamily()) {
+        queueFamilies = { engine.getGraphicsQueueFamily(), engine.getComputeQueueFamily() };
+    }
+    const auto buffer = allocator->allocateDedicatedBuffer(
+        _bufferSize, usage, ResourceKind::StorageBuffer, &allocation, queueFamilies);
+
+    const auto address = _deviceAddress ? engine.getNativeDevice().getBufferAddress({ buffer }) : vk::DeviceAddress{ 0 };
+    return new StorageBuffer{ _bufferSize, buffer, allocation, address, nullptr };
 }
 
 StorageBuffer::StorageBuffer(
     const std::size_t bufferSize,
     const vk::Buffer& buffer,
-    void* allocation
-) : Buffer{ buffer, allocation },
-    _bufferSize{ bufferSize } {
+    void* allocation,
+    const vk::DeviceAddress address,
+    std::byte* const pMappedData
+) : Buffer{ buffer, allocation, pMappedData },
+    _bufferSize{ bufferSize },
+    _deviceAddress{ address } {
 }
 
 void StorageBuffer::setData(const void* data, const Engine& engine) const {
     transferBufferData(_bufferSize, data, 0, engine);
 }
 
-uint32_t StorageBuffer::getBufferSize() const {
+void StorageBuffer::setData(
+    const void* data,
+    const std::size_t byteOffset,
+    const std::size_t byteSize,
+    const Engine& engine
+) const {
+    if (byteOffset + byteSize > _bufferSize) {
+        PLOGE << "Writing " << byteSize << " bytes at offset " << byteOffset << " overflows a buffer of " << _bufferSize;
+        throw std::out_of_range("Data range exceeds the buffer size");
+    }
+    transferBufferData(byteSize, data, byteOffset, engine);
+}
+
+void StorageBuffer::getData(void* const data, const std::size_t byteSize, const Engine& engine) const {
+    if (_pMappedData == nullptr) {
+        PLOGE << "Reading back a storage buffer that was not built host readable";
+        throw std::runtime_error("Buffer is not host readable");
+    }
+    if (byteSize > _bufferSize) {
+        PLOGE << "Reading " << byteSize << " bytes overflows a buffer of " << _bufferSize;
+        throw std::out_of_range("Data range exceeds the buffer size");
+    }
+    engine.getResourceAllocator()->invalidateAllocation(static_cast<VmaAllocation>(getAllocation()));
+    memcpy(data, _pMappedData, byteSize);
+}
+
+std::size_t StorageBuffer::getBufferSize() const {
     return _bufferSize;
 }
+
+vk::DeviceAddress StorageBuffer::getDeviceAddress() const {
+    return _deviceAddress;
+}
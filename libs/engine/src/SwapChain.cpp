@@ -110,7 +110,8 @@ void SwapChain::createSwapChain(const vk::Device &device) {
     const auto presentModes = _physicalDevice.getSurfacePresentModesKHR(_surface);
 
     const auto surfaceFormat = chooseSwapSurfaceFormat(formats);
-    const auto presentMode = chooseSwapPresentMode(presentModes);
+    const auto presentMode = chooseSwapPresentMode(presentModes, _requestedPresentMode);
+    _presentMode = presentMode;
     const auto extent = chooseSwapExtent(capabilities, _window);
 
     // We have to decide how many images we would like to have in the swap chain. Simply sticking to the minimum
@@ -187,7 +188,8 @@ void SwapChain::createColorResources(const vk::Device& device) {
     auto allocation = VmaAllocation{};
     _colorImage = _allocator->allocateDedicatedImage(
         _imageExtent.width, _imageExtent.height, 1, mipLevels, _msaaSamples, vk::ImageType::e2D, _imageFormat,
-        vk::ImageTiling::eOptimal, Usage::eTransientAttachment | Usage::eColorAttachment, &allocation);
+        vk::ImageTiling::eOptimal, Usage::eTransientAttachment | Usage::eColorAttachment, ResourceKind::SwapChainTarget,
+        &allocation);
     _colorImageAllocation = allocation;
 
     const auto viewInfo = vk::ImageViewCreateInfo{
@@ -216,7 +218,8 @@ void SwapChain::createDepthResources(const vk::Device& device) {
     auto allocation = VmaAllocation{};
     _depthImage = _allocator->allocateDedicatedImage(
         _imageExtent.width, _imageExtent.height, 1, mipLevels, _msaaSamples, vk::ImageType::e2D,
-        _depthFormat, Tiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, &allocation);
+        _depthFormat, Tiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, ResourceKind::SwapChainTarget,
+        &allocation);
     _depthImageAllocation = allocation;
 
     // Create depth image view
@@ -342,8 +345,10 @@ bool SwapChain::acquire(const vk::Device& device, const uint64_t timeout, const
 void SwapChain::present(const vk::Device& device, uint32_t imageIndex, const vk::Semaphore& semaphore) {
     const auto presentInfo = vk::PresentInfoKHR{ semaphore, _swapChain, imageIndex };
     if (const auto result = _presentQueue.presentKHR(&presentInfo);
-        result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || _framebufferResized) {
+        result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR ||
+        _framebufferResized || _presentModeChanged) {
         _framebufferResized = false;
+        _presentModeChanged = false;
         recreate(device);
     } else if (result != vk::Result::eSuccess) {
         throw std::runtime_error("Failed to present a swap chain image!");
@@ -412,14 +417,30 @@ vk::SurfaceFormatKHR SwapChain::chooseSwapSurfaceFormat(const std::vector<vk::Su
     return availableFormats[0];
 }
 
-vk::PresentModeKHR SwapChain::chooseSwapPresentMode(const std::vector<vk::PresentModeKHR> &availablePresentModes) {
+vk::PresentModeKHR SwapChain::chooseSwapPresentMode(
+    const std::vector<vk::PresentModeKHR>& availablePresentModes,
+    const PresentMode requestedMode
+) {
+    const auto available = [&availablePresentModes](const vk::PresentModeKHR mode) {
+        return std::ranges::find(availablePresentModes, mode) != availablePresentModes.end();
+    };
+
+    // IMMEDIATE presents right away and may tear, it gives the lowest latency for latency-sensitive operators
+    if (requestedMode == PresentMode::Immediate && available(vk::PresentModeKHR::eImmediate)) {
+        return vk::PresentModeKHR::eImmediate;
+    }
+
     // MAILBOX is a very nice trade-off if energy usage is not a concern. It allows us to avoid tearing while still
     // maintaining a fairly low latency by rendering new images that are as up-to-date as possible right until
-    // the vertical blank. On mobile devices, where energy usage is more important, FIFO is more preferable
-    constexpr auto preferredMode = vk::PresentModeKHR::eMailbox;
-    if (const auto found = std::ranges::find(availablePresentModes, preferredMode); found != availablePresentModes.end()) {
-        return preferredMode;
+    // the vertical blank. On battery-powered devices, where energy usage is more important, FIFO is more preferable
+    if (requestedMode != PresentMode::Fifo && available(vk::PresentModeKHR::eMailbox)) {
+        return vk::PresentModeKHR::eMailbox;
+    }
+    if (requestedMode != PresentMode::Fifo) {
+        PLOGW << "Requested present mode is not supported by the surface, falling back to FIFO";
     }
+
+    // FIFO is the only mode guaranteed to be available
     return vk::PresentModeKHR::eFifo;
 }
 
@@ -503,6 +524,20 @@ vk::Format SwapChain::findSupportedFormat(
 
 }
 
+void SwapChain::setPresentMode(const PresentMode mode) {
+    if (mode == _requestedPresentMode) return;
+    _requestedPresentMode = mode;
+    _presentModeChanged = true;
+}
+
+SwapChain::PresentMode SwapChain::getPresentMode() const {
+    switch (_presentMode) {
+        case vk::PresentModeKHR::eImmediate: return PresentMode::Immediate;
+        case vk::PresentModeKHR::eMailbox:   return PresentMode::Mailbox;
+        default: return PresentMode::Fifo;
+    }
+}
+
 void SwapChain::setOnFramebufferResize(const std::function<void(uint32_t, uint32_t)>& callback) {
     _customFramebufferResizeCallback = callback;
 }
@@ -73,7 +73,7 @@ std::shared_ptr<Texture> Texture::Builder::build(const Engine& engine) const {
     // Create a dedicated image
     auto allocation = VmaAllocation{};
     const auto image = allocator->allocateDedicatedImage(
-        _width, _height, 1, mipLevels, samples, type, _format, tiling, usage, &allocation);
+        _width, _height, 1, mipLevels, samples, type, _format, tiling, usage, ResourceKind::Texture, &allocation);
 
     // Create an image view
     constexpr auto aspectFlags = vk::ImageAspectFlagBits::eColor;
@@ -0,0 +1,92 @@
+#include "engine/Trace.h"
+
+#include <plog/Log.h>
+
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    std::chrono::steady_clock::time_point begin;
+    std::chrono::steady_clock::time_point end;
+    int threadId;
+};
+
+static std::atomic_bool mEnabled{ false };
+static std::mutex mEventsMutex{};
+static std::vector<TraceEvent> mEvents{};
+static std::filesystem::path mPath{};
+static std::chrono::steady_clock::time_point mOrigin{};
+
+// Chrome traces identify threads with small integers, hand one out to each thread the first time it records an event
+static int getThreadId() {
+    static std::atomic_int nextThreadId{ 0 };
+    thread_local const auto threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return threadId;
+}
+
+void Trace::start(const std::filesystem::path& path) {
+    std::lock_guard lock(mEventsMutex);
+    mPath = path;
+    mOrigin = std::chrono::steady_clock::now();
+    mEvents.clear();
+    mEvents.reserve(1 << 16);
+    mEnabled.store(true, std::memory_order_release);
+}
+
+void Trace::stop() {
+    if (!mEnabled.exchange(false, std::memory_order_acq_rel)) return;
+
+    std::lock_guard lock(mEventsMutex);
+    auto file = std::ofstream{ mPath };
+    if (!file.is_open()) {
+        PLOGE << "Could not write trace to " << mPath.string();
+        return;
+    }
+
+    using Micros = std::chrono::duration<double, std::micro>;
+    file << "{\"traceEvents\":[\n";
+    for (std::size_t i = 0; i < mEvents.size(); ++i) {
+        const auto& [name, category, begin, end, threadId] = mEvents[i];
+        file << std::format(
+            R"({{"name":"{}","cat":"{}","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":0,"tid":{}}})",
+            name, category, Micros(begin - mOrigin).count(), Micros(end - begin).count(), threadId);
+        file << (i + 1 < mEvents.size() ? ",\n" : "\n");
+    }
+    file << "],\"displayTimeUnit\":\"ms\"}\n";
+
+    PLOGI << "Wrote " << mEvents.size() << " trace events to " << mPath.string();
+    mEvents.clear();
+}
+
+bool Trace::enabled() noexcept {
+    return mEnabled.load(std::memory_order_relaxed);
+}
+
+void Trace::record(
+    const char* const name, const char* const category,
+    const std::chrono::steady_clock::time_point begin, const std::chrono::steady_clock::time_point end
+) {
+    const auto threadId = getThreadId();
+    std::lock_guard lock(mEventsMutex);
+    mEvents.emplace_back(name, category, begin, end, threadId);
+}
+
+Trace::Scope::Scope(const char* const name, const char* const category) noexcept
+    : _name{ name }, _category{ category } {
+    if (enabled()) {
+        _begin = std::chrono::steady_clock::now();
+    }
+}
+
+Trace::Scope::~Scope() {
+    // Scopes that began before tracing was enabled have no meaningful begin time
+    if (enabled() && _begin != std::chrono::steady_clock::time_point{}) {
+        record(_name, _category, _begin, std::chrono::steady_clock::now());
+    }
+}
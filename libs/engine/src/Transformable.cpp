@@ -1,10 +1,18 @@
 #include "engine/Transformable.h"
 
+#include "RenderRevision.h"
+
 
 void Transformable::setTransform(const glm::mat4& transform) {
     _localTransform = transform;
+    RenderRevision::bumpTransform();
 }
 
 void Transformable::setTransform(glm::mat4&& transform) noexcept {
     _localTransform = std::move(transform);
+    RenderRevision::bumpTransform();
+}
+
+const glm::mat4& Transformable::getTransform() const noexcept {
+    return _localTransform;
 }
@@ -32,7 +32,7 @@ UniformBuffer* UniformBuffer::Builder::build(const Engine& engine) const {
     auto allocationInfo = VmaAllocationInfo{};  // allocation info is a struct
     const auto buffer = allocator->allocatePersistentBuffer(
         bufferSize * Renderer::getMaxFramesInFlight(),  // as many buffers of bufferSize as for each in-flight frame
-        usage, &allocation, &allocationInfo);
+        usage, ResourceKind::UniformBuffer, &allocation, &allocationInfo);
 
     return new UniformBuffer{ bufferSize, _dataSize, buffer, allocation, static_cast<std::byte*>(allocationInfo.pMappedData) };
 }
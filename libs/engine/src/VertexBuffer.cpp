@@ -25,7 +25,7 @@ VertexBuffer::Builder& VertexBuffer::Builder::binding(const uint32_t binding, co
         PLOGE << std::format("Binding index must be in the range 0 to {}, received: {}", bindingCount - 1, binding);
         throw std::invalid_argument("Received invalid binding index");
     }
-    // We're not supporting instanced rendering at this moment
+    // Per-instance data goes to an InstanceBuffer, every binding here advances per vertex
     auto bindingDescription = VkVertexInputBindingDescription2EXT{};
     bindingDescription.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT;
     bindingDescription.binding = binding;
@@ -92,7 +92,7 @@ VertexBuffer* VertexBuffer::Builder::build(const Engine& engine) {
     // Allocate a dedicated buffer in the GPU
     const auto allocator = engine.getResourceAllocator();
     auto allocation = VmaAllocation{};
-    const auto buffer = allocator->allocateDedicatedBuffer(bufferSize, usage, &allocation);
+    const auto buffer = allocator->allocateDedicatedBuffer(bufferSize, usage, ResourceKind::GeometryBuffer, &allocation);
 
     return new VertexBuffer{
         std::move(_bindings), std::move(_attributes), std::move(offsets), _vertexCount, buffer, allocation };
@@ -109,6 +109,7 @@ VertexBuffer::VertexBuffer(
     _bindingDescriptions{ std::move(bindings) },
     _attributeDescriptions{ std::move(attributes) },
     _offsets{ std::move(offsets) },
+    _nativeBuffers(_offsets.size(), buffer),
     _vertexCount{ vertexCount } {
 }
 
@@ -127,3 +128,7 @@ const std::vector<VkVertexInputAttributeDescription2EXT>& VertexBuffer::getAttri
 const std::vector<vk::DeviceSize>& VertexBuffer::getOffsets() const {
     return _offsets;
 }
+
+const std::vector<vk::Buffer>& VertexBuffer::getNativeBuffers() const {
+    return _nativeBuffers;
+}
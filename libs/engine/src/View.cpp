@@ -2,6 +2,8 @@
 #include "engine/Engine.h"
 #include "engine/SwapChain.h"
 
+#include "RenderRevision.h"
+
 #include <plog/Log.h>
 
 #include <ranges>
@@ -13,6 +15,7 @@ std::unique_ptr<View> View::create(const SwapChain& swapChain) {
 
 void View::setCamera(const std::shared_ptr<Camera>& camera) {
     _camera = camera;
+    RenderRevision::bump();
 }
 
 std::shared_ptr<Camera> View::getCamera() const {
@@ -21,6 +24,7 @@ std::shared_ptr<Camera> View::getCamera() const {
 
 void View::setScene(const std::shared_ptr<Scene>& scene) {
     _scene = scene;
+    RenderRevision::bump();
 }
 
 std::shared_ptr<Scene> View::getScene() const {
@@ -34,6 +38,7 @@ View::View(const vk::Extent2D& swapImageExtent) :
 
 void View::setViewport(const float x, const float y, const float width, const float height) {
     _viewport = vk::Viewport{ x, y, width, height };
+    RenderRevision::bump();
 }
 
 vk::Viewport View::getNativeViewport() const {
@@ -42,6 +47,7 @@ vk::Viewport View::getNativeViewport() const {
 
 void View::setScissor(const int32_t offsetX, const int32_t offsetY, const uint32_t extentX, const uint32_t extentY) {
     _scissor = vk::Rect2D{ vk::Offset2D{ offsetX, offsetY }, vk::Extent2D{ extentX, extentY } };
+    RenderRevision::bump();
 }
 
 vk::Rect2D View::getNativeScissor() const {
@@ -54,6 +60,7 @@ void View::setPolygonMode(const PolygonMode mode) {
         case PolygonMode::Line:  _polygonMode = vk::PolygonMode::eLine; break;
         case PolygonMode::Point: _polygonMode = vk::PolygonMode::ePoint; break;
     }
+    RenderRevision::bump();
 }
 
 vk::PolygonMode View::getNativePolygonMode() const {
@@ -66,6 +73,7 @@ void View::setCullMode(const CullMode mode) {
         case CullMode::Back:      _cullMode = vk::CullModeFlagBits::eBack;         break;
         case CullMode::FrontBack: _cullMode = vk::CullModeFlagBits::eFrontAndBack; break;
     }
+    RenderRevision::bump();
 }
 
 vk::CullModeFlagBits View::getNativeCullMode() const {
@@ -77,6 +85,7 @@ void View::setFrontFace(const FrontFace direction) {
         case FrontFace::Clockwise:        _frontFace = vk::FrontFace::eClockwise; break;
         case FrontFace::CounterClockwise: _frontFace = vk::FrontFace::eCounterClockwise; break;
     }
+    RenderRevision::bump();
 }
 
 vk::FrontFace View::getNativeFrontFace() const {
@@ -85,6 +94,7 @@ vk::FrontFace View::getNativeFrontFace() const {
 
 void View::setPrimitiveRestart(const bool enabled) {
     _primitveRestartEnabled = enabled;
+    RenderRevision::bump();
 }
 
 vk::Bool32 View::getNativePrimitiveRestartEnabled() const {
@@ -93,6 +103,7 @@ vk::Bool32 View::getNativePrimitiveRestartEnabled() const {
 
 void View::setLineWidth(const float width) {
     _lineWidth = std::max(1.0f, width);
+    RenderRevision::bump();
 }
 
 float View::getLineWidth() const {
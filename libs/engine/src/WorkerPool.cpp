@@ -0,0 +1,65 @@
+#include "WorkerPool.h"
+
+
+WorkerPool::WorkerPool(const uint32_t workerCount) {
+    _workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        _workers.emplace_back([this](const std::stop_token& stopToken) { work(stopToken); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    // Wake up parked workers so that they can observe the stop request
+    for (auto& worker : _workers) {
+        worker.request_stop();
+    }
+    _taskAvailable.notify_all();
+}
+
+void WorkerPool::parallelFor(const uint32_t taskCount, const std::function<void(uint32_t)>& task) {
+    if (taskCount == 0) return;
+
+    auto lock = std::unique_lock{ _mutex };
+    _task = &task;
+    _taskCount = taskCount;
+    _nextTask = 0;
+    _finishedTaskCount = 0;
+    _exception = nullptr;
+    _taskAvailable.notify_all();
+
+    _batchFinished.wait(lock, [this] { return _finishedTaskCount == _taskCount; });
+    _task = nullptr;
+    _taskCount = 0;
+
+    if (_exception) {
+        std::rethrow_exception(_exception);
+    }
+}
+
+uint32_t WorkerPool::getWorkerCount() const noexcept {
+    return static_cast<uint32_t>(_workers.size());
+}
+
+void WorkerPool::work(const std::stop_token& stopToken) {
+    auto lock = std::unique_lock{ _mutex };
+    while (_taskAvailable.wait(lock, stopToken, [this] { return _nextTask < _taskCount; })) {
+        const auto taskIndex = _nextTask++;
+        const auto task = _task;
+
+        lock.unlock();
+        auto exception = std::exception_ptr{};
+        try {
+            (*task)(taskIndex);
+        } catch (...) {
+            exception = std::current_exception();
+        }
+        lock.lock();
+
+        if (exception && !_exception) {
+            _exception = exception;
+        }
+        if (++_finishedTaskCount == _taskCount) {
+            _batchFinished.notify_one();
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// A fixed set of worker threads that stay parked until given a batch of tasks. Meant for per-frame work such as
+// recording secondary command buffers, where spawning threads every frame would eat into the time we save.
+class WorkerPool final {
+public:
+    explicit WorkerPool(uint32_t workerCount);
+    ~WorkerPool();
+
+    // Runs task(i) for every i in [0, taskCount) across the workers and blocks until all of them have finished.
+    // The first exception thrown by a task is rethrown on the calling thread.
+    void parallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& task);
+
+    [[nodiscard]] uint32_t getWorkerCount() const noexcept;
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+private:
+    void work(const std::stop_token& stopToken);
+
+    std::mutex _mutex{};
+    std::condition_variable_any _taskAvailable{};
+    std::condition_variable _batchFinished{};
+
+    const std::function<void(uint32_t)>* _task{ nullptr };
+    uint32_t _taskCount{ 0 };
+    uint32_t _nextTask{ 0 };
+    uint32_t _finishedTaskCount{ 0 };
+    std::exception_ptr _exception{};
+
+    // Declared last so that the threads are joined before any state they use is destroyed
+    std::vector<std::jthread> _workers{};
+};
@@ -0,0 +1,101 @@
+#include "DescriptorAllocator.h"
+
+#include <plog/Log.h>
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+
+
+// The first pool holds this many sets, each following pool twice as many as the previous one
+static constexpr uint32_t mInitialSetCount = 16;
+
+// How many times we grow in a single allocation before giving up, for layouts that would never fit
+static constexpr auto mMaxGrowAttempts = 4;
+
+// Expected number of descriptors of each type per set, the spectral shaders bind large storage buffer arrays
+static constexpr auto mDescriptorRatios = std::array{
+    std::pair{ vk::DescriptorType::eUniformBuffer, 4u },
+    std::pair{ vk::DescriptorType::eStorageBuffer, 64u },
+    std::pair{ vk::DescriptorType::eCombinedImageSampler, 2u },
+    std::pair{ vk::DescriptorType::eStorageImage, 2u },
+};
+
+
+DescriptorAllocator::DescriptorAllocator(const vk::Device& device) : _device{ device } {
+}
+
+vk::DescriptorPool DescriptorAllocator::createPool(const uint32_t maxSets) const {
+    auto poolSizes = std::vector<vk::DescriptorPoolSize>{};
+    for (const auto [type, ratio] : mDescriptorRatios) {
+        poolSizes.emplace_back(type, ratio * maxSets);
+    }
+    const auto poolInfo = vk::DescriptorPoolCreateInfo{
+        vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind, maxSets, poolSizes };
+    return _device.createDescriptorPool(poolInfo);
+}
+
+std::vector<vk::DescriptorSet> DescriptorAllocator::allocate(const vk::DescriptorSetLayout& layout, const uint32_t count) {
+    std::lock_guard lock(_mutex);
+
+    // Serve from released sets of the same layout first
+    auto sets = std::vector<vk::DescriptorSet>{};
+    if (const auto it = _freeSets.find(static_cast<VkDescriptorSetLayout>(layout)); it != _freeSets.end()) {
+        auto& freeSets = it->second;
+        while (!freeSets.empty() && sets.size() < count) {
+            sets.push_back(freeSets.back());
+            freeSets.pop_back();
+        }
+    }
+    if (sets.size() == count) {
+        return sets;
+    }
+
+    const auto layouts = std::vector(count - sets.size(), layout);
+    const auto tryAllocate = [&] {
+        if (_pools.empty()) return false;
+        try {
+            const auto allocInfo = vk::DescriptorSetAllocateInfo{ _pools.back(), layouts };
+            std::ranges::copy(_device.allocateDescriptorSets(allocInfo), std::back_inserter(sets));
+            return true;
+        } catch (const vk::OutOfPoolMemoryError&) {
+            return false;
+        } catch (const vk::FragmentedPoolError&) {
+            return false;
+        }
+    };
+
+    // Grow into a new pool whenever the current one is exhausted. Exhausted pools are kept alive until destruction
+    // since their sets may still be in use
+    for (auto attempt = 0; !tryAllocate(); ++attempt) {
+        if (attempt == mMaxGrowAttempts) {
+            PLOGE << "Could not allocate " << layouts.size() << " descriptor sets even from fresh descriptor pools";
+            throw std::runtime_error("Failed to allocate descriptor sets");
+        }
+        _poolSetCount = _poolSetCount == 0 ? mInitialSetCount : _poolSetCount * 2;
+        while (_poolSetCount < layouts.size()) _poolSetCount *= 2;
+        _pools.push_back(createPool(_poolSetCount));
+        PLOGD << "Created descriptor pool #" << _pools.size() << " of " << _poolSetCount << " sets";
+    }
+    return sets;
+}
+
+void DescriptorAllocator::release(const vk::DescriptorSetLayout& layout, const std::vector<vk::DescriptorSet>& sets) {
+    std::lock_guard lock(_mutex);
+    auto& freeSets = _freeSets[static_cast<VkDescriptorSetLayout>(layout)];
+    freeSets.insert(freeSets.end(), sets.begin(), sets.end());
+}
+
+void DescriptorAllocator::forget(const vk::DescriptorSetLayout& layout) {
+    // The layout handle may be reused by a new layout, whose allocations must not be served with these sets. They
+    // stay allocated until their pool is destroyed
+    std::lock_guard lock(_mutex);
+    _freeSets.erase(static_cast<VkDescriptorSetLayout>(layout));
+}
+
+DescriptorAllocator::~DescriptorAllocator() {
+    // Destroying a pool frees all sets allocated from it
+    for (const auto& pool : _pools) {
+        _device.destroyDescriptorPool(pool);
+    }
+}
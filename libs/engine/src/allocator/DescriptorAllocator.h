@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+
+// Hands out descriptor sets from a shared, growing list of descriptor pools instead of one pool per ShaderInstance.
+// When the current pool runs out, a new one twice as large gets created. Sets are never freed back to their pool:
+// releasing a set puts it on a free list keyed by its layout, from which the next allocation of the same layout is
+// served without touching any pool.
+//
+// All pools are created with UPDATE_AFTER_BIND, so that sets of layouts declaring update-after-bind bindings can be
+// allocated from them too.
+class DescriptorAllocator {
+public:
+    explicit DescriptorAllocator(const vk::Device& device);
+
+    [[nodiscard]] std::vector<vk::DescriptorSet> allocate(const vk::DescriptorSetLayout& layout, uint32_t count);
+
+    // The sets must no longer be in use by any pending command buffer
+    void release(const vk::DescriptorSetLayout& layout, const std::vector<vk::DescriptorSet>& sets);
+
+    // Drops the released sets of a layout about to be destroyed
+    void forget(const vk::DescriptorSetLayout& layout);
+
+    ~DescriptorAllocator();
+
+    DescriptorAllocator(const DescriptorAllocator&) = delete;
+    DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+private:
+    [[nodiscard]] vk::DescriptorPool createPool(uint32_t maxSets) const;
+
+    vk::Device _device;
+
+    std::mutex _mutex{};
+    std::vector<vk::DescriptorPool> _pools{};
+    uint32_t _poolSetCount{ 0 };
+
+    std::unordered_map<VkDescriptorSetLayout, std::vector<vk::DescriptorSet>> _freeSets{};
+};
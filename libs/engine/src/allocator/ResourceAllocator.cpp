@@ -39,12 +39,19 @@ ResourceAllocator* ResourceAllocator::Builder::build(
 vk::Buffer ResourceAllocator::allocateDedicatedBuffer(
     const std::size_t bufferSize,
     const vk::BufferUsageFlags usage,
-    VmaAllocation* allocation
+    const ResourceKind kind,
+    VmaAllocation* allocation,
+    const std::vector<uint32_t>& queueFamilies
 ) const {
     auto bufferCreateInfo = VkBufferCreateInfo{};
     bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferCreateInfo.usage = static_cast<VkBufferUsageFlags>(usage);
     bufferCreateInfo.size = bufferSize;
+    if (queueFamilies.size() > 1) {
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+        bufferCreateInfo.pQueueFamilyIndices = queueFamilies.data();
+    }
 
     auto allocInfo = VmaAllocationCreateInfo{};
     allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
@@ -53,9 +60,10 @@ vk::Buffer ResourceAllocator::allocateDedicatedBuffer(
 
     auto buffer = VkBuffer{};
     if (vmaCreateBuffer(_allocator, &bufferCreateInfo, &allocInfo, &buffer, allocation, nullptr) != VK_SUCCESS) {
-        PLOGE << "Could not create a dedicated buffer";
+        PLOGE << "Could not create a dedicated buffer of " << bufferSize << " bytes";
         throw std::runtime_error("Failed to create a dedicated buffer");
     }
+    track(*allocation, kind);
 
     return buffer;
 }
@@ -72,9 +80,10 @@ vk::Buffer ResourceAllocator::allocateStagingBuffer(const std::size_t bufferSize
 
     auto buffer = VkBuffer{};
     if (vmaCreateBuffer(_allocator, &bufferCreateInfo, &allocCreateInfo, &buffer, allocation, nullptr) != VK_SUCCESS) {
-        PLOGE << "Could not create staging buffer";
+        PLOGE << "Could not create staging buffer of " << bufferSize << " bytes";
         throw std::runtime_error("Failed to create staging buffer");
     }
+    track(*allocation, ResourceKind::Staging);
 
     return buffer;
 }
@@ -82,6 +91,7 @@ vk::Buffer ResourceAllocator::allocateStagingBuffer(const std::size_t bufferSize
 vk::Buffer ResourceAllocator::allocatePersistentBuffer(
     const std::size_t bufferSize,
     const vk::BufferUsageFlags usage,
+    const ResourceKind kind,
     VmaAllocation* allocation,
     VmaAllocationInfo* allocationInfo
 ) const {
@@ -98,9 +108,37 @@ vk::Buffer ResourceAllocator::allocatePersistentBuffer(
 
     auto buffer = VkBuffer{};
     if (vmaCreateBuffer(_allocator, &bufferCreateInfo, &allocCreateInfo, &buffer, allocation, allocationInfo) != VK_SUCCESS) {
-        PLOGE << "Could not create a persistently mapped buffer";
+        PLOGE << "Could not create a persistently mapped buffer of " << bufferSize << " bytes";
         throw std::runtime_error("Failed to create a persistently mapped buffer");
     }
+    track(*allocation, kind);
+
+    return buffer;
+}
+
+vk::Buffer ResourceAllocator::allocateReadbackBuffer(
+    const std::size_t bufferSize,
+    const vk::BufferUsageFlags usage,
+    const ResourceKind kind,
+    VmaAllocation* allocation,
+    VmaAllocationInfo* allocationInfo
+) const {
+    auto bufferCreateInfo = VkBufferCreateInfo{};
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.usage = static_cast<VkBufferUsageFlags>(usage);
+    bufferCreateInfo.size = bufferSize;
+
+    // Random access lets VMA prefer host cached memory, reading write-combined memory back is painfully slow
+    auto allocCreateInfo = VmaAllocationCreateInfo{};
+    allocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+    allocCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    auto buffer = VkBuffer{};
+    if (vmaCreateBuffer(_allocator, &bufferCreateInfo, &allocCreateInfo, &buffer, allocation, allocationInfo) != VK_SUCCESS) {
+        PLOGE << "Could not create a readback buffer of " << bufferSize << " bytes";
+        throw std::runtime_error("Failed to create a readback buffer");
+    }
+    track(*allocation, kind);
 
     return buffer;
 }
@@ -115,6 +153,7 @@ vk::Image ResourceAllocator::allocateDedicatedImage(
     const vk::Format format,
     const vk::ImageTiling tiling,
     const vk::ImageUsageFlags usage,
+    const ResourceKind kind,
     VmaAllocation* allocation
 ) const {
     auto imgCreateInfo = VkImageCreateInfo{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
@@ -141,18 +180,21 @@ vk::Image ResourceAllocator::allocateDedicatedImage(
 
     auto image = VkImage{};
     if (vmaCreateImage(_allocator, &imgCreateInfo, &allocInfo, &image, allocation, nullptr) != VK_SUCCESS) {
-        PLOGE << "Could not create a dedicated image";
+        PLOGE << "Could not create a dedicated image of " << width << " x " << height << " x " << depth;
         throw std::runtime_error("Failed to create dedicated image");
     }
+    track(*allocation, kind);
 
     return image;
 }
 
 void ResourceAllocator::destroyBuffer(const vk::Buffer& buffer, VmaAllocation allocation) const noexcept {
+    untrack(allocation);
     vmaDestroyBuffer(_allocator, buffer, allocation);
 }
 
 void ResourceAllocator::destroyImage(const vk::Image& image, VmaAllocation allocation) const noexcept {
+    untrack(allocation);
     vmaDestroyImage(_allocator, image, allocation);
 }
 
@@ -163,6 +205,62 @@ void ResourceAllocator::mapAndCopyData(const std::size_t bufferSize, const void*
     vmaUnmapMemory(_allocator, allocation);
 }
 
+void ResourceAllocator::invalidateAllocation(VmaAllocation allocation) const {
+    vmaInvalidateAllocation(_allocator, allocation, 0, VK_WHOLE_SIZE);
+}
+
+MemoryStatistics ResourceAllocator::getStatistics() const {
+    const VkPhysicalDeviceMemoryProperties* memoryProperties;
+    vmaGetMemoryProperties(_allocator, &memoryProperties);
+
+    // With VK_EXT_memory_budget enabled, usage and budget come straight from the driver rather than being estimated
+    auto budgets = std::array<VmaBudget, VK_MAX_MEMORY_HEAPS>{};
+    vmaGetHeapBudgets(_allocator, budgets.data());
+
+    auto statistics = MemoryStatistics{};
+    statistics.heaps.reserve(memoryProperties->memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; ++i) {
+        auto heap = HeapBudget{};
+        heap.deviceLocal = (memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        heap.usage = budgets[i].usage;
+        heap.budget = budgets[i].budget;
+        heap.blockBytes = budgets[i].statistics.blockBytes;
+        heap.allocationBytes = budgets[i].statistics.allocationBytes;
+        heap.blockCount = budgets[i].statistics.blockCount;
+        heap.allocationCount = budgets[i].statistics.allocationCount;
+        statistics.heaps.push_back(heap);
+    }
+
+    for (int i = 0; i < RESOURCE_KIND_COUNT; ++i) {
+        statistics.resources[i].count = _resourceCounts[i].load(std::memory_order_relaxed);
+        statistics.resources[i].bytes = _resourceBytes[i].load(std::memory_order_relaxed);
+    }
+
+    return statistics;
+}
+
+void ResourceAllocator::track(VmaAllocation allocation, const ResourceKind kind) const {
+    vmaSetAllocationUserData(_allocator, allocation, reinterpret_cast<void*>(static_cast<std::uintptr_t>(kind)));
+
+    auto allocationInfo = VmaAllocationInfo{};
+    vmaGetAllocationInfo(_allocator, allocation, &allocationInfo);
+
+    const auto index = static_cast<std::size_t>(kind);
+    _resourceCounts[index].fetch_add(1, std::memory_order_relaxed);
+    _resourceBytes[index].fetch_add(allocationInfo.size, std::memory_order_relaxed);
+}
+
+void ResourceAllocator::untrack(VmaAllocation allocation) const noexcept {
+    if (allocation == nullptr) return;
+
+    auto allocationInfo = VmaAllocationInfo{};
+    vmaGetAllocationInfo(_allocator, allocation, &allocationInfo);
+
+    const auto index = reinterpret_cast<std::uintptr_t>(allocationInfo.pUserData);
+    _resourceCounts[index].fetch_sub(1, std::memory_order_relaxed);
+    _resourceBytes[index].fetch_sub(allocationInfo.size, std::memory_order_relaxed);
+}
+
 ResourceAllocator::~ResourceAllocator() {
     vmaDestroyAllocator(_allocator);
 }
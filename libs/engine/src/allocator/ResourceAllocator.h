@@ -2,9 +2,14 @@
 
 #include "VmaUsage.h"
 
+#include "engine/MemoryStatistics.h"
+
 #include <vulkan/vulkan.hpp>
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <vector>
 
 
 class ResourceAllocator {
@@ -22,10 +27,14 @@ public:
         uint32_t _apiVersion{};
     };
 
+    // Buffers are owned by a single queue family at a time, unless more than one family is specified, in which case
+    // they can be accessed concurrently from all of them
     vk::Buffer allocateDedicatedBuffer(
         std::size_t bufferSize,
         vk::BufferUsageFlags usage,
-        VmaAllocation* allocation) const;
+        ResourceKind kind,
+        VmaAllocation* allocation,
+        const std::vector<uint32_t>& queueFamilies = {}) const;
 
     vk::Buffer allocateStagingBuffer(
         std::size_t bufferSize,
@@ -34,6 +43,15 @@ public:
     vk::Buffer allocatePersistentBuffer(
         std::size_t bufferSize,
         vk::BufferUsageFlags usage,
+        ResourceKind kind,
+        VmaAllocation* allocation,
+        VmaAllocationInfo* allocationInfo) const;
+
+    // Like a persistent buffer, but placed in memory the host can read from efficiently, typically cached
+    vk::Buffer allocateReadbackBuffer(
+        std::size_t bufferSize,
+        vk::BufferUsageFlags usage,
+        ResourceKind kind,
         VmaAllocation* allocation,
         VmaAllocationInfo* allocationInfo) const;
 
@@ -47,6 +65,7 @@ public:
         vk::Format format,
         vk::ImageTiling tiling,
         vk::ImageUsageFlags usage,
+        ResourceKind kind,
         VmaAllocation* allocation) const;
 
     void destroyBuffer(const vk::Buffer& buffer, VmaAllocation allocation) const noexcept;
@@ -55,6 +74,11 @@ public:
 
     void mapAndCopyData(std::size_t bufferSize, const void* data, VmaAllocation allocation) const;
 
+    // Makes device writes to a mapped allocation visible to the host, a no-op for host coherent memory
+    void invalidateAllocation(VmaAllocation allocation) const;
+
+    [[nodiscard]] MemoryStatistics getStatistics() const;
+
     ~ResourceAllocator();
 
     ResourceAllocator(const ResourceAllocator&) = delete;
@@ -64,4 +88,11 @@ private:
     explicit ResourceAllocator(VmaAllocator allocator) : _allocator{ allocator } {}
 
     VmaAllocator _allocator{};
+
+    // Every allocation carries its ResourceKind as user data, so that destroying it can update the counters below
+    void track(VmaAllocation allocation, ResourceKind kind) const;
+    void untrack(VmaAllocation allocation) const noexcept;
+
+    mutable std::array<std::atomic<uint32_t>, RESOURCE_KIND_COUNT> _resourceCounts{};
+    mutable std::array<std::atomic<uint64_t>, RESOURCE_KIND_COUNT> _resourceBytes{};
 };
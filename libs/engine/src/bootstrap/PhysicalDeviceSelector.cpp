@@ -56,6 +56,8 @@ bool PhysicalDeviceSelector::checkFeatureSupport(const vk::PhysicalDevice& devic
     auto extendedDynamicStateFeatures = vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT{};
     auto extendedDynamicState2Features = vk::PhysicalDeviceExtendedDynamicState2FeaturesEXT{};
     auto extendedDynamicState3Features = vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT{};
+    auto bufferDeviceAddressFeatures = vk::PhysicalDeviceBufferDeviceAddressFeatures{};
+    auto timelineSemaphoreFeatures = vk::PhysicalDeviceTimelineSemaphoreFeatures{};
 
     auto supportedFeatures = vk::PhysicalDeviceFeatures2{};
     supportedFeatures.features = basicFeatures;
@@ -64,6 +66,8 @@ bool PhysicalDeviceSelector::checkFeatureSupport(const vk::PhysicalDevice& devic
     descriptorIndexingFeatures.pNext = &extendedDynamicStateFeatures;
     extendedDynamicStateFeatures.pNext = &extendedDynamicState2Features;
     extendedDynamicState2Features.pNext = &extendedDynamicState3Features;
+    extendedDynamicState3Features.pNext = &bufferDeviceAddressFeatures;
+    bufferDeviceAddressFeatures.pNext = &timelineSemaphoreFeatures;
 
     device.getFeatures2(&supportedFeatures);
 
@@ -78,9 +82,18 @@ bool PhysicalDeviceSelector::checkFeatureSupport(const vk::PhysicalDevice& devic
         !extendedDynamicState2Features.extendedDynamicState2 || !extendedDynamicState3Features.extendedDynamicState3PolygonMode) {
         return false;
     }
+    if (!bufferDeviceAddressFeatures.bufferDeviceAddress || !basicFeatures.shaderInt64) {
+        return false;
+    }
+    if (!timelineSemaphoreFeatures.timelineSemaphore) {
+        return false;
+    }
 
     // Explicitly required by the application
-    if (!descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount) {
+    if (!descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount ||
+        !descriptorIndexingFeatures.descriptorBindingPartiallyBound ||
+        !descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind ||
+        !descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending) {
         return false;
     }
 
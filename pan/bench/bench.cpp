@@ -0,0 +1,540 @@
+#include "CLI11.hpp"
+#include "cache.h"
+#include "downscale.h"
+#include "pan.h"
+#include "pca.h"
+#include "spd.h"
+
+#include <engine/Context.h>
+#include <engine/Engine.h>
+#include <engine/VertexBuffer.h>
+#include <engine/IndexBuffer.h>
+#include <engine/UniformBuffer.h>
+#include <engine/StorageBuffer.h>
+#include <engine/GraphicShader.h>
+#include <engine/Drawable.h>
+#include <engine/Renderer.h>
+#include <engine/View.h>
+
+#include <gdal_priv.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <plog/Init.h>
+#include <plog/Appenders/ColorConsoleAppender.h>
+#include <plog/Formatters/TxtFormatter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <span>
+#include <string>
+#include <vector>
+
+
+struct BenchConfig {
+    int width{ 1024 };
+    int height{ 1024 };
+    int bands{ 128 };
+    double downscale{ 4.0 };
+    int iterations{ 10 };
+    int frames{ 100 };
+    double minWavelength{ 400.0 };
+    double maxWavelength{ 830.0 };
+    bool skipGpu{ false };
+};
+
+struct BenchResult {
+    std::string name;
+    std::vector<double> samples;  // milliseconds per iteration
+    double bytesPerIteration{ 0.0 };
+};
+
+template<typename F>
+BenchResult measure(const std::string& name, const int iterations, const double bytesPerIteration, F&& f) {
+    using Clock = std::chrono::steady_clock;
+
+    // A single warm-up run so that first-touch costs (page cache, lazy allocations) don't skew the first sample
+    f();
+
+    auto result = BenchResult{ name, {}, bytesPerIteration };
+    result.samples.reserve(iterations);
+    for (int i = 0; i < iterations; ++i) {
+        const auto begin = Clock::now();
+        f();
+        const auto end = Clock::now();
+        result.samples.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+    }
+
+    PLOGI << "Finished " << name;
+    return result;
+}
+
+// Writes an ENVI cube (BSQ, float32) with smooth synthetic spectra and a matching header listing band wavelengths
+std::filesystem::path writeSyntheticCube(const std::filesystem::path& directory, const BenchConfig& config) {
+    const auto rawPath = directory / "cube.img";
+    const auto hdrPath = directory / "cube.hdr";
+
+    auto raw = std::ofstream{ rawPath, std::ios::binary };
+    if (!raw.is_open()) {
+        throw std::runtime_error("Failed to create synthetic cube!");
+    }
+
+    auto plane = std::vector<float>(static_cast<std::size_t>(config.width) * config.height);
+    for (int b = 0; b < config.bands; ++b) {
+        for (int y = 0; y < config.height; ++y) {
+            for (int x = 0; x < config.width; ++x) {
+                plane[y * config.width + x] = 0.5f + 0.4f * std::sin(0.011f * x + 0.05f * b) * std::cos(0.013f * y);
+            }
+        }
+        raw.write(reinterpret_cast<const char*>(plane.data()), static_cast<std::streamsize>(plane.size() * sizeof(float)));
+    }
+    raw.close();
+
+    const auto step = config.bands > 1 ? (config.maxWavelength - config.minWavelength) / (config.bands - 1) : 0.0;
+    auto hdr = std::ofstream{ hdrPath };
+    hdr << "ENVI\n";
+    hdr << "samples = " << config.width << "\n";
+    hdr << "lines = " << config.height << "\n";
+    hdr << "bands = " << config.bands << "\n";
+    hdr << "header offset = 0\n";
+    hdr << "file type = ENVI Standard\n";
+    hdr << "data type = 4\n";
+    hdr << "interleave = bsq\n";
+    hdr << "byte order = 0\n";
+    hdr << "wavelength units = Nanometers\n";
+    hdr << "wavelength = {";
+    for (int b = 0; b < config.bands; ++b) {
+        hdr << std::format("{:.6f}", config.minWavelength + b * step) << (b + 1 < config.bands ? ", " : "}\n");
+    }
+    hdr.close();
+
+    return rawPath;
+}
+
+// Writes a PCA file in the same layout as assets/pca.txt: MAX_COMPONENTS eigenvectors followed by the mean vector
+std::filesystem::path writeSyntheticVectors(const std::filesystem::path& directory, const int bandCount) {
+    const auto path = directory / "pca.txt";
+    auto file = std::ofstream{ path };
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to create synthetic PCA file!");
+    }
+
+    auto generator = std::mt19937{ 42 };
+    auto distribution = std::uniform_real_distribution{ -0.1f, 0.1f };
+    for (int l = 0; l < pca::MAX_COMPONENTS + 1; ++l) {
+        for (int v = 0; v < bandCount; ++v) {
+            file << std::format("{:.18e}", distribution(generator)) << (v + 1 < bandCount ? " " : "\n");
+        }
+    }
+
+    file.close();
+    return path;
+}
+
+std::vector<BenchResult> runCpuBenchmarks(
+    GDALDataset* dataset, const std::filesystem::path& vectorPath, const BenchConfig& config
+) {
+    auto results = std::vector<BenchResult>{};
+
+    const auto metadata = dataset->GetMetadata();
+    const auto metadataCount = CSLCount(metadata);
+    results.push_back(measure("parse_metadata", config.iterations, 0.0, [&] {
+        [[maybe_unused]] const auto centers = parseMetadata(metadata, metadataCount);
+    }));
+
+    const auto vectorBytes = static_cast<double>(std::filesystem::file_size(vectorPath));
+    results.push_back(measure("pca_read_vectors", config.iterations, vectorBytes, [&] {
+        [[maybe_unused]] const auto vectors = pca::readVectors(vectorPath, config.bands);
+    }));
+
+    const auto planeSize = static_cast<std::size_t>(config.width) * config.height;
+    const auto cubeBytes = static_cast<double>(planeSize * sizeof(float) * config.bands);
+    auto values = std::vector<float>(planeSize);
+    results.push_back(measure("gdal_read_bands_full", config.iterations, cubeBytes, [&] {
+        for (int b = 1; b <= config.bands; ++b) {
+            [[maybe_unused]] const auto err = dataset->GetRasterBand(b)->RasterIO(
+                GF_Read, 0, 0, config.width, config.height, values.data(), config.width, config.height, GDT_Float32, 0, 0);
+        }
+    }));
+
+    // Mirrors how pan ingests the cube: one full resolution RasterIO per band, area averaged down to the buffer size
+    const auto bufferXSize = static_cast<int>(config.width / config.downscale);
+    const auto bufferYSize = static_cast<int>(config.height / config.downscale);
+    const auto areaAverage = downscale::AreaAverage{ config.width, config.height, bufferXSize, bufferYSize };
+    auto downscaledValues = std::vector<float>(static_cast<std::size_t>(bufferXSize) * bufferYSize);
+    results.push_back(measure("area_average_band", config.iterations, static_cast<double>(planeSize * sizeof(float)), [&] {
+        areaAverage.apply(values, downscaledValues);
+    }));
+    results.push_back(measure("gdal_read_bands_downscaled", config.iterations, cubeBytes, [&] {
+        for (int b = 1; b <= config.bands; ++b) {
+            [[maybe_unused]] const auto err = dataset->GetRasterBand(b)->RasterIO(
+                GF_Read, 0, 0, config.width, config.height, values.data(), config.width, config.height, GDT_Float32, 0, 0);
+            areaAverage.apply(values, downscaledValues);
+        }
+    }));
+
+    // The codec of the cube cache, on the cube pan would cache. Decompressing has to outrun reading the raw cube from
+    // disk, throughputs are of decompressed floats, on one thread and across all of them as readCube does
+    const auto cubeKey = cache::Key{ 0, 0, bufferXSize, bufferYSize, 0, config.bands };
+    const auto downscaledSize = static_cast<std::size_t>(bufferXSize) * bufferYSize;
+    auto cube = std::vector<float>(downscaledSize * config.bands);
+    for (int b = 0; b < config.bands; ++b) {
+        [[maybe_unused]] const auto err = dataset->GetRasterBand(b + 1)->RasterIO(
+            GF_Read, 0, 0, config.width, config.height, values.data(), config.width, config.height, GDT_Float32, 0, 0);
+        areaAverage.apply(values, std::span{ cube }.subspan(downscaledSize * b, downscaledSize));
+    }
+
+    const auto tileCount = cache::getTileCount(cubeKey);
+    const auto cachedBytes = static_cast<double>(sizeof(float) * cube.size());
+    auto tiles = std::vector<std::vector<uint8_t>>(tileCount);
+    results.push_back(measure("cube_encode_single", config.iterations, cachedBytes, [&] {
+        for (uint64_t tile = 0; tile < tileCount; ++tile) {
+            tiles[tile] = cache::encodeTile(cube, cubeKey, tile);
+        }
+    }));
+    results.push_back(measure("cube_encode_parallel", config.iterations, cachedBytes, [&] {
+        parallelFor(tileCount, [&](const uint64_t tile) { tiles[tile] = cache::encodeTile(cube, cubeKey, tile); });
+    }));
+
+    auto decoded = std::vector<float>(cube.size());
+    results.push_back(measure("cube_decode_single", config.iterations, cachedBytes, [&] {
+        for (uint64_t tile = 0; tile < tileCount; ++tile) {
+            cache::decodeTile(tiles[tile], cubeKey, tile, decoded);
+        }
+    }));
+    results.push_back(measure("cube_decode_parallel", config.iterations, cachedBytes, [&] {
+        parallelFor(tileCount, [&](const uint64_t tile) { cache::decodeTile(tiles[tile], cubeKey, tile, decoded); });
+    }));
+
+    const auto compressedBytes = std::ranges::fold_left(tiles, 0.0, [](const auto acc, const auto& it) {
+        return acc + static_cast<double>(it.size());
+    });
+    PLOGI << std::format("The cached cube compresses to {:.1f}% of its size", 100.0 * compressedBytes / cachedBytes);
+    if (decoded != cube) {
+        PLOGE << "The cached cube does not decompress to itself";
+    }
+
+    const auto centerWavelengths = parseMetadata(metadata, metadataCount)
+        | std::views::transform([](const auto it) { return static_cast<uint32_t>(it); })
+        | std::ranges::to<std::vector>();
+
+    // The per-frame SPD weighting pan performs for every illuminant/sensor combination
+    auto illuminantObject = Illuminant{};
+    auto sensorObject = Sensor{};
+    static constexpr auto illuminants = std::array{ spd::Illuminant::D65, spd::Illuminant::D50, spd::Illuminant::A };
+    static constexpr auto sensors = std::array{ spd::Sensor::CIE1931, spd::Sensor::CIE1964 };
+    results.push_back(measure("spd_weighting", config.iterations, 0.0, [&] {
+        for (const auto illuminant : illuminants) {
+            for (const auto sensor : sensors) {
+                auto i = 0;
+                for (const auto wavelength : centerWavelengths | std::views::take(128)) {
+                    illuminantObject.data[i] = getIlluminantValueAt(wavelength, illuminant);
+                    sensorObject.x[i] = getSensorXValueAt(wavelength, sensor);
+                    sensorObject.y[i] = getSensorYValueAt(wavelength, sensor);
+                    sensorObject.z[i] = getSensorZValueAt(wavelength, sensor);
+                    i += 4;
+                }
+            }
+        }
+    }));
+
+    return results;
+}
+
+std::vector<BenchResult> runGpuBenchmarks(GDALDataset* dataset, const std::filesystem::path& vectorPath, const BenchConfig& config) {
+    auto results = std::vector<BenchResult>{};
+
+    // A hidden window stands in as the offscreen target, so we exercise the same render path as pan does
+    const auto context = Context::create("pan_bench", false);
+    const auto engine = Engine::create(context->getSurface());
+    const auto swapChain = engine->createSwapChain();
+    const auto renderer = engine->createRenderer();
+
+    const auto bufferXSize = static_cast<int>(config.width / config.downscale);
+    const auto bufferYSize = static_cast<int>(config.height / config.downscale);
+    const auto bandCount = std::min(config.bands, 128);
+
+    const auto bandValues = std::views::iota(0, bandCount)
+        | std::views::transform([&](const int bandIndex) {
+            auto values = std::vector<float>(static_cast<std::size_t>(bufferXSize) * bufferYSize);
+            [[maybe_unused]] const auto err = dataset->GetRasterBand(bandIndex + 1)->RasterIO(
+                GF_Read, 0, 0, config.width, config.height, values.data(), bufferXSize, bufferYSize, GDT_Float32, 0, 0);
+            return values; })
+        | std::ranges::to<std::vector>();
+
+    const auto rasters = bandValues
+        | std::views::transform([&](const auto& values) {
+            return StorageBuffer::Builder()
+                .byteSize(sizeof(float) * values.size())
+                .build(*engine); })
+        | std::ranges::to<std::vector>();
+
+    // Measures Buffer::transferBufferData through the storage buffers pan uploads its bands into
+    const auto rasterBytes = static_cast<double>(sizeof(float) * bufferXSize * bufferYSize * bandCount);
+    results.push_back(measure("buffer_upload", config.iterations, rasterBytes, [&] {
+        for (int b = 0; b < bandCount; ++b) {
+            rasters[b]->setData(bandValues[b].data(), *engine);
+        }
+    }));
+
+    static constexpr auto positions = std::array{
+        glm::vec3{ -QUAD_SIDE_HALF_EXTENT, -QUAD_SIDE_HALF_EXTENT, 0.0f },
+        glm::vec3{ -QUAD_SIDE_HALF_EXTENT,  QUAD_SIDE_HALF_EXTENT, 0.0f },
+        glm::vec3{  QUAD_SIDE_HALF_EXTENT, -QUAD_SIDE_HALF_EXTENT, 0.0f },
+        glm::vec3{  QUAD_SIDE_HALF_EXTENT,  QUAD_SIDE_HALF_EXTENT, 0.0f },
+    };
+    static constexpr auto colors = std::array{
+        glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f },
+        glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f },
+        glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f },
+        glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f },
+    };
+    static constexpr auto texCoords = std::array{
+        glm::vec2{ 0.0f, 0.0f },
+        glm::vec2{ 0.0f, 1.0f },
+        glm::vec2{ 1.0f, 0.0f },
+        glm::vec2{ 1.0f, 1.0f },
+    };
+
+    const auto vertexBuffer = VertexBuffer::Builder()
+        .vertexCount(4)
+        .bindingCount(3)
+        .binding(0, sizeof(glm::vec3))
+        .binding(1, sizeof(glm::vec4))
+        .binding(2, sizeof(glm::vec2))
+        .attribute(0, 0, AttributeFormat::Float3)
+        .attribute(1, 1, AttributeFormat::Float4)
+        .attribute(2, 2, AttributeFormat::Float2)
+        .build(*engine);
+    vertexBuffer->setData(0, positions.data(), *engine);
+    vertexBuffer->setData(1, colors.data(), *engine);
+    vertexBuffer->setData(2, texCoords.data(), *engine);
+
+    static constexpr auto indices = std::array<uint16_t, 4>{ 0, 1, 2, 3 };
+    const auto indexBuffer = IndexBuffer::Builder()
+        .indexCount(indices.size())
+        .indexType(IndexType::Uint16)
+        .build(*engine);
+    indexBuffer->setData(indices.data(), *engine);
+
+    const auto metadata = dataset->GetMetadata();
+    const auto centerWavelengths = parseMetadata(metadata, CSLCount(metadata));
+
+    auto illuminantObject = Illuminant{};
+    auto sensorObject = Sensor{};
+    for (int b = 0; b < bandCount; ++b) {
+        const auto wavelength = static_cast<uint32_t>(centerWavelengths[b]);
+        illuminantObject.data[b * 4] = getIlluminantValueAt(wavelength, spd::Illuminant::D65);
+        sensorObject.x[b * 4] = getSensorXValueAt(wavelength, spd::Sensor::CIE1931);
+        sensorObject.y[b * 4] = getSensorYValueAt(wavelength, spd::Sensor::CIE1931);
+        sensorObject.z[b * 4] = getSensorZValueAt(wavelength, spd::Sensor::CIE1931);
+    }
+
+    const auto illuminant = UniformBuffer::Builder().dataByteSize(sizeof(Illuminant)).build(*engine);
+    const auto sensor = UniformBuffer::Builder().dataByteSize(sizeof(Sensor)).build(*engine);
+    const auto dimension = UniformBuffer::Builder().dataByteSize(sizeof(Dimension)).build(*engine);
+    const auto pca = UniformBuffer::Builder().dataByteSize(sizeof(pca::PCA)).build(*engine);
+
+    const auto dimensionObject = Dimension{ bufferXSize, bufferYSize, bandCount };
+    const auto pcaObject = pca::PCA{ pca::MAX_COMPONENTS, pca::MAX_COMPONENTS };
+    illuminant->setData(&illuminantObject);
+    sensor->setData(&sensorObject);
+    dimension->setData(&dimensionObject);
+    pca->setData(&pcaObject);
+
+    const auto vectors = pca::readVectors(vectorPath, bandCount)
+        | std::views::transform([&](const std::vector<float>& data) {
+            const auto vector = StorageBuffer::Builder()
+                .byteSize(sizeof(float) * data.size())
+                .build(*engine);
+            vector->setData(data.data(), *engine);
+            return vector; })
+        | std::ranges::to<std::vector>();
+
+    const auto xyzShader = GraphicShader::Builder()
+        .vertexShader("shaders/quad.vert")
+        .fragmentShader("shaders/xyz.frag")
+        .descriptorCount(4)
+        .descriptor(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
+        .descriptor(1, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
+        .descriptor(2, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
+        .descriptor(3, vk::DescriptorType::eStorageBuffer, 128, vk::ShaderStageFlagBits::eFragment)
+        .build(*engine, *swapChain);
+
+    const auto xyzInstance = xyzShader->createInstance(*engine);
+    xyzInstance->setDescriptor(0, illuminant, *engine);
+    xyzInstance->setDescriptor(1, sensor, *engine);
+    xyzInstance->setDescriptor(2, dimension, *engine);
+    xyzInstance->setDescriptor(3, rasters, *engine);
+
+    const auto pcaShader = GraphicShader::Builder()
+        .vertexShader("shaders/quad.vert")
+        .fragmentShader("shaders/pca.frag")
+        .descriptorCount(6)
+        .descriptor(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
+        .descriptor(1, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
+        .descriptor(2, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
+        .descriptor(3, vk::DescriptorType::eStorageBuffer, 128, vk::ShaderStageFlagBits::eFragment)
+        .descriptor(4, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
+        .descriptor(5, vk::DescriptorType::eStorageBuffer, 33, vk::ShaderStageFlagBits::eFragment)
+        .build(*engine, *swapChain);
+
+    const auto pcaInstance = pcaShader->createInstance(*engine);
+    pcaInstance->setDescriptor(0, illuminant, *engine);
+    pcaInstance->setDescriptor(1, sensor, *engine);
+    pcaInstance->setDescriptor(2, dimension, *engine);
+    pcaInstance->setDescriptor(3, rasters, *engine);
+    pcaInstance->setDescriptor(4, pca, *engine);
+    pcaInstance->setDescriptor(5, vectors, *engine);
+
+    const auto camera = Camera::create();
+    camera->setLookAt({ 0.0f, 0.0f, -5.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f });
+    camera->setProjection(getPanProjection(swapChain->getFramebufferAspectRatio()));
+
+    const auto view = View::create(*swapChain);
+    view->setCamera(camera);
+
+    // Each shader gets its own scene holding a single quad, every frame waits for the device so that samples
+    // reflect the full cost of one frame rather than the CPU-side submission rate
+    const auto benchShader = [&](const std::string& name, ShaderInstance* instance) {
+        const auto quad = Drawable::Builder(1)
+            .geometry(0, Drawable::Topology::TriangleStrip, vertexBuffer, indexBuffer, indices.size())
+            .material(0, instance)
+            .build(*engine);
+
+        const auto scene = Scene::create();
+        scene->insert(quad);
+        view->setScene(scene);
+
+        results.push_back(measure(name, config.frames, 0.0, [&] {
+            renderer->render(view, swapChain);
+            engine->waitIdle();
+        }));
+    };
+    benchShader("xyz_shader_frame", xyzInstance);
+    benchShader("pca_shader_frame", pcaInstance);
+
+    engine->waitIdle();
+
+    engine->destroyShaderInstance(pcaInstance);
+    engine->destroyShaderInstance(xyzInstance);
+    engine->destroyShader(pcaShader);
+    engine->destroyShader(xyzShader);
+    std::ranges::for_each(vectors, [&engine](const auto it) { engine->destroyBuffer(it); });
+    std::ranges::for_each(rasters, [&engine](const auto it) { engine->destroyBuffer(it); });
+    engine->destroyBuffer(pca);
+    engine->destroyBuffer(dimension);
+    engine->destroyBuffer(sensor);
+    engine->destroyBuffer(illuminant);
+    engine->destroyBuffer(indexBuffer);
+    engine->destroyBuffer(vertexBuffer);
+    engine->destroyRenderer(renderer);
+    engine->destroySwapChain(swapChain);
+    engine->destroy();
+
+    context->destroy();
+
+    return results;
+}
+
+std::string toJson(const std::vector<BenchResult>& results, const BenchConfig& config) {
+    auto json = std::string{ "{\n" };
+    json += std::format(
+        "  \"config\": {{ \"width\": {}, \"height\": {}, \"bands\": {}, \"downscale\": {}, \"iterations\": {}, \"frames\": {} }},\n",
+        config.width, config.height, config.bands, config.downscale, config.iterations, config.frames);
+    json += "  \"benchmarks\": [\n";
+
+    for (std::size_t r = 0; r < results.size(); ++r) {
+        auto samples = results[r].samples;
+        std::ranges::sort(samples);
+
+        const auto count = static_cast<double>(samples.size());
+        const auto mean = std::accumulate(samples.begin(), samples.end(), 0.0) / count;
+        const auto variance = std::ranges::fold_left(samples, 0.0, [mean](const auto acc, const auto it) {
+            return acc + (it - mean) * (it - mean);
+        }) / count;
+        const auto median = samples[samples.size() / 2];
+        const auto throughput = results[r].bytesPerIteration > 0.0
+            ? results[r].bytesPerIteration / (1024.0 * 1024.0) / (median / 1000.0)
+            : 0.0;
+
+        json += std::format(
+            "    {{ \"name\": \"{}\", \"iterations\": {}, \"mean_ms\": {:.6f}, \"median_ms\": {:.6f}, \"min_ms\": {:.6f}, "
+            "\"max_ms\": {:.6f}, \"stddev_ms\": {:.6f}, \"throughput_mib_s\": {:.3f} }}{}\n",
+            results[r].name, samples.size(), mean, median, samples.front(), samples.back(), std::sqrt(variance),
+            throughput, r + 1 < results.size() ? "," : "");
+    }
+
+    json += "  ]\n}\n";
+    return json;
+}
+
+int main(const int argc, char* argv[]) {
+    // CLI arguments
+    auto bench = CLI::App{ "Micro-benchmarks for pan's ingest, upload and spectral kernels" };
+
+    auto config = BenchConfig{};
+    auto outputPath = std::string{};
+    bench.add_option("--width", config.width, "Synthetic cube width")->check(CLI::PositiveNumber);
+    bench.add_option("--height", config.height, "Synthetic cube height")->check(CLI::PositiveNumber);
+    bench.add_option("--bands", config.bands, "Synthetic cube band count")->check(CLI::Range(1, 1024));
+    bench.add_option("--downscale", config.downscale, "Downscaling factor in both axes")->check(CLI::PositiveNumber);
+    bench.add_option("--iterations", config.iterations, "Iterations per CPU and upload benchmark")->check(CLI::PositiveNumber);
+    bench.add_option("--frames", config.frames, "Frames per shader benchmark")->check(CLI::PositiveNumber);
+    bench.add_flag("--skip-gpu", config.skipGpu, "Only run benchmarks that don't need a Vulkan device");
+    bench.add_option("-o,--output", outputPath, "Write the JSON report to this file instead of stdout");
+
+    try {
+        CLI11_PARSE(bench, argc, argv);
+    } catch (const CLI::ParseError& e) {
+        bench.exit(e);
+    }
+
+    // Keep stdout clean for the JSON report
+    auto appender = plog::ColorConsoleAppender<plog::TxtFormatter>(plog::streamStdErr);
+    init(plog::info, &appender);
+
+    GDALAllRegister();
+
+    const auto workDirectory = std::filesystem::temp_directory_path() / "pan_bench";
+    std::filesystem::create_directories(workDirectory);
+
+    PLOGI << "Generating a " << config.width << " x " << config.height << " x " << config.bands << " synthetic cube";
+    const auto cubePath = writeSyntheticCube(workDirectory, config);
+    const auto vectorPath = writeSyntheticVectors(workDirectory, config.bands);
+
+    const auto dataset = static_cast<GDALDataset*>(GDALOpen(cubePath.string().c_str(), GA_ReadOnly));
+    if (dataset == nullptr) {
+        PLOGE << "Failed to open the synthetic cube.";
+        return 1;
+    }
+
+    auto results = runCpuBenchmarks(dataset, vectorPath, config);
+    if (!config.skipGpu) {
+        for (auto&& result : runGpuBenchmarks(dataset, vectorPath, config)) {
+            results.push_back(std::move(result));
+        }
+    }
+
+    GDALClose(dataset);
+    std::filesystem::remove_all(workDirectory);
+
+    const auto json = toJson(results, config);
+    if (outputPath.empty()) {
+        std::cout << json;
+    } else {
+        auto file = std::ofstream{ outputPath };
+        file << json;
+    }
+
+    return 0;
+}
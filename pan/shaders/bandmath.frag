@@ -0,0 +1,54 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+// Values of the band math expression for all pixels
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer Result {
+    float data[ ];
+};
+
+layout(binding = 0) uniform Dimension {
+    int rasterX;
+    int rasterY;
+    int rasterCount;
+    uint64_t cubeAddress;
+    uint64_t bandByteStride;
+} dimension;
+
+layout(binding = 1) uniform BandMath {
+    uint64_t resultAddress;  // 0 until a first expression has been evaluated
+    float minimum;           // mapped to blue
+    float maximum;           // mapped to red, halfway in between is white
+} bandMath;
+
+layout(location = 0) out vec4 outColor;
+
+const vec3 BACKGROUND = vec3(0.08);
+
+void main() {
+    if (bandMath.resultAddress == 0) {
+        outColor = vec4(BACKGROUND, 1.0);
+        return;
+    }
+
+    int pixelX = int(fragTexCoord.x * float(dimension.rasterX - 1));
+    int pixelY = int(fragTexCoord.y * float(dimension.rasterY - 1));
+    float value = Result(bandMath.resultAddress).data[pixelY * dimension.rasterX + pixelX];
+
+    // Divisions by zero and the like show as background
+    if (isnan(value) || isinf(value)) {
+        outColor = vec4(BACKGROUND, 1.0);
+        return;
+    }
+
+    // A diverging map suits normalized indices, which are mostly centered on zero
+    float t = clamp((value - bandMath.minimum) / max(bandMath.maximum - bandMath.minimum, 1e-6), 0.0, 1.0);
+    vec3 blue = vec3(0.23, 0.30, 0.75);
+    vec3 red = vec3(0.71, 0.02, 0.15);
+    vec3 color = t < 0.5 ? mix(blue, vec3(0.87), t * 2.0) : mix(vec3(0.87), red, t * 2.0 - 1.0);
+
+    outColor = vec4(color, 1.0);
+}
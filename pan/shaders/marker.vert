@@ -0,0 +1,20 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inColor;
+
+// Per-instance attributes, a mat4 spans 4 consecutive locations
+layout(location = 2) in mat4 inInstanceTransform;
+layout(location = 6) in vec4 inInstanceColor;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(push_constant, std430) uniform ModelViewProjection {
+    mat4 cameraMat;
+    mat4 transform;
+} mvp;
+
+void main() {
+    gl_Position = mvp.cameraMat * mvp.transform * inInstanceTransform * vec4(inPosition, 1.0);
+    fragColor = inColor * inInstanceColor;
+}
\ No newline at end of file
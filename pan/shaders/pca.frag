@@ -1,70 +1,85 @@
 #version 450
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
 
 layout(location = 0) in vec4 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
 
 layout(location = 0) out vec4 outColor;
 
-layout(binding = 0) uniform Illuminant {
-    float data[128];
-} illuminant;
+// What each band contributes to X, Y and Z under the current illuminant and sensor, already normalized
+layout(binding = 0) uniform Tristimulus {
+    vec4 weights[128];
+} tristimulus;
 
-layout(binding = 1) uniform Sensor {
-    float x[128];
-    float y[128];
-    float z[128];
-} sensor;
+// The spectral cube lives in a single buffer read through its device address, band after band
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer Band {
+    float data[ ];
+};
 
-layout(binding = 2) uniform Dimension {
+layout(binding = 1) uniform Dimension {
     int rasterX;
     int rasterY;
     int rasterCount;
+    uint64_t cubeAddress;    // of the first band, the others follow at bandByteStride from each other
+    uint64_t bandByteStride;
 } dimension;
 
-layout(std430, binding = 3) readonly buffer Raster {
+// Per-pixel scores projected by the pca compute shader, maxComponents of them per pixel
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer Scores {
     float data[ ];
-} rasters[128];
+};
 
-layout(binding = 4) uniform PCA {
+layout(binding = 2) uniform PCA {
     int componentCount;
     int maxComponents;
+    uint64_t scoreAddress;  // 0 until the projection has finished, scores are then computed here instead
 } pca;
 
-layout(std430, binding = 5) readonly buffer Vector {
+layout(std430, binding = 3) readonly buffer Vector {
     float data[ ];
 } vectors[33];
 
+// Specialized to the band count of the loaded dataset so that the spectral loops get a compile-time bound, a value
+// of 0 falls back to the runtime count from the Dimension uniform
+layout(constant_id = 0) const int BAND_COUNT = 0;
+
+// Specialized to the selected component count for the common values, 0 falls back to the PCA uniform
+layout(constant_id = 1) const int COMPONENT_COUNT = 0;
+
+float readReflectance(int band, int pixel) {
+    Band raster = Band(dimension.cubeAddress + uint64_t(band) * dimension.bandByteStride);
+    return clamp(raster.data[pixel], 0.0, 1.0);
+}
+
+float readScore(int component, int pixel) {
+    Scores scores = Scores(pca.scoreAddress);
+    return scores.data[pixel * pca.maxComponents + component];
+}
+
 vec3 computeTristimulus(int pX, int pY) {
-    // Compute the scaling factor
-    float k = 0.0;
-    for (int i = 0; i < dimension.rasterCount; i++) {
-        k += illuminant.data[i] * sensor.y[i];
-    }
-    k = 1.0 / k;
+    int bandCount = BAND_COUNT > 0 ? BAND_COUNT : dimension.rasterCount;
+    int componentCount = COMPONENT_COUNT > 0 ? COMPONENT_COUNT : pca.componentCount;
+    int pixel = pY * dimension.rasterX + pX;
+    bool projected = pca.scoreAddress != 0;
 
     // Compute tri-stimulus
-    float x = 0.0;
-    float y = 0.0;
-    float z = 0.0;
-    for (int d = 0; d < pca.componentCount; d++) {
-        float xComponent = 0.0;
-        float yComponent = 0.0;
-        float zComponent = 0.0;
-        float pixelPCA = 0.0;
-        for (int i = 0; i < dimension.rasterCount; i++) {
-            xComponent += k * illuminant.data[i] * vectors[d].data[i] * sensor.x[i];
-            yComponent += k * illuminant.data[i] * vectors[d].data[i] * sensor.y[i];
-            zComponent += k * illuminant.data[i] * vectors[d].data[i] * sensor.z[i];
-            float reflectance = clamp(rasters[i].data[pY * dimension.rasterX + pX], 0.0, 1.0);
-            float mean = vectors[pca.maxComponents].data[i];
-            pixelPCA += (reflectance - mean) * vectors[d].data[i];
+    vec3 xyz = vec3(0.0);
+    for (int d = 0; d < componentCount; d++) {
+        vec3 component = vec3(0.0);
+        float pixelPCA = projected ? readScore(d, pixel) : 0.0;
+        for (int i = 0; i < bandCount; i++) {
+            component += vectors[d].data[i] * tristimulus.weights[i].xyz;
+            if (!projected) {
+                float reflectance = readReflectance(i, pixel);
+                float mean = vectors[pca.maxComponents].data[i];
+                pixelPCA += (reflectance - mean) * vectors[d].data[i];
+            }
         }
-        x += pixelPCA * xComponent;
-        y += pixelPCA * yComponent;
-        z += pixelPCA * zComponent;
+        xyz += pixelPCA * component;
     }
 
-    return vec3(x, y, z);
+    return xyz;
 }
 
 vec3 XYZToLinearRGB(vec3 xyz) {
@@ -0,0 +1,62 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+// Spectral angles of all pixels to the reference, in radians
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer Angles {
+    float data[ ];
+};
+
+layout(binding = 0) uniform Dimension {
+    int rasterX;
+    int rasterY;
+    int rasterCount;
+    uint64_t cubeAddress;
+    uint64_t bandByteStride;
+} dimension;
+
+layout(binding = 1) uniform Similarity {
+    uint64_t angleAddress;  // 0 until the first angles have been computed
+    float threshold;        // in radians, pixels further away than this are left out
+} similarity;
+
+layout(location = 0) out vec4 outColor;
+
+const vec3 BACKGROUND = vec3(0.08);
+
+// A polynomial fit of the Turbo colormap, from blue for 0 to red for 1
+vec3 turbo(float t) {
+    const vec4 kRedVec4 = vec4(0.13572138, 4.61539260, -42.66032258, 132.13108234);
+    const vec4 kGreenVec4 = vec4(0.09140261, 2.19418839, 4.84296658, -14.18503333);
+    const vec4 kBlueVec4 = vec4(0.10667330, 12.64194608, -60.58204836, 110.36276771);
+    const vec2 kRedVec2 = vec2(-152.94239396, 59.28637943);
+    const vec2 kGreenVec2 = vec2(4.27729857, 2.82956604);
+    const vec2 kBlueVec2 = vec2(-89.90310912, 27.34824973);
+
+    t = clamp(t, 0.0, 1.0);
+    vec4 v4 = vec4(1.0, t, t * t, t * t * t);
+    vec2 v2 = v4.zw * v4.z;
+    return vec3(
+        dot(v4, kRedVec4) + dot(v2, kRedVec2),
+        dot(v4, kGreenVec4) + dot(v2, kGreenVec2),
+        dot(v4, kBlueVec4) + dot(v2, kBlueVec2));
+}
+
+void main() {
+    if (similarity.angleAddress == 0) {
+        outColor = vec4(BACKGROUND, 1.0);
+        return;
+    }
+
+    int pixelX = int(fragTexCoord.x * float(dimension.rasterX - 1));
+    int pixelY = int(fragTexCoord.y * float(dimension.rasterY - 1));
+
+    // The most similar pixels are the hottest, anything past the threshold fades into the background
+    float angle = Angles(similarity.angleAddress).data[pixelY * dimension.rasterX + pixelX];
+    vec3 color = angle <= similarity.threshold ? turbo(1.0 - angle / max(similarity.threshold, 1e-6)) : BACKGROUND;
+
+    outColor = vec4(color, 1.0);
+}
@@ -1,49 +1,59 @@
 #version 450
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
 
 layout(location = 0) in vec4 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
 
-layout(binding = 0) uniform Illuminant {
-    float data[128];
-} illuminant;
+// What each band contributes to X, Y and Z under the current illuminant and sensor, already normalized
+layout(binding = 0) uniform Tristimulus {
+    vec4 weights[128];
+} tristimulus;
 
-layout(binding = 1) uniform Sensor {
-    float x[128];
-    float y[128];
-    float z[128];
-} sensor;
+// The spectral cube lives in a single buffer read through its device address, band after band
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer Band {
+    float data[ ];
+};
 
-layout(binding = 2) uniform Dimension {
+layout(binding = 1) uniform Dimension {
     int rasterX;
     int rasterY;
     int rasterCount;
+    uint64_t cubeAddress;    // of the first band, the others follow at bandByteStride from each other
+    uint64_t bandByteStride;
 } dimension;
 
-layout(std430, binding = 3) readonly buffer Raster {
-    float data[ ];
-} rasters[128];
+// The sRGB values mapped to black and white per channel, found from histograms of the image by the levels compute shader
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer Levels {
+    vec4 low;
+    vec4 high;
+};
+
+layout(binding = 2) uniform Stretch {
+    uint64_t levelsAddress;  // 0 until the first levels have been computed
+} stretch;
 
 layout(location = 0) out vec4 outColor;
 
+// Specialized to the band count of the loaded dataset so that the spectral loops get a compile-time bound, a value
+// of 0 falls back to the runtime count from the Dimension uniform
+layout(constant_id = 0) const int BAND_COUNT = 0;
+
+float readReflectance(int band, int pixel) {
+    Band raster = Band(dimension.cubeAddress + uint64_t(band) * dimension.bandByteStride);
+    return clamp(raster.data[pixel], 0.0, 1.0);
+}
+
 vec3 computeTristimulus(int pX, int pY) {
-    // Compute the scaling factor
-    float k = 0.0;
-    for (int i = 0; i < dimension.rasterCount; i++) {
-        k += illuminant.data[i] * sensor.y[i];
-    }
-    k = 1.0 / k;
+    int bandCount = BAND_COUNT > 0 ? BAND_COUNT : dimension.rasterCount;
 
     // Compute tri-stimulus
-    float x = 0.0;
-    float y = 0.0;
-    float z = 0.0;
-    for (int i = 0; i < dimension.rasterCount; i++) {
-        x += k * illuminant.data[i] * clamp(rasters[i].data[pY * dimension.rasterX + pX], 0.0, 1.0) * sensor.x[i];
-        y += k * illuminant.data[i] * clamp(rasters[i].data[pY * dimension.rasterX + pX], 0.0, 1.0) * sensor.y[i];
-        z += k * illuminant.data[i] * clamp(rasters[i].data[pY * dimension.rasterX + pX], 0.0, 1.0) * sensor.z[i];
+    vec3 xyz = vec3(0.0);
+    for (int i = 0; i < bandCount; i++) {
+        xyz += readReflectance(i, pY * dimension.rasterX + pX) * tristimulus.weights[i].xyz;
     }
 
-    return vec3(x, y, z);
+    return xyz;
 }
 
 vec3 XYZToLinearRGB(vec3 xyz) {
@@ -67,6 +77,11 @@ vec3 adjustContrast(vec3 sRGB, float contrast) {
     return 0.5 + contrast * (sRGB - 0.5);
 }
 
+vec3 stretchLevels(vec3 sRGB) {
+    Levels levels = Levels(stretch.levelsAddress);
+    return clamp((sRGB - levels.low.rgb) / (levels.high.rgb - levels.low.rgb), 0.0, 1.0);
+}
+
 void main() {
     int pixelX = int(fragTexCoord.x * float(dimension.rasterX - 1));
     int pixelY = int(fragTexCoord.y * float(dimension.rasterY - 1));
@@ -75,5 +90,7 @@ void main() {
     vec3 rgb = XYZToLinearRGB(xyz);
     vec3 sRGB = gammaCorrectLinearRGB(rgb);
 
-    outColor = vec4(adjustContrast(sRGB, 1.7), 1.0);
+    // Until the levels are in, fall back to a fixed contrast
+    vec3 color = stretch.levelsAddress != 0 ? stretchLevels(sRGB) : adjustContrast(sRGB, 1.7);
+    outColor = vec4(color, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,360 @@
+#include "bandmath.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <format>
+#include <optional>
+#include <stdexcept>
+
+
+namespace {
+    using bandmath::Opcode;
+
+    // Wavelengths further than this outside the resident range are refused rather than clamped to the nearest band
+    constexpr auto WAVELENGTH_TOLERANCE = 10.0;
+
+    // A recursive descent parser emitting postfix instructions as it goes, with the usual precedence:
+    // sum < product < unary minus < power < primary. Power is right associative
+    class Parser {
+    public:
+        Parser(const std::string_view expression, const std::span<const uint32_t> wavelengths, const int firstBand)
+            : _expression{ expression }, _wavelengths{ wavelengths }, _firstBand{ firstBand } {
+        }
+
+        bandmath::Program parse() {
+            parseSum();
+            skipSpaces();
+            if (_position < _expression.size()) {
+                fail("Unexpected character");
+            }
+            if (_program.instructions.empty()) {
+                fail("Empty expression");
+            }
+            return std::move(_program);
+        }
+
+    private:
+        void parseSum() {
+            parseProduct();
+            while (true) {
+                if (accept('+')) {
+                    parseProduct();
+                    emit(Opcode::Add);
+                } else if (accept('-')) {
+                    parseProduct();
+                    emit(Opcode::Subtract);
+                } else {
+                    return;
+                }
+            }
+        }
+
+        void parseProduct() {
+            parseUnary();
+            while (true) {
+                if (accept('*')) {
+                    parseUnary();
+                    emit(Opcode::Multiply);
+                } else if (accept('/')) {
+                    parseUnary();
+                    emit(Opcode::Divide);
+                } else {
+                    return;
+                }
+            }
+        }
+
+        // Binds looser than power, so that -R500^2 is -(R500^2)
+        void parseUnary() {
+            if (accept('-')) {
+                parseUnary();
+                emit(Opcode::Negate);
+            } else if (accept('+')) {
+                parseUnary();
+            } else {
+                parsePower();
+            }
+        }
+
+        void parsePower() {
+            parsePrimary();
+            if (accept('^')) {
+                const auto exponentBegin = _program.instructions.size();
+                parseUnary();
+                if (const auto exponent = takeIntegerExponent(exponentBegin)) {
+                    emit(Opcode::IntegerPower, static_cast<uint32_t>(*exponent + bandmath::INTEGER_POWER_BIAS));
+                } else {
+                    emit(Opcode::Power);
+                }
+            }
+        }
+
+        // Removes the exponent emitted from this instruction on if it is a constant integer, possibly negated, and
+        // returns it. pow is undefined for negative bases, which an integer power computed by multiplication handles
+        std::optional<int> takeIntegerExponent(const std::size_t begin) {
+            const auto instructions = std::span{ _program.instructions }.subspan(begin);
+            const auto getOpcode = [&](const std::size_t i) { return static_cast<Opcode>(instructions[i] >> 24); };
+            const auto isConstant = !instructions.empty() && getOpcode(0) == Opcode::Constant;
+            const auto isNegated = instructions.size() == 2 && getOpcode(1) == Opcode::Negate;
+            if (!isConstant || (instructions.size() != 1 && !isNegated)) {
+                return std::nullopt;
+            }
+
+            const auto index = instructions[0] & 0xFFFFFF;
+            const auto value = static_cast<double>(_program.constants[index]) * (isNegated ? -1.0 : 1.0);
+            if (value != std::floor(value) || std::abs(value) >= bandmath::INTEGER_POWER_BIAS) {
+                return std::nullopt;
+            }
+
+            // The constant leaves the table too unless something else refers to it, it can only be the last one then
+            _program.instructions.resize(begin);
+            --_stackDepth;
+            const auto constant = (static_cast<uint32_t>(Opcode::Constant) << 24) | index;
+            const auto isReferenced = std::ranges::find(_program.instructions, constant) != _program.instructions.end();
+            if (!isReferenced && index + 1 == _program.constants.size()) {
+                _program.constants.pop_back();
+            }
+            return static_cast<int>(value);
+        }
+
+        void parsePrimary() {
+            if (accept('(')) {
+                parseSum();
+                expect(')');
+                return;
+            }
+
+            skipSpaces();
+            if (_position >= _expression.size()) {
+                fail("Unexpected end of expression");
+            }
+
+            const auto start = _position;
+            const auto c = _expression[_position];
+            if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+                emitConstant(static_cast<float>(parseNumber()));
+                return;
+            }
+            if (!std::isalpha(static_cast<unsigned char>(c))) {
+                fail("Unexpected character");
+            }
+
+            auto name = std::string{};
+            while (_position < _expression.size() && std::isalpha(static_cast<unsigned char>(_expression[_position]))) {
+                name.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(_expression[_position++]))));
+            }
+
+            // Bands: a single letter immediately followed by a number
+            if ((name == "r" || name == "b") && _position < _expression.size() &&
+                (std::isdigit(static_cast<unsigned char>(_expression[_position])) || _expression[_position] == '.')) {
+                const auto value = parseNumber();
+                emitBand(name == "r" ? resolveWavelength(value, start) : resolveBandNumber(value, start));
+                return;
+            }
+
+            // Functions
+            static constexpr auto UNARY_FUNCTIONS = std::array{
+                std::pair{ "abs", Opcode::Abs },
+                std::pair{ "sqrt", Opcode::Sqrt },
+                std::pair{ "log", Opcode::Log },
+                std::pair{ "exp", Opcode::Exp },
+            };
+            static constexpr auto BINARY_FUNCTIONS = std::array{
+                std::pair{ "min", Opcode::Min },
+                std::pair{ "max", Opcode::Max },
+            };
+            if (const auto it = std::ranges::find(UNARY_FUNCTIONS, name, &std::pair<const char*, Opcode>::first);
+                it != UNARY_FUNCTIONS.end()) {
+                expect('(');
+                parseSum();
+                expect(')');
+                emit(it->second);
+            } else if (const auto it2 = std::ranges::find(BINARY_FUNCTIONS, name, &std::pair<const char*, Opcode>::first);
+                it2 != BINARY_FUNCTIONS.end()) {
+                expect('(');
+                parseSum();
+                expect(',');
+                parseSum();
+                expect(')');
+                emit(it2->second);
+            } else {
+                fail(std::format("Unknown name '{}'", name), start);
+            }
+        }
+
+        double parseNumber() {
+            const auto start = _position;
+            while (_position < _expression.size() &&
+                (std::isdigit(static_cast<unsigned char>(_expression[_position])) || _expression[_position] == '.')) {
+                ++_position;
+            }
+
+            auto value = 0.0;
+            const auto first = _expression.data() + start;
+            const auto last = _expression.data() + _position;
+            if (const auto [end, error] = std::from_chars(first, last, value); error != std::errc{} || end != last) {
+                fail("Malformed number", start);
+            }
+            return value;
+        }
+
+        uint32_t resolveWavelength(const double wavelength, const std::size_t position) const {
+            if (wavelength < _wavelengths.front() - WAVELENGTH_TOLERANCE ||
+                wavelength > _wavelengths.back() + WAVELENGTH_TOLERANCE) {
+                fail(std::format("{} nm is outside the resident range of {} to {} nm",
+                    wavelength, _wavelengths.front(), _wavelengths.back()), position);
+            }
+            const auto nearest = std::ranges::min_element(_wavelengths, {}, [wavelength](const auto it) {
+                return std::abs(static_cast<double>(it) - wavelength);
+            });
+            return static_cast<uint32_t>(nearest - _wavelengths.begin());
+        }
+
+        uint32_t resolveBandNumber(const double number, const std::size_t position) const {
+            // Checked as a double first, huge band numbers don't fit in an int
+            const auto lastBand = _firstBand + static_cast<int>(_wavelengths.size());
+            if (number != std::floor(number) || number < _firstBand + 1 || number > lastBand) {
+                fail(std::format("Band B{} is not resident, only B{} to B{} are",
+                    number, _firstBand + 1, lastBand), position);
+            }
+            return static_cast<uint32_t>(static_cast<int>(number) - 1 - _firstBand);
+        }
+
+        void emitBand(const uint32_t band) {
+            emit(Opcode::Band, band);
+        }
+
+        void emitConstant(const float value) {
+            const auto index = std::ranges::find(_program.constants, value) - _program.constants.begin();
+            if (index == std::ssize(_program.constants)) {
+                if (_program.constants.size() == bandmath::MAX_CONSTANTS) {
+                    fail(std::format("More than {} distinct constants", bandmath::MAX_CONSTANTS));
+                }
+                _program.constants.push_back(value);
+            }
+            emit(Opcode::Constant, static_cast<uint32_t>(index));
+        }
+
+        void emit(const Opcode opcode, const uint32_t operand = 0) {
+            if (_program.instructions.size() == bandmath::MAX_INSTRUCTIONS) {
+                fail(std::format("Expression is longer than {} operations", bandmath::MAX_INSTRUCTIONS));
+            }
+            _program.instructions.push_back((static_cast<uint32_t>(opcode) << 24) | operand);
+
+            // Operands push a value, binary operators pop two and push one, unary operators replace one
+            switch (opcode) {
+                case Opcode::Band:
+                case Opcode::Constant:
+                    if (++_stackDepth > bandmath::MAX_STACK_DEPTH) {
+                        fail(std::format("Expression nests deeper than {} operands", bandmath::MAX_STACK_DEPTH));
+                    }
+                    break;
+                case Opcode::Add:
+                case Opcode::Subtract:
+                case Opcode::Multiply:
+                case Opcode::Divide:
+                case Opcode::Power:
+                case Opcode::Min:
+                case Opcode::Max:
+                    --_stackDepth;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        bool accept(const char c) {
+            skipSpaces();
+            if (_position < _expression.size() && _expression[_position] == c) {
+                ++_position;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(const char c) {
+            if (!accept(c)) {
+                fail(std::format("Expected '{}'", c));
+            }
+        }
+
+        void skipSpaces() {
+            while (_position < _expression.size() && std::isspace(static_cast<unsigned char>(_expression[_position]))) {
+                ++_position;
+            }
+        }
+
+        [[noreturn]] void fail(const std::string& message) const {
+            fail(message, _position);
+        }
+
+        [[noreturn]] static void fail(const std::string& message, const std::size_t position) {
+            throw std::invalid_argument(std::format("{} at position {}", message, position + 1));
+        }
+
+        std::string_view _expression;
+        std::span<const uint32_t> _wavelengths;
+        int _firstBand;
+
+        std::size_t _position{ 0 };
+        int _stackDepth{ 0 };
+        bandmath::Program _program{};
+    };
+}
+
+std::string bandmath::Program::getKey() const {
+    auto key = std::string{};
+    key.append(reinterpret_cast<const char*>(instructions.data()), instructions.size() * sizeof(uint32_t));
+    key.append(reinterpret_cast<const char*>(constants.data()), constants.size() * sizeof(float));
+    return key;
+}
+
+bandmath::Program bandmath::compile(
+    const std::string_view expression,
+    const std::span<const uint32_t> wavelengths,
+    const int firstBand
+) {
+    if (wavelengths.empty()) {
+        throw std::invalid_argument("No resident bands");
+    }
+    return Parser{ expression, wavelengths, firstBand }.parse();
+}
+
+void bandmath::writeGeoTiff(
+    const std::filesystem::path& path,
+    const std::vector<float>& values,
+    const int rasterX,
+    const int rasterY,
+    GDALDataset* const source
+) {
+    const auto driver = GetGDALDriverManager()->GetDriverByName("GTiff");
+    if (driver == nullptr) {
+        throw std::runtime_error("GDAL has no GeoTIFF driver");
+    }
+    const auto output = driver->Create(path.string().c_str(), rasterX, rasterY, 1, GDT_Float32, nullptr);
+    if (output == nullptr) {
+        throw std::runtime_error(std::format("Could not create {}", path.string()));
+    }
+
+    // The result may cover a downscaled raster, whose pixels are larger by the downscaling factor
+    if (auto transform = std::array<double, 6>{}; source->GetGeoTransform(transform.data()) == CE_None) {
+        const auto scaleX = static_cast<double>(source->GetRasterXSize()) / rasterX;
+        const auto scaleY = static_cast<double>(source->GetRasterYSize()) / rasterY;
+        transform[1] *= scaleX;
+        transform[4] *= scaleX;
+        transform[2] *= scaleY;
+        transform[5] *= scaleY;
+        output->SetGeoTransform(transform.data());
+        output->SetProjection(source->GetProjectionRef());
+    }
+
+    const auto err = output->GetRasterBand(1)->RasterIO(
+        GF_Write, 0, 0, rasterX, rasterY, const_cast<float*>(values.data()), rasterX, rasterY, GDT_Float32, 0, 0);
+    GDALClose(output);
+    if (err != CE_None) {
+        throw std::runtime_error(std::format("Could not write {}", path.string()));
+    }
+}
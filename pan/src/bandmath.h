@@ -0,0 +1,92 @@
+#pragma once
+
+#include <engine/Renderer.h>
+
+#include <gdal_priv.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace bandmath {
+    // Must match the limits of the bandmath compute shader
+    static constexpr auto MAX_INSTRUCTIONS = 32;
+    static constexpr auto MAX_CONSTANTS = 8;
+    static constexpr auto MAX_STACK_DEPTH = 8;
+
+    // Results are written to a ring of buffers, for the same reason as the spectral angles, see sam::ANGLE_BUFFER_COUNT
+    static constexpr auto RESULT_BUFFER_COUNT = Renderer::getMaxFramesInFlight() + 1;
+
+    // Integer exponents are stored biased by this in the 24-bit operand, so that negative ones fit as well
+    static constexpr auto INTEGER_POWER_BIAS = 1 << 23;
+
+    // An instruction keeps its opcode in the upper 8 bits and its operand, a band, a constant index or a biased integer
+    // exponent, in the lower 24
+    enum class Opcode : uint32_t {
+        Band,
+        Constant,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Power,
+        Negate,
+        Abs,
+        Sqrt,
+        Log,
+        Exp,
+        Min,
+        Max,
+        // Raising to a constant integer, which ^ is lowered to. Unlike pow it is defined for negative bases
+        IntegerPower,
+    };
+
+    // A postfix program evaluated per pixel on a stack
+    struct Program {
+        std::vector<uint32_t> instructions;
+        std::vector<float> constants;
+
+        // Programs with the same key compute the same thing and share the same kernel, whatever they were typed as
+        [[nodiscard]] std::string getKey() const;
+    };
+
+    /**
+     * Compiles an expression over the resident bands, e.g. (R800 - R650) / (R800 + R650). A band is either given by
+     * its wavelength in nanometers as R<wavelength>, resolved to the nearest resident band, or by its 1-based number
+     * in the dataset as B<number>. Numbers, + - * / ^, parentheses and the functions abs, sqrt, log, exp, min and
+     * max are supported. Raising to a constant integer, as in (R800 - R670)^2, is computed by repeated multiplication
+     * and accepts negative bases. Other powers of negative bases are only defined for integer exponents, and NaN
+     * otherwise.
+     *
+     * @param expression The expression to compile.
+     * @param wavelengths The center wavelengths of the resident bands, in the order they appear in the cube.
+     * @param firstBand The 0-based index in the dataset of the first resident band.
+     * @return The compiled program.
+     * @throws std::invalid_argument if the expression is malformed, refers to a band that isn't resident, or exceeds
+     * the limits of the kernel.
+     */
+    [[nodiscard]] Program compile(std::string_view expression, std::span<const uint32_t> wavelengths, int firstBand);
+
+    // Push constants of the bandmath compute shader
+    struct Evaluation {
+        alignas(8) uint64_t cubeAddress;
+        alignas(8) uint64_t bandByteStride;
+        alignas(8) uint64_t resultAddress;
+        alignas(4) int rasterX;
+        alignas(4) int rasterY;
+    };
+
+    struct BandMath {
+        alignas(8) uint64_t resultAddress{ 0 };
+        alignas(4) float minimum;
+        alignas(4) float maximum;
+    };
+
+    // Writes a single-band float GeoTIFF, georeferenced like the source dataset scaled to the raster size
+    void writeGeoTiff(
+        const std::filesystem::path& path, const std::vector<float>& values, int rasterX, int rasterY, GDALDataset* source);
+}
@@ -0,0 +1,695 @@
+#include "cache.h"
+
+#include <plog/Log.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// A cube file holds this header, the band centers, the band statistics, the end offsets of all tiles relative to the
+// first one, then the tiles
+struct CubeHeader {
+    uint32_t magic;
+    uint32_t version;
+    cache::Key key;
+    uint32_t tilePixelCount;
+    uint32_t tileCount;
+};
+
+static constexpr uint32_t mMagic = 0x43434E50;  // "PNCC" in little endian
+// Bumped whenever the layout or the preprocessing of cubes changes, older cubes are then rebuilt
+static constexpr uint32_t mVersion = 3;
+
+// Large enough for the entropy coder to learn the statistics of a tile, small enough to keep every thread busy
+static constexpr uint32_t mTilePixelCount = 4096;
+
+// Each tile starts with one of these per byte plane, followed by the planes themselves
+enum class PlaneMode : uint32_t {
+    Raw,
+    Sparse,
+    Rans,
+};
+
+struct PlaneHeader {
+    PlaneMode mode;
+    uint32_t byteSize;
+};
+
+static constexpr auto mPlaneCount = 4;
+
+// A plane is stored sparse if that takes less than 1/mSparseRatio of its size, and entropy coded only if that saves
+// at least 1/mRansMinSaving of it
+static constexpr auto mSparseRatio = 16;
+static constexpr auto mRansMinSaving = 16;
+
+static uint64_t getBandCount(const cache::Key& key) {
+    return static_cast<uint64_t>(key.bandEnd - key.bandBegin);
+}
+
+static uint64_t getPixelCount(const cache::Key& key) {
+    return static_cast<uint64_t>(key.rasterX) * static_cast<uint64_t>(key.rasterY);
+}
+
+uint64_t cache::getTileCount(const Key& key) {
+    return (getPixelCount(key) + mTilePixelCount - 1) / mTilePixelCount;
+}
+
+static uint64_t getStatisticsOffset(const cache::Key& key) {
+    return sizeof(CubeHeader) + sizeof(double) * getBandCount(key);
+}
+
+static uint64_t getTileTableOffset(const cache::Key& key) {
+    return getStatisticsOffset(key) + sizeof(BandStatistics) * getBandCount(key);
+}
+
+static uint64_t getTilesOffset(const cache::Key& key) {
+    return getTileTableOffset(key) + sizeof(uint64_t) * getTileCount(key);
+}
+
+// An order-0 rANS coder renormalizing 16 bits at a time, with four interleaved states so that consecutive symbols
+// decode independently of each other. A symbol takes one table lookup, one multiply-add and at most one word read
+namespace rans {
+    constexpr auto PROB_BITS = 12u;
+    constexpr auto PROB_SCALE = 1u << PROB_BITS;
+    constexpr auto LOWER_BOUND = 1u << 16;
+    constexpr auto STATE_COUNT = 4;
+    constexpr auto TABLE_BYTE_SIZE = sizeof(uint16_t) * 256;
+
+    // Scales symbol counts to frequencies summing to PROB_SCALE, every symbol that occurs keeps at least 1
+    std::array<uint32_t, 256> normalize(const std::array<uint32_t, 256>& counts, const std::size_t total) {
+        auto frequencies = std::array<uint32_t, 256>{};
+        auto sum = 0u;
+        for (auto s = 0; s < 256; ++s) {
+            if (counts[s] > 0) {
+                frequencies[s] = std::max(static_cast<uint32_t>(uint64_t{ counts[s] } * PROB_SCALE / total), 1u);
+                sum += frequencies[s];
+            }
+        }
+
+        // Rounding errors go to the most frequent symbols, where they cost the least
+        while (sum != PROB_SCALE) {
+            auto& largest = *std::ranges::max_element(frequencies);
+            if (sum > PROB_SCALE) {
+                --largest;
+                --sum;
+            } else {
+                ++largest;
+                ++sum;
+            }
+        }
+        return frequencies;
+    }
+
+    // Appends the frequency table and the encoded plane, unless that would take more than maxByteSize
+    bool encode(
+        const std::span<const uint8_t> plane,
+        const std::array<uint32_t, 256>& counts,
+        const std::size_t maxByteSize,
+        std::vector<uint8_t>& output
+    ) {
+        const auto frequencies = normalize(counts, plane.size());
+        auto starts = std::array<uint32_t, 256>{};
+        for (auto s = 1; s < 256; ++s) {
+            starts[s] = starts[s - 1] + frequencies[s - 1];
+        }
+
+        // rANS encodes backwards, so that the decoder reads forwards
+        const auto maxWordCount = maxByteSize / sizeof(uint16_t);
+        auto words = std::vector<uint16_t>(maxWordCount);
+        const auto begin = words.data();
+        auto pointer = begin + words.size();
+        auto states = std::array<uint32_t, STATE_COUNT>{};
+        states.fill(LOWER_BOUND);
+        for (auto i = plane.size(); i-- > 0;) {
+            auto& state = states[i % STATE_COUNT];
+            const auto symbol = plane[i];
+            const auto frequency = frequencies[symbol];
+            if (state >= (LOWER_BOUND >> PROB_BITS << 16) * frequency) {
+                if (pointer == begin) return false;
+                *--pointer = static_cast<uint16_t>(state);
+                state >>= 16;
+            }
+            state = (state / frequency << PROB_BITS) + state % frequency + starts[symbol];
+        }
+
+        // The last state goes first from the end, the decoder then reads the first state first
+        for (auto s = STATE_COUNT; s-- > 0;) {
+            if (pointer - begin < 2 + static_cast<std::ptrdiff_t>(TABLE_BYTE_SIZE / sizeof(uint16_t))) return false;
+            pointer -= 2;
+            pointer[0] = static_cast<uint16_t>(states[s]);
+            pointer[1] = static_cast<uint16_t>(states[s] >> 16);
+        }
+
+        auto table = std::array<uint16_t, 256>{};
+        std::ranges::copy(frequencies, table.begin());
+        const auto tableBytes = reinterpret_cast<const uint8_t*>(table.data());
+        output.insert(output.end(), tableBytes, tableBytes + TABLE_BYTE_SIZE);
+        const auto wordBytes = reinterpret_cast<const uint8_t*>(pointer);
+        output.insert(output.end(), wordBytes, wordBytes + sizeof(uint16_t) * (begin + words.size() - pointer));
+        return true;
+    }
+
+    void decode(const std::span<const uint8_t> encoded, const std::span<uint8_t> plane) {
+        if (encoded.size() < TABLE_BYTE_SIZE + sizeof(uint32_t) * STATE_COUNT ||
+            encoded.size() % sizeof(uint16_t) != 0) {
+            throw std::runtime_error("Truncated plane");
+        }
+
+        // Symbols are looked up by slot, together with their frequency and start
+        auto table = std::array<uint16_t, 256>{};
+        std::memcpy(table.data(), encoded.data(), TABLE_BYTE_SIZE);
+        auto slots = std::array<uint32_t, PROB_SCALE>{};
+        auto sum = 0u;
+        for (auto s = 0u; s < 256; ++s) {
+            if (sum + table[s] > PROB_SCALE) {
+                throw std::runtime_error("Malformed frequency table");
+            }
+            // Frequency in the upper 12 bits plus one, start in the middle 12 bits and symbol in the lower 8
+            std::fill_n(slots.begin() + sum, table[s], (table[s] - 1u) << 20 | sum << 8 | s);
+            sum += table[s];
+        }
+        if (sum != PROB_SCALE) {
+            throw std::runtime_error("Malformed frequency table");
+        }
+
+        auto pointer = encoded.data() + TABLE_BYTE_SIZE;
+        const auto end = encoded.data() + encoded.size();
+        const auto readWord = [&pointer] {
+            auto word = uint16_t{};
+            std::memcpy(&word, pointer, sizeof(word));
+            pointer += sizeof(word);
+            return static_cast<uint32_t>(word);
+        };
+        auto states = std::array<uint32_t, STATE_COUNT>{};
+        for (auto& state : states) {
+            state = readWord();
+            state |= readWord() << 16;
+        }
+
+        const auto decodeSymbol = [&slots](uint32_t& state) {
+            const auto slot = slots[state & (PROB_SCALE - 1)];
+            state = ((slot >> 20) + 1) * (state >> PROB_BITS) + (state & (PROB_SCALE - 1)) - (slot >> 8 & 0xfff);
+            return static_cast<uint8_t>(slot);
+        };
+
+        // Each group of symbols reads at most one word per state, only the last groups need bounds checks. Whether a
+        // state needs renormalizing is as good as random, selecting the word beats branching on it
+        const auto output = plane.data();
+        auto i = std::size_t{ 0 };
+        const auto renormalize = [&pointer](uint32_t& state) {
+            auto word = uint16_t{};
+            std::memcpy(&word, pointer, sizeof(word));
+            const auto renormalized = state < LOWER_BOUND;
+            state = renormalized ? state << 16 | word : state;
+            pointer += renormalized ? sizeof(word) : 0;
+        };
+        constexpr auto GROUP_BYTE_SIZE = static_cast<std::ptrdiff_t>(sizeof(uint16_t) * STATE_COUNT);
+        for (; i + STATE_COUNT <= plane.size() && end - pointer >= GROUP_BYTE_SIZE; i += STATE_COUNT) {
+            for (auto s = 0; s < STATE_COUNT; ++s) {
+                output[i + s] = decodeSymbol(states[s]);
+            }
+            for (auto s = 0; s < STATE_COUNT; ++s) {
+                renormalize(states[s]);
+            }
+        }
+        for (; i < plane.size(); ++i) {
+            auto& state = states[i % STATE_COUNT];
+            output[i] = decodeSymbol(state);
+            if (state < LOWER_BOUND) {
+                if (pointer == end) {
+                    throw std::runtime_error("Truncated plane");
+                }
+                state = state << 16 | readWord();
+            }
+        }
+    }
+}
+
+// A plane made of one byte but for a few exceptions, stored as the gaps between them and their values. Cheaper to
+// decode than any entropy coder
+namespace sparse {
+    // Appends the common byte and the exceptions, unless that would take more than maxByteSize
+    bool encode(
+        const std::span<const uint8_t> plane,
+        const uint8_t common,
+        const std::size_t maxByteSize,
+        std::vector<uint8_t>& output
+    ) {
+        auto encoded = std::vector<uint8_t>{ common };
+        auto previous = std::size_t{ 0 };
+        for (std::size_t i = 0; i < plane.size(); ++i) {
+            if (plane[i] == common) continue;
+
+            // Gaps are written 7 bits at a time, the high bit set on all but the last byte
+            for (auto gap = i - previous; ; gap >>= 7) {
+                encoded.push_back(static_cast<uint8_t>((gap & 0x7f) | (gap > 0x7f ? 0x80 : 0)));
+                if (gap <= 0x7f) break;
+            }
+            encoded.push_back(plane[i]);
+            previous = i;
+            if (encoded.size() > maxByteSize) return false;
+        }
+        output.insert(output.end(), encoded.begin(), encoded.end());
+        return true;
+    }
+
+    void decode(const std::span<const uint8_t> encoded, const std::span<uint8_t> plane) {
+        if (encoded.empty()) {
+            throw std::runtime_error("Truncated plane");
+        }
+        std::ranges::fill(plane, encoded[0]);
+
+        auto index = std::size_t{ 0 };
+        for (std::size_t position = 1; position < encoded.size();) {
+            auto gap = std::size_t{ 0 };
+            for (auto shift = 0; ; shift += 7) {
+                if (position == encoded.size() || shift > 28) {
+                    throw std::runtime_error("Malformed sparse plane");
+                }
+                const auto byte = encoded[position++];
+                gap |= static_cast<std::size_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) break;
+            }
+            index += gap;
+            if (position == encoded.size() || index >= plane.size()) {
+                throw std::runtime_error("Malformed sparse plane");
+            }
+            plane[index] = encoded[position++];
+        }
+    }
+}
+
+// Deltas of bit patterns are zigzag encoded, so that small negative deltas get as many leading zero bytes as positive
+static uint32_t encodeDelta(const uint32_t bits, const uint32_t previousBits) {
+    const auto delta = bits - previousBits;
+    return delta << 1 ^ (0u - (delta >> 31));
+}
+
+static uint32_t decodeDelta(const uint32_t zigzag, const uint32_t previousBits) {
+    return previousBits + (zigzag >> 1 ^ (0u - (zigzag & 1)));
+}
+
+std::vector<uint8_t> cache::encodeTile(const std::span<const float> cube, const Key& key, const uint64_t tile) {
+    const auto pixelCount = getPixelCount(key);
+    const auto bandCount = getBandCount(key);
+    const auto firstPixel = tile * mTilePixelCount;
+    const auto tilePixelCount = std::min<uint64_t>(mTilePixelCount, pixelCount - firstPixel);
+
+    // Byte k of every delta goes to plane k, in band then pixel order
+    const auto planeSize = tilePixelCount * bandCount;
+    auto planes = std::array<std::vector<uint8_t>, mPlaneCount>{};
+    std::ranges::for_each(planes, [planeSize](auto& plane) { plane.resize(planeSize); });
+    for (uint64_t b = 0; b < bandCount; ++b) {
+        const auto band = cube.data() + b * pixelCount + firstPixel;
+        for (uint64_t p = 0; p < tilePixelCount; ++p) {
+            const auto previousBits = b > 0 ? std::bit_cast<uint32_t>(band[p - pixelCount]) : 0u;
+            const auto zigzag = encodeDelta(std::bit_cast<uint32_t>(band[p]), previousBits);
+            for (auto k = 0; k < mPlaneCount; ++k) {
+                planes[k][b * tilePixelCount + p] = static_cast<uint8_t>(zigzag >> 8 * k);
+            }
+        }
+    }
+
+    auto headers = std::array<PlaneHeader, mPlaneCount>{};
+    auto output = std::vector<uint8_t>(sizeof(headers));
+    for (auto k = 0; k < mPlaneCount; ++k) {
+        const auto& plane = planes[k];
+        const auto offset = output.size();
+        auto counts = std::array<uint32_t, 256>{};
+        for (const auto byte : plane) {
+            ++counts[byte];
+        }
+
+        // Prefer what decodes fastest, as long as it compresses about as well: sparse planes when there are few
+        // exceptions, then entropy coding when it saves enough to be worth the decoding time, raw bytes otherwise
+        const auto common = static_cast<uint8_t>(std::ranges::max_element(counts) - counts.begin());
+        if (sparse::encode(plane, common, plane.size() / mSparseRatio, output)) {
+            headers[k].mode = PlaneMode::Sparse;
+        } else if (rans::encode(plane, counts, plane.size() - plane.size() / mRansMinSaving, output)) {
+            headers[k].mode = PlaneMode::Rans;
+        } else {
+            headers[k].mode = PlaneMode::Raw;
+            output.insert(output.end(), plane.begin(), plane.end());
+        }
+        headers[k].byteSize = static_cast<uint32_t>(output.size() - offset);
+    }
+    std::memcpy(output.data(), headers.data(), sizeof(headers));
+    return output;
+}
+
+void cache::decodeTile(
+    const std::span<const uint8_t> encoded,
+    const Key& key,
+    const uint64_t tile,
+    const std::span<float> cube
+) {
+    const auto pixelCount = getPixelCount(key);
+    const auto bandCount = getBandCount(key);
+    const auto firstPixel = tile * mTilePixelCount;
+    const auto tilePixelCount = std::min<uint64_t>(mTilePixelCount, pixelCount - firstPixel);
+
+    auto headers = std::array<PlaneHeader, mPlaneCount>{};
+    if (encoded.size() < sizeof(headers)) {
+        throw std::runtime_error("Truncated tile");
+    }
+    std::memcpy(headers.data(), encoded.data(), sizeof(headers));
+
+    // Planes are decoded into buffers reused by every tile this thread decodes
+    const auto planeSize = tilePixelCount * bandCount;
+    thread_local auto planes = std::array<std::vector<uint8_t>, mPlaneCount>{};
+    auto offset = sizeof(headers);
+    for (auto k = 0; k < mPlaneCount; ++k) {
+        if (headers[k].byteSize > encoded.size() - offset) {
+            throw std::runtime_error("Truncated tile");
+        }
+        const auto bytes = encoded.subspan(offset, headers[k].byteSize);
+        auto& plane = planes[k];
+        plane.resize(planeSize);
+        switch (headers[k].mode) {
+            case PlaneMode::Sparse:
+                sparse::decode(bytes, plane);
+                break;
+            case PlaneMode::Raw:
+                if (bytes.size() != planeSize) throw std::runtime_error("Malformed raw plane");
+                std::ranges::copy(bytes, plane.begin());
+                break;
+            case PlaneMode::Rans:
+                rans::decode(bytes, plane);
+                break;
+            default:
+                throw std::runtime_error("Unknown plane encoding");
+        }
+        offset += headers[k].byteSize;
+    }
+
+    // Shuffle the bytes back together and undo the deltas band after band, keeping the previous band in place
+    const auto plane0 = planes[0].data();
+    const auto plane1 = planes[1].data();
+    const auto plane2 = planes[2].data();
+    const auto plane3 = planes[3].data();
+    thread_local auto previousBits = std::vector<uint32_t>{};
+    previousBits.assign(tilePixelCount, 0u);
+    const auto previous = previousBits.data();
+    for (uint64_t b = 0; b < bandCount; ++b) {
+        const auto band = cube.data() + b * pixelCount + firstPixel;
+        const auto i = b * tilePixelCount;
+        for (uint64_t p = 0; p < tilePixelCount; ++p) {
+            const auto zigzag = static_cast<uint32_t>(plane0[i + p]) | static_cast<uint32_t>(plane1[i + p]) << 8 |
+                static_cast<uint32_t>(plane2[i + p]) << 16 | static_cast<uint32_t>(plane3[i + p]) << 24;
+            previous[p] = decodeDelta(zigzag, previous[p]);
+            band[p] = std::bit_cast<float>(previous[p]);
+        }
+    }
+}
+
+// The whole file mapped read-only, the mapping outlives the file handles
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+        const auto file = CreateFileW(
+            path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return;
+        auto size = LARGE_INTEGER{};
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            return;
+        }
+        const auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) return;
+        const auto data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (data == nullptr) return;
+        _data = static_cast<const uint8_t*>(data);
+        _size = static_cast<std::size_t>(size.QuadPart);
+#else
+        const auto descriptor = open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) return;
+        struct stat status{};
+        if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+            close(descriptor);
+            return;
+        }
+        const auto size = static_cast<std::size_t>(status.st_size);
+        const auto data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        close(descriptor);
+        if (data == MAP_FAILED) return;
+        _data = static_cast<const uint8_t*>(data);
+        _size = size;
+#endif
+    }
+
+    ~MappedFile() {
+        if (_data == nullptr) return;
+#ifdef _WIN32
+        UnmapViewOfFile(_data);
+#else
+        munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] std::span<const uint8_t> getData() const {
+        return { _data, _size };
+    }
+
+private:
+    const uint8_t* _data{ nullptr };
+    std::size_t _size{ 0 };
+};
+
+cache::Key cache::makeKey(
+    const std::span<const std::filesystem::path> sources,
+    const int rasterX,
+    const int rasterY,
+    const int bandBegin,
+    const int bandEnd
+) {
+    // FNV-1a over the path, size and write time of every file, stable across runs unlike std::hash
+    auto fingerprint = uint64_t{ 0xcbf29ce484222325 };
+    const auto mix = [&fingerprint](const void* data, const std::size_t size) {
+        for (const auto byte : std::span{ static_cast<const uint8_t*>(data), size }) {
+            fingerprint = (fingerprint ^ byte) * 0x100000001b3;
+        }
+    };
+
+    auto totalSize = uint64_t{ 0 };
+    for (const auto& source : sources) {
+        auto sizeError = std::error_code{};
+        auto timeError = std::error_code{};
+        const auto size = static_cast<uint64_t>(std::filesystem::file_size(source, sizeError));
+        const auto writeTime = static_cast<int64_t>(
+            std::filesystem::last_write_time(source, timeError).time_since_epoch().count());
+        if (sizeError || timeError) {
+            PLOGW << "Could not inspect " << source.string() << ": " << (sizeError ? sizeError : timeError).message();
+            return { std::numeric_limits<uint64_t>::max(), 0, rasterX, rasterY, bandBegin, bandEnd };
+        }
+
+        const auto path = std::filesystem::absolute(source).generic_string();
+        mix(path.data(), path.size());
+        mix(&size, sizeof(size));
+        mix(&writeTime, sizeof(writeTime));
+        totalSize += size;
+    }
+    return { totalSize, fingerprint, rasterX, rasterY, bandBegin, bandEnd };
+}
+
+std::filesystem::path cache::getCubePath(const std::filesystem::path& directory, const std::filesystem::path& source) {
+    // Datasets of the same name in different directories get different cubes
+    const auto hash = std::hash<std::string>{}(std::filesystem::absolute(source).string());
+    return directory / std::format("{}-{:016x}.cube", source.stem().string(), hash);
+}
+
+// Statistics of the reflectances clamped to [0, 1], as the region reduction computes them on the GPU. Values that
+// aren't finite, like missing data, are left out
+static BandStatistics computeStatistics(const std::span<const float> band) {
+    auto sum = 0.0;
+    auto sumOfSquares = 0.0;
+    auto count = std::size_t{ 0 };
+    auto minimum = 1.0f;
+    auto maximum = 0.0f;
+    for (const auto value : band) {
+        if (!std::isfinite(value)) continue;
+
+        const auto reflectance = std::clamp(value, 0.0f, 1.0f);
+        sum += reflectance;
+        sumOfSquares += static_cast<double>(reflectance) * reflectance;
+        minimum = std::min(minimum, reflectance);
+        maximum = std::max(maximum, reflectance);
+        ++count;
+    }
+    if (count == 0) {
+        return { 0.0f, 0.0f, 0.0f, 0.0f };
+    }
+
+    const auto mean = sum / static_cast<double>(count);
+    const auto variance = std::max(sumOfSquares / static_cast<double>(count) - mean * mean, 0.0);
+    return { static_cast<float>(mean), static_cast<float>(std::sqrt(variance)), minimum, maximum };
+}
+
+// Statistics that computeStatistics could not have produced mean the cube was overwritten or damaged
+static bool isConsistent(const BandStatistics& statistics) {
+    const auto [mean, deviation, minimum, maximum] = statistics;
+    return std::isfinite(deviation) && deviation >= 0.0f && deviation <= 1.0f &&
+        minimum >= 0.0f && minimum <= mean && mean <= maximum && maximum <= 1.0f;
+}
+
+std::optional<cache::Cube> cache::readCube(
+    const std::filesystem::path& path,
+    const Key& key,
+    const std::span<const double> centers
+) {
+    const auto file = MappedFile{ path };
+    const auto data = file.getData();
+    if (data.empty()) {
+        PLOGI << "No preprocessed cube found at " << path.string() << ", the dataset will be read from its source";
+        return {};
+    }
+    const auto discard = [&path](const std::string_view reason) {
+        PLOGI << "Preprocessed cube at " << path.string() << " " << reason << ", discarding it";
+        return std::nullopt;
+    };
+
+    auto header = CubeHeader{};
+    if (data.size() < sizeof(header)) {
+        return discard("is of an unknown format");
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != mMagic || header.version != mVersion || header.tilePixelCount != mTilePixelCount) {
+        return discard("is of an unknown format");
+    }
+    if (header.key != key || centers.size() != getBandCount(key) || data.size() < getTilesOffset(key) ||
+        std::memcmp(data.data() + sizeof(header), centers.data(), centers.size_bytes()) != 0) {
+        return discard("was preprocessed from another version of the dataset or with other parameters");
+    }
+
+    const auto tileCount = getTileCount(key);
+    auto tileEnds = std::vector<uint64_t>(tileCount);
+    std::memcpy(tileEnds.data(), data.data() + getTileTableOffset(key), sizeof(uint64_t) * tileCount);
+    const auto tiles = data.subspan(getTilesOffset(key));
+    if (header.tileCount != tileCount || !std::ranges::is_sorted(tileEnds) ||
+        (!tileEnds.empty() && tileEnds.back() > tiles.size())) {
+        return discard("is truncated");
+    }
+
+    const auto statistics = std::span{
+        reinterpret_cast<const BandStatistics*>(data.data() + getStatisticsOffset(key)), getBandCount(key) };
+    if (!std::ranges::all_of(statistics, isConsistent)) {
+        return discard("is corrupted");
+    }
+
+    auto cube = Cube{
+        std::vector<float>(getPixelCount(key) * getBandCount(key)), { statistics.begin(), statistics.end() } };
+    try {
+        parallelFor(tileCount, [&](const uint64_t tile) {
+            const auto begin = tile > 0 ? tileEnds[tile - 1] : 0;
+            decodeTile(tiles.subspan(begin, tileEnds[tile] - begin), key, tile, cube.data);
+        });
+    } catch (const std::exception& e) {
+        return discard(std::format("is corrupted ({})", e.what()));
+    }
+    return cube;
+}
+
+cache::CubeWriter::CubeWriter(
+    const std::filesystem::path& path,
+    const Key& key,
+    const std::span<const double> centers
+) noexcept : _path{ path }, _key{ key }, _centers{ centers.begin(), centers.end() } {
+    try {
+        _data.reserve(getPixelCount(key) * getBandCount(key));
+    } catch (const std::exception& e) {
+        fail(e.what());
+    }
+}
+
+void cache::CubeWriter::append(const std::span<const float> band) noexcept {
+    if (_failed) return;
+
+    _statistics.push_back(computeStatistics(band));
+
+    // Reserved up front, this never reallocates
+    _data.insert(_data.end(), band.begin(), band.end());
+}
+
+void cache::CubeWriter::commit() noexcept {
+    if (_failed) return;
+    if (_statistics.size() != getBandCount(_key) || _data.size() != getPixelCount(_key) * getBandCount(_key)) {
+        fail("some bands are missing");
+        return;
+    }
+
+    try {
+        const auto tileCount = getTileCount(_key);
+        auto tiles = std::vector<std::vector<uint8_t>>(tileCount);
+        parallelFor(tileCount, [&](const uint64_t tile) { tiles[tile] = encodeTile(_data, _key, tile); });
+
+        auto tileEnds = std::vector<uint64_t>(tileCount);
+        auto end = uint64_t{ 0 };
+        for (uint64_t tile = 0; tile < tileCount; ++tile) {
+            end += tiles[tile].size();
+            tileEnds[tile] = end;
+        }
+
+        // Write to a temporary file first so that a crash midway never leaves a corrupted cube behind
+        std::filesystem::create_directories(_path.parent_path());
+        auto tempPath = _path;
+        tempPath += ".tmp";
+        {
+            const auto header = CubeHeader{ mMagic, mVersion, _key, mTilePixelCount, static_cast<uint32_t>(tileCount) };
+            auto file = std::ofstream{ tempPath, std::ios::binary | std::ios::trunc };
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(_centers.data()),
+                static_cast<std::streamsize>(sizeof(double) * _centers.size()));
+            file.write(reinterpret_cast<const char*>(_statistics.data()),
+                static_cast<std::streamsize>(sizeof(BandStatistics) * _statistics.size()));
+            file.write(reinterpret_cast<const char*>(tileEnds.data()),
+                static_cast<std::streamsize>(sizeof(uint64_t) * tileEnds.size()));
+            for (const auto& tile : tiles) {
+                file.write(reinterpret_cast<const char*>(tile.data()), static_cast<std::streamsize>(tile.size()));
+            }
+            if (!file) {
+                fail("could not write the file");
+                std::filesystem::remove(tempPath);
+                return;
+            }
+        }
+        std::filesystem::rename(tempPath, _path);
+
+        const auto rawSize = sizeof(float) * _data.size();
+        PLOGD << "Saved the preprocessed cube to " << _path.string() << ", compressed to "
+              << std::format("{:.1f}", 100.0 * static_cast<double>(end) / static_cast<double>(rawSize)) << "%";
+    } catch (const std::exception& e) {
+        fail(e.what());
+    }
+
+    // The cube has been uploaded already, don't hold on to a second copy
+    _data = {};
+}
+
+void cache::CubeWriter::fail(const char* const what) noexcept {
+    PLOGW << "Could not cache the preprocessed cube at " << _path.string() << ": " << what;
+    _failed = true;
+    _data = {};
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "pan.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace cache {
+    // Everything the contents of a preprocessed cube depend on. A cube whose key no longer matches is rebuilt
+    struct Key {
+        uint64_t sourceSize;
+        uint64_t sourceFingerprint;
+        int32_t rasterX;
+        int32_t rasterY;
+        int32_t bandBegin;
+        int32_t bandEnd;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    // Keys a dataset made of these files with the parameters it gets preprocessed with. Every file counts, an ENVI
+    // header edited next to its untouched data file changes how the data decodes. A source that can't be inspected
+    // gets a key no cube matches
+    [[nodiscard]] Key makeKey(
+        std::span<const std::filesystem::path> sources, int rasterX, int rasterY, int bandBegin, int bandEnd);
+
+    // Every dataset has a single cube in the cache directory, whatever parameters it was last preprocessed with
+    [[nodiscard]] std::filesystem::path getCubePath(
+        const std::filesystem::path& directory, const std::filesystem::path& source);
+
+    // A preprocessed cube: the resampled bands as floats, band after band like the cube buffer on the GPU
+    struct Cube {
+        std::vector<float> data;
+        std::vector<BandStatistics> statistics;
+    };
+
+    // Cubes of this key get cut into as many tiles of pixels, each covering all bands
+    [[nodiscard]] uint64_t getTileCount(const Key& key);
+
+    // Compresses a tile of a cube of this key, independently of the other tiles
+    [[nodiscard]] std::vector<uint8_t> encodeTile(std::span<const float> cube, const Key& key, uint64_t tile);
+
+    // Decompresses a tile into its pixels of the cube, throwing std::runtime_error if it is corrupted or truncated
+    void decodeTile(std::span<const uint8_t> encoded, const Key& key, uint64_t tile, std::span<float> cube);
+
+    /**
+     * Maps the cube at the given path and decompresses it across all hardware threads, if it was written for the same
+     * key and band centers.
+     *
+     * @return The cube, or an empty optional if there is none or it is stale, corrupted or of an unknown format.
+     */
+    [[nodiscard]] std::optional<Cube> readCube(
+        const std::filesystem::path& path, const Key& key, std::span<const double> centers);
+
+    /**
+     * Collects a cube band by band as it gets preprocessed, then compresses it to a temporary file that only replaces
+     * the cached cube once complete. Failing to write is never fatal, the cube simply won't be cached.
+     *
+     * Bands are cut into tiles of pixels compressed independently of each other. Within a tile, each value is stored as
+     * the difference of its bit pattern from the same pixel in the previous band, the bytes of these differences are
+     * split into four planes, and each plane is entropy coded.
+     */
+    class CubeWriter {
+    public:
+        CubeWriter(const std::filesystem::path& path, const Key& key, std::span<const double> centers) noexcept;
+
+        void append(std::span<const float> band) noexcept;
+        void commit() noexcept;
+
+        // Gives up on caching, for instance when a band could not be read. Nothing gets committed afterwards
+        void fail(const char* what) noexcept;
+
+    private:
+
+        std::filesystem::path _path;
+        Key _key;
+        std::vector<double> _centers;
+        std::vector<float> _data{};
+        std::vector<BandStatistics> _statistics{};
+        bool _failed{ false };
+    };
+}
@@ -0,0 +1,92 @@
+#include "downscale.h"
+#include "pan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <stdexcept>
+
+
+// Few enough target rows per task to balance the threads, enough to amortize the column sums buffer
+static constexpr auto mRowsPerTask = 8;
+
+// Pixel edges falling this close to a source pixel edge are taken to be on it, so that rounding errors of fractional
+// factors don't add source pixels of negligible weight
+static constexpr auto mEdgeTolerance = 1e-9;
+
+downscale::AreaAverage::AreaAverage(const int sourceX, const int sourceY, const int targetX, const int targetY)
+    : _sourceX{ sourceX }, _sourceY{ sourceY }, _targetX{ targetX }, _targetY{ targetY } {
+    if (targetX <= 0 || targetY <= 0 || targetX > sourceX || targetY > sourceY) {
+        throw std::invalid_argument(std::format(
+            "Cannot downscale {} x {} to {} x {}", sourceX, sourceY, targetX, targetY));
+    }
+    computeFootprints(sourceX, targetX, _columns, _columnWeights);
+    computeFootprints(sourceY, targetY, _rows, _rowWeights);
+}
+
+void downscale::AreaAverage::computeFootprints(
+    const int sourceSize,
+    const int targetSize,
+    std::vector<Footprint>& footprints,
+    std::vector<float>& weights
+) {
+    const auto scale = static_cast<double>(sourceSize) / targetSize;
+    footprints.reserve(targetSize);
+    for (auto t = 0; t < targetSize; ++t) {
+        const auto begin = t * scale;
+        const auto end = std::min((t + 1) * scale, static_cast<double>(sourceSize));
+        const auto first = static_cast<int>(std::floor(begin + mEdgeTolerance));
+        const auto last = std::min(static_cast<int>(std::ceil(end - mEdgeTolerance)), sourceSize) - 1;
+
+        footprints.push_back({ first, last - first + 1, static_cast<uint32_t>(weights.size()) });
+        for (auto i = first; i <= last; ++i) {
+            const auto overlap = std::min(end, i + 1.0) - std::max(begin, static_cast<double>(i));
+            weights.push_back(static_cast<float>(overlap / scale));
+        }
+    }
+}
+
+void downscale::AreaAverage::apply(const std::span<const float> source, const std::span<float> target) const {
+    if (source.size() != static_cast<std::size_t>(_sourceX) * _sourceY ||
+        target.size() != static_cast<std::size_t>(_targetX) * _targetY) {
+        throw std::invalid_argument("Band sizes don't match the downscaling");
+    }
+
+    const auto taskCount = (_targetY + mRowsPerTask - 1) / mRowsPerTask;
+    parallelFor(taskCount, [&](const uint64_t task) {
+        auto columnSums = std::vector<float>(_sourceX);
+        const auto sums = columnSums.data();
+
+        const auto rowBegin = static_cast<int>(task) * mRowsPerTask;
+        const auto rowEnd = std::min(rowBegin + mRowsPerTask, _targetY);
+        for (auto y = rowBegin; y < rowEnd; ++y) {
+            // Down the columns, each source row a contiguous multiply-add
+            const auto& row = _rows[y];
+            const auto rowWeights = _rowWeights.data() + row.weightOffset;
+            const auto firstRow = source.data() + static_cast<std::size_t>(row.first) * _sourceX;
+            for (auto x = 0; x < _sourceX; ++x) {
+                sums[x] = rowWeights[0] * firstRow[x];
+            }
+            for (auto j = 1; j < row.count; ++j) {
+                const auto sourceRow = firstRow + static_cast<std::size_t>(j) * _sourceX;
+                const auto weight = rowWeights[j];
+                for (auto x = 0; x < _sourceX; ++x) {
+                    sums[x] += weight * sourceRow[x];
+                }
+            }
+
+            // Along the row, over factor times fewer values
+            const auto targetRow = target.data() + static_cast<std::size_t>(y) * _targetX;
+            for (auto x = 0; x < _targetX; ++x) {
+                const auto& column = _columns[x];
+                const auto columnWeights = _columnWeights.data() + column.weightOffset;
+                auto sum = 0.0f;
+                for (auto i = 0; i < column.count; ++i) {
+                    sum += columnWeights[i] * sums[column.first + i];
+                }
+                targetRow[x] = sum;
+            }
+        }
+    });
+}
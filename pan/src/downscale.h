@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+namespace downscale {
+    /**
+     * Downscales bands by averaging each target pixel over the area of the source it covers, so that detail finer than
+     * a target pixel blends in rather than aliasing. The ratio of source to target size may be any integer or
+     * fractional factor, source pixels straddling the edge of a target pixel contribute by the fraction of their area
+     * inside it.
+     *
+     * Each band is averaged down the columns first, over contiguous rows the compiler vectorizes, then along the much
+     * shorter averaged row. Target rows are split across all hardware threads.
+     */
+    class AreaAverage {
+    public:
+        AreaAverage(int sourceX, int sourceY, int targetX, int targetY);
+
+        // The source holds sourceX * sourceY values and the target targetX * targetY, both row after row
+        void apply(std::span<const float> source, std::span<float> target) const;
+
+    private:
+        // The source pixels a target pixel covers along one axis, with their weights summing to 1
+        struct Footprint {
+            int first;
+            int count;
+            uint32_t weightOffset;
+        };
+
+        static void computeFootprints(
+            int sourceSize, int targetSize, std::vector<Footprint>& footprints, std::vector<float>& weights);
+
+        int _sourceX;
+        int _sourceY;
+        int _targetX;
+        int _targetY;
+        std::vector<Footprint> _columns{};
+        std::vector<Footprint> _rows{};
+        std::vector<float> _columnWeights{};
+        std::vector<float> _rowWeights{};
+    };
+}
@@ -4,8 +4,11 @@
 
 #include <imgui.h>
 
+#include <algorithm>
 #include <format>
+#include <numbers>
 #include <ranges>
+#include <utility>
 
 
 void GUI::define() {
@@ -14,6 +17,8 @@ void GUI::define() {
     defineIlluminantWindow();
     defineSensorWindow();
     definePCAWindow();
+    defineSimilarityWindow();
+    defineBandMathWindow();
 }
 
 void GUI::definePerformanceMetricWindow() {
@@ -32,6 +37,57 @@ void GUI::definePerformanceMetricWindow() {
     // Show frame time (milliseconds per frame)
     ImGui::Text("Frame time: %.3f ms/frame", 1000.0f / io.Framerate);
 
+    // Rendering continuously makes the frame rate above meaningful, on demand it drops to zero while idle
+    ImGui::Checkbox("Render on demand", &_renderOnDemand);
+
+    // Trade throughput for input latency
+    static const char* presentModes[] = { "FIFO", "Mailbox", "Immediate" };
+    ImGui::Combo("Present mode", &_presentMode, presentModes, IM_ARRAYSIZE(presentModes));
+    ImGui::SliderInt("Frames in flight", &_framesInFlight, 1, Renderer::getMaxFramesInFlight());
+    if (const auto latency = _inputLatency.load(); latency > 0.0f) {
+        ImGui::Text("Input to GPU completion: %.2f ms", latency);
+    }
+    if (_probeLatency > 0.0f) {
+        ImGui::Text("Click to spectral curve: %.2f ms", _probeLatency);
+    }
+
+    // Show GPU times per pass and per drawable
+    std::lock_guard lock(_gpuTimingsMutex);
+    if (_gpuTimings.frame > 0.0f) {
+        ImGui::Separator();
+        ImGui::Text("GPU frame: %.3f ms", _gpuTimings.frame);
+        ImGui::Text("GPU view pass: %.3f ms", _gpuTimings.view);
+        ImGui::Text("GPU overlay pass: %.3f ms", _gpuTimings.overlay);
+        for (const auto& [name, time] : _gpuTimings.drawables) {
+            ImGui::BulletText("%s: %.3f ms", name.c_str(), time);
+        }
+
+        const auto maxTime = std::ranges::max(_gpuFrameHistory);
+        ImGui::PlotLines("##GPU", _gpuFrameHistory.data(), GPU_HISTORY_SIZE, _gpuFrameHistoryOffset, nullptr,
+            0.0f, maxTime * 1.2f, ImVec2{ 0.0f, 60.0f });
+    } else {
+        ImGui::Text("GPU timings are not available.");
+    }
+
+    // Show GPU memory budgets and what we've allocated
+    std::lock_guard memoryLock(_memoryStatisticsMutex);
+    if (ImGui::CollapsingHeader("GPU memory")) {
+        static constexpr auto MiB = 1024.0f * 1024.0f;
+        for (std::size_t i = 0; i < _memoryStatistics.heaps.size(); ++i) {
+            const auto& heap = _memoryStatistics.heaps[i];
+            const auto usage = static_cast<float>(heap.usage) / MiB;
+            const auto budget = static_cast<float>(heap.budget) / MiB;
+            ImGui::Text("Heap %zu%s: %.1f / %.1f MiB", i, heap.deviceLocal ? " (device local)" : "", usage, budget);
+            ImGui::ProgressBar(budget > 0.0f ? usage / budget : 0.0f);
+        }
+        for (int i = 0; i < RESOURCE_KIND_COUNT; ++i) {
+            const auto& [count, bytes] = _memoryStatistics.resources[i];
+            const auto name = getResourceKindName(static_cast<ResourceKind>(i));
+            ImGui::BulletText("%.*s: %u, %.1f MiB", static_cast<int>(name.size()), name.data(), count,
+                static_cast<float>(bytes) / MiB);
+        }
+    }
+
     ImGui::End();
 }
 
@@ -46,6 +102,11 @@ void GUI::defineSpectralCurveWindow() {
     ImGui::Begin("Spectral reflectance", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse);
 
     std::lock_guard lock(_spectralCurveMutex);
+    if (_spectralCurveRequestTime) {
+        // First shown in this frame
+        const auto latency = std::chrono::steady_clock::now() - *std::exchange(_spectralCurveRequestTime, std::nullopt);
+        _probeLatency = std::chrono::duration<float, std::milli>(latency).count();
+    }
     if (!_spectralCurve.empty()) {
         std::lock_guard imgCoordLock(_imgCoordinatesMutex);
         ImGui::Text(std::format("Reflectance values at ({}, {})", _currentImgX, _currentImgY).c_str());
@@ -56,9 +117,69 @@ void GUI::defineSpectralCurveWindow() {
         ImGui::Text("No data to display.");
     }
 
+    plotRegionStatistics();
+
+    // Pinned samples stay marked on the frame while the probe moves on
+    if (ImGui::Button("Pin sample")) {
+        _pinRequested = true;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear pins")) {
+        _clearPinsRequested = true;
+    }
+    ImGui::SameLine();
+    ImGui::Text("%d pinned", _pinnedCount.load());
+
     ImGui::End();
 }
 
+void GUI::plotRegionStatistics() {
+    std::lock_guard lock(_regionStatisticsMutex);
+    if (_regionStatistics.empty()) {
+        ImGui::Text("Drag with the right mouse button to get the statistics of a region.");
+        return;
+    }
+
+    const auto [minX, minY, maxX, maxY] = _regionBounds;
+    ImGui::Text(std::format("Region from ({}, {}) to ({}, {}): mean, standard deviation and range", minX, minY, maxX, maxY).c_str());
+
+    // ImGui has no plot with bands, so we draw our own the size of the other plots
+    const auto origin = ImGui::GetCursorScreenPos();
+    ImGui::Dummy(ImVec2{ PLOT_SIZE_X, PLOT_SIZE_Y });
+    const auto drawList = ImGui::GetWindowDrawList();
+    drawList->AddRectFilled(
+        origin, ImVec2{ origin.x + PLOT_SIZE_X, origin.y + PLOT_SIZE_Y }, ImGui::GetColorU32(ImGuiCol_FrameBg));
+
+    const auto lastBand = std::max(static_cast<int>(_regionStatistics.size()) - 1, 1);
+    const auto getPoint = [&](const int band, const float value) {
+        return ImVec2{
+            origin.x + PLOT_SIZE_X * static_cast<float>(band) / static_cast<float>(lastBand),
+            origin.y + PLOT_SIZE_Y * (1.0f - std::clamp(value, 0.0f, 1.0f)) };
+    };
+
+    // Each band segment is a trapezoid, convex as its top never crosses its bottom
+    const auto plotColor = ImGui::GetColorU32(ImGuiCol_PlotLines);
+    const auto envelopeColor = (plotColor & ~IM_COL32_A_MASK) | IM_COL32(0, 0, 0, 48);
+    const auto deviationColor = (plotColor & ~IM_COL32_A_MASK) | IM_COL32(0, 0, 0, 96);
+    for (int b = 0; b + 1 < static_cast<int>(_regionStatistics.size()); ++b) {
+        const auto& left = _regionStatistics[b];
+        const auto& right = _regionStatistics[b + 1];
+        drawList->AddQuadFilled(
+            getPoint(b, left.maximum), getPoint(b + 1, right.maximum),
+            getPoint(b + 1, right.minimum), getPoint(b, left.minimum), envelopeColor);
+        drawList->AddQuadFilled(
+            getPoint(b, left.mean + left.deviation), getPoint(b + 1, right.mean + right.deviation),
+            getPoint(b + 1, right.mean - right.deviation), getPoint(b, left.mean - left.deviation), deviationColor);
+    }
+
+    auto means = std::vector<ImVec2>{};
+    means.reserve(_regionStatistics.size());
+    for (int b = 0; b < static_cast<int>(_regionStatistics.size()); ++b) {
+        means.push_back(getPoint(b, _regionStatistics[b].mean));
+    }
+    drawList->AddPolyline(means.data(), static_cast<int>(means.size()), plotColor, ImDrawFlags_None, 1.5f);
+}
+
 void GUI::defineIlluminantWindow() {
     // Ensure the window has a unique name and is docked correctly
     ImGui::SetNextWindowDockID(ImGui::GetID("Illuminant"), ImGuiCond_FirstUseEver);
@@ -124,6 +245,40 @@ void GUI::definePCAWindow() {
     ImGui::End();
 }
 
+void GUI::defineSimilarityWindow() {
+    ImGui::SetNextWindowDockID(ImGui::GetID("Similarity"), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Spectral angle mapper", nullptr, ImGuiWindowFlags_NoCollapse);
+    ImGui::Text("Angle threshold to the clicked pixel");
+    ImGui::SliderFloat("##SimilarityThreshold", &_similarityThresholdDegrees, 0.1f, 45.0f, "%.1f deg", ImGuiSliderFlags_Logarithmic);
+    ImGui::End();
+}
+
+void GUI::defineBandMathWindow() {
+    ImGui::SetNextWindowDockID(ImGui::GetID("BandMath"), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Band math", nullptr, ImGuiWindowFlags_NoCollapse);
+    ImGui::Text("Expression over wavelengths (R<nm>) or band numbers (B<n>)");
+
+    const auto entered = ImGui::InputText(
+        "##BandMathExpression", _bandMathExpression.data(), _bandMathExpression.size(), ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::SameLine();
+    if (ImGui::Button("Apply") || entered) {
+        std::lock_guard lock(_bandMathMutex);
+        _submittedBandMathExpression = std::string{ _bandMathExpression.data() };
+    }
+
+    ImGui::DragFloatRange2("Range", &_bandMathRange[0], &_bandMathRange[1], 0.01f);
+    if (ImGui::Button("Export")) {
+        _bandMathExportRequested = true;
+    }
+
+    std::lock_guard lock(_bandMathMutex);
+    if (!_bandMathStatus.empty()) {
+        ImGui::TextWrapped("%s", _bandMathStatus.c_str());
+    }
+
+    ImGui::End();
+}
+
 void GUI::updateCurrentImageCoordinates(const int x, const int y) {
     std::lock_guard lock(_imgCoordinatesMutex);
     _currentImgX = x;
@@ -146,6 +301,29 @@ void GUI::updateSpectralCurve(std::vector<float>&& values) noexcept {
     _spectralCurve = std::move(values);
 }
 
+void GUI::updateSpectralCurve(
+    std::vector<float>&& values,
+    const int imgX,
+    const int imgY,
+    const std::chrono::steady_clock::time_point requestTime
+) noexcept {
+    // Coordinates change together with the curve, so that the curve is never labeled with another pixel
+    std::scoped_lock lock(_spectralCurveMutex, _imgCoordinatesMutex);
+    _spectralCurve = std::move(values);
+    _spectralCurveRequestTime = requestTime;
+    _currentImgX = imgX;
+    _currentImgY = imgY;
+}
+
+void GUI::updateRegionStatistics(
+    const int minX, const int minY, const int maxX, const int maxY,
+    std::vector<BandStatistics>&& statistics
+) {
+    std::lock_guard lock(_regionStatisticsMutex);
+    _regionBounds = { minX, minY, maxX, maxY };
+    _regionStatistics = std::move(statistics);
+}
+
 spd::Illuminant GUI::getCurrentIlluminant() const {
     return static_cast<spd::Illuminant>(_currentIlluminant);
 }
@@ -157,3 +335,65 @@ spd::Sensor GUI::getCurrentSensor() const {
 int GUI::getCurrentComponentCount() const {
     return _currentComponentCount;
 }
+
+float GUI::getSimilarityThreshold() const {
+    return _similarityThresholdDegrees * std::numbers::pi_v<float> / 180.0f;
+}
+
+std::optional<std::string> GUI::consumeBandMathExpression() {
+    std::lock_guard lock(_bandMathMutex);
+    return std::exchange(_submittedBandMathExpression, std::nullopt);
+}
+
+bool GUI::consumeBandMathExportRequest() {
+    return _bandMathExportRequested.exchange(false);
+}
+
+std::pair<float, float> GUI::getBandMathRange() const {
+    return { _bandMathRange[0], _bandMathRange[1] };
+}
+
+void GUI::updateBandMathStatus(std::string status) {
+    std::lock_guard lock(_bandMathMutex);
+    _bandMathStatus = std::move(status);
+}
+
+bool GUI::consumePinRequest() {
+    return _pinRequested.exchange(false);
+}
+
+bool GUI::consumeClearPinsRequest() {
+    return _clearPinsRequested.exchange(false);
+}
+
+void GUI::updatePinnedCount(const int count) {
+    _pinnedCount = count;
+}
+
+bool GUI::isRenderOnDemand() const {
+    return _renderOnDemand;
+}
+
+uint32_t GUI::getFramesInFlight() const {
+    return static_cast<uint32_t>(_framesInFlight);
+}
+
+SwapChain::PresentMode GUI::getPresentMode() const {
+    return static_cast<SwapChain::PresentMode>(_presentMode);
+}
+
+void GUI::updateInputLatency(const float milliseconds) {
+    _inputLatency = milliseconds;
+}
+
+void GUI::updateMemoryStatistics(const MemoryStatistics& statistics) {
+    std::lock_guard lock(_memoryStatisticsMutex);
+    _memoryStatistics = statistics;
+}
+
+void GUI::updateGpuTimings(const Renderer::GpuTimings& timings) {
+    std::lock_guard lock(_gpuTimingsMutex);
+    _gpuTimings = timings;
+    _gpuFrameHistory[_gpuFrameHistoryOffset] = timings.frame;
+    _gpuFrameHistoryOffset = (_gpuFrameHistoryOffset + 1) % GPU_HISTORY_SIZE;
+}
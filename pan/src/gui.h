@@ -1,10 +1,19 @@
 #pragma once
 
+#include "pan.h"
 #include "spd.h"
 
+#include <engine/MemoryStatistics.h>
 #include <engine/Overlay.h>
+#include <engine/Renderer.h>
+#include <engine/SwapChain.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <mutex>
+#include <optional>
+#include <string>
 
 
 class GUI final : public Overlay {
@@ -17,17 +26,50 @@ public:
     void updateSpectralCurve(const std::vector<float>& values);
     void updateSpectralCurve(std::vector<float>&& values) noexcept;
 
+    // The curve of the pixel probed at the given time, how long it took to show is reported in the metrics window
+    void updateSpectralCurve(
+        std::vector<float>&& values, int imgX, int imgY, std::chrono::steady_clock::time_point requestTime) noexcept;
+
+    // Statistics of a region given by its image coordinates, reduced from the resident cube
+    void updateRegionStatistics(int minX, int minY, int maxX, int maxY, std::vector<BandStatistics>&& statistics);
+
     spd::Illuminant getCurrentIlluminant() const;
     spd::Sensor getCurrentSensor() const;
 
     int getCurrentComponentCount() const;
 
+    // Each returns the expression submitted, or whether an export has been requested, since the last call
+    std::optional<std::string> consumeBandMathExpression();
+    bool consumeBandMathExportRequest();
+    std::pair<float, float> getBandMathRange() const;
+    void updateBandMathStatus(std::string status);
+
+    // In radians, pixels whose spectral angle to the reference exceeds it are left out of the similarity map
+    float getSimilarityThreshold() const;
+
+    // Each returns whether the corresponding button has been pressed since the last call
+    bool consumePinRequest();
+    bool consumeClearPinsRequest();
+    void updatePinnedCount(int count);
+
+    // Latency and power modes selected in the performance metrics window
+    bool isRenderOnDemand() const;
+    uint32_t getFramesInFlight() const;
+    SwapChain::PresentMode getPresentMode() const;
+    void updateInputLatency(float milliseconds);
+
+    void updateGpuTimings(const Renderer::GpuTimings& timings);
+    void updateMemoryStatistics(const MemoryStatistics& statistics);
+
 private:
     void definePerformanceMetricWindow();
     void defineSpectralCurveWindow();
+    void plotRegionStatistics();
     void defineIlluminantWindow();
     void defineSensorWindow();
     void definePCAWindow();
+    void defineSimilarityWindow();
+    void defineBandMathWindow();
 
     std::mutex _imgCoordinatesMutex{};
     int _currentImgX{ -1 };
@@ -35,6 +77,12 @@ private:
 
     std::mutex _spectralCurveMutex{};
     std::vector<float> _spectralCurve{};
+    std::optional<std::chrono::steady_clock::time_point> _spectralCurveRequestTime{};
+    float _probeLatency{ 0.0f };
+
+    std::mutex _regionStatisticsMutex{};
+    std::array<int, 4> _regionBounds{};
+    std::vector<BandStatistics> _regionStatistics{};
 
     int _currentIlluminant{ static_cast<int>(spd::Illuminant::D65) };
     int _currentSensor{ static_cast<int>(spd::Sensor::CIE1931) };
@@ -43,4 +91,34 @@ private:
     static constexpr auto PLOT_SIZE_Y = 200;
 
     int _currentComponentCount{ 3 };
+
+    float _similarityThresholdDegrees{ 10.0f };
+
+    // The default expression is a red edge index, NDVI itself needs near infrared bands beyond the resident range
+    std::array<char, 256> _bandMathExpression{ "(R800 - R670) / (R800 + R670)" };
+    std::mutex _bandMathMutex{};
+    std::optional<std::string> _submittedBandMathExpression{ _bandMathExpression.data() };
+    std::string _bandMathStatus{};
+    std::array<float, 2> _bandMathRange{ -1.0f, 1.0f };
+    std::atomic_bool _bandMathExportRequested{ false };
+
+    std::atomic_bool _pinRequested{ false };
+    std::atomic_bool _clearPinsRequested{ false };
+    std::atomic_int _pinnedCount{ 0 };
+
+    bool _renderOnDemand{ true };
+    int _framesInFlight{ Renderer::getDefaultFramesInFlight() };
+    int _presentMode{ static_cast<int>(SwapChain::PresentMode::Mailbox) };
+    std::atomic<float> _inputLatency{ 0.0f };
+
+    std::mutex _gpuTimingsMutex{};
+    Renderer::GpuTimings _gpuTimings{};
+
+    // A short history of GPU frame times for plotting
+    static constexpr auto GPU_HISTORY_SIZE = 120;
+    std::array<float, GPU_HISTORY_SIZE> _gpuFrameHistory{};
+    int _gpuFrameHistoryOffset{ 0 };
+
+    std::mutex _memoryStatisticsMutex{};
+    MemoryStatistics _memoryStatistics{};
 };
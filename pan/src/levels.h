@@ -0,0 +1,49 @@
+#pragma once
+
+#include <engine/Renderer.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+
+namespace levels {
+    // Must match the bin count of the histogram and levels compute shaders
+    static constexpr auto BIN_COUNT = 256;
+
+    // Everything below the low percentile maps to black, everything above the high percentile to white
+    static constexpr auto LOW_PERCENTILE = 0.02f;
+    static constexpr auto HIGH_PERCENTILE = 0.98f;
+
+    // Levels are written to a ring of buffers, for the same reason as the spectral angles, see sam::ANGLE_BUFFER_COUNT
+    static constexpr auto LEVELS_BUFFER_COUNT = Renderer::getMaxFramesInFlight() + 1;
+
+    // Push constants of the histogram compute shader
+    struct Binning {
+        alignas(8) uint64_t cubeAddress;
+        alignas(8) uint64_t bandByteStride;
+        alignas(8) uint64_t weightAddress;
+        alignas(8) uint64_t histogramAddress;
+        alignas(4) int rasterX;
+        alignas(4) int rasterY;
+    };
+
+    // Push constants of the levels compute shader
+    struct Percentiles {
+        alignas(8) uint64_t histogramAddress;
+        alignas(8) uint64_t levelsAddress;
+        alignas(4) uint32_t pixelCount;
+        alignas(4) float lowPercentile{ LOW_PERCENTILE };
+        alignas(4) float highPercentile{ HIGH_PERCENTILE };
+    };
+
+    // What the levels compute shader writes: the sRGB values mapped to black and to white, per channel
+    struct Levels {
+        glm::vec4 low;
+        glm::vec4 high;
+    };
+
+    struct Stretch {
+        alignas(8) uint64_t levelsAddress{ 0 };
+    };
+}
@@ -1,7 +1,13 @@
 #include "CLI11.hpp"
+#include "bandmath.h"
+#include "cache.h"
+#include "downscale.h"
 #include "pan.h"
 #include "pca.h"
+#include "probe.h"
 #include "gui.h"
+#include "levels.h"
+#include "sam.h"
 #include "spd.h"
 #include "stb.h"
 
@@ -9,9 +15,12 @@
 #include <engine/Engine.h>
 #include <engine/VertexBuffer.h>
 #include <engine/IndexBuffer.h>
+#include <engine/InstanceBuffer.h>
 #include <engine/UniformBuffer.h>
 #include <engine/Texture.h>
+#include <engine/Trace.h>
 #include <engine/GraphicShader.h>
+#include <engine/ComputeShader.h>
 #include <engine/Drawable.h>
 #include <engine/View.h>
 
@@ -23,8 +32,15 @@
 #include <plog/Appenders/ColorConsoleAppender.h>
 #include <plog/Formatters/TxtFormatter.h>
 
+#include <format>
+#include <map>
+#include <optional>
 #include <ranges>
 #include <filesystem>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <engine/StorageBuffer.h>
 
 
@@ -33,16 +49,23 @@ int main(const int argc, char* argv[]) {
     auto pan = CLI::App{};
 
     auto filePath = std::string{};
-    auto downscaleFactor = 4;
+    auto downscaleFactor = 4.0;
+    auto autoDownscale = true;
+    auto useCache = true;
+    auto tracePath = std::string{};
 
-    const auto multipleOf2 = [](const std::string& str) {
-        const int value = std::stoi(str);
-        return value % 2 != 0 ? "Downscaling factor must be a multiple of 2" : std::string{};
+    const auto atLeast1 = [](const std::string& str) {
+        return std::stod(str) < 1.0 ? "Downscaling factor must be at least 1" : std::string{};
     };
     pan.add_option("input", filePath, "A supported image file: ENVI")->required()->check(CLI::ExistingFile);
-    pan.add_option("--downscale", downscaleFactor, "Downscaling factor in both axes")
+    pan.add_option("--downscale", downscaleFactor, "Downscaling factor in both axes, integer or fractional")
         ->check(CLI::PositiveNumber)
-        ->check(multipleOf2);
+        ->check(atLeast1);
+    pan.add_flag("!--no-auto-downscale", autoDownscale,
+        "Refuse to load an image that doesn't fit in GPU memory instead of downscaling it further");
+    pan.add_flag("!--no-cache", useCache,
+        "Always read the dataset from its source instead of the preprocessed cube cached from previous runs");
+    pan.add_option("--trace", tracePath, "Record a Chrome/Perfetto trace of frame phases and ingest stages to this file");
 
     try {
         CLI11_PARSE(pan, argc, argv);
@@ -58,6 +81,10 @@ int main(const int argc, char* argv[]) {
     init(plog::debug, &appender);
 #endif
 
+    if (!tracePath.empty()) {
+        Trace::start(tracePath);
+    }
+
     GDALAllRegister();
     const auto pathAbsolute = std::filesystem::absolute(filePath);
 
@@ -75,15 +102,25 @@ int main(const int argc, char* argv[]) {
     PLOGD << "Image cols: " << imgXSize;
     PLOGD << "Band count: " << dataset->GetRasterCount();
 
-    const auto bufferXSize = imgXSize / downscaleFactor;
-    const auto bufferYSize = imgYSize / downscaleFactor;
+    auto bufferXSize = static_cast<int>(imgXSize / downscaleFactor);
+    auto bufferYSize = static_cast<int>(imgYSize / downscaleFactor);
+    if (bufferXSize == 0 || bufferYSize == 0) {
+        PLOGE << "Downscaling " << imgXSize << " x " << imgYSize << " by a factor of " << downscaleFactor
+              << " leaves no pixel";
+        GDALClose(dataset);
+        return 1;
+    }
     PLOGD << "Spatial resolution: " << bufferXSize << " x " << bufferYSize;
 
-    // Get center wavelengths of each band
+    // Get center wavelengths and widths of each band
+    auto metadataScope = std::optional<Trace::Scope>{ std::in_place, "Parse metadata", "ingest" };
     const auto metadata = dataset->GetMetadata();
-    const auto centerWavelengths = parseMetadata(metadata, CSLCount(metadata))
+    const auto bandCenters = parseMetadata(metadata, CSLCount(metadata));
+    const auto bandWidths = parseFullWidths(dataset, bandCenters);
+    const auto centerWavelengths = bandCenters
         | std::views::transform([](const auto it) { return static_cast<uint32_t>(it); })
         | std::ranges::to<std::vector>();
+    metadataScope.reset();
 
     static constexpr auto MIN_WAVELENGTH = 360;
     static constexpr auto MAX_WAVELENGTH = 830;
@@ -99,18 +136,55 @@ int main(const int argc, char* argv[]) {
         GDALClose(dataset);
         return 1;
     }
+    if (bandEnd - bandBegin > MAX_RESIDENT_BANDS) {
+        PLOGE << "The dataset has " << bandEnd - bandBegin << " bands in the visible range, at most "
+              << MAX_RESIDENT_BANDS << " are supported";
+        GDALClose(dataset);
+        return 1;
+    }
     PLOGD << "Spectral resolution: " << bandEnd - bandBegin;
 
     // Create a window context
     const auto context = Context::create("pan");
 
-    // Create an engine
-    const auto engine = Engine::create(context->getSurface());
+    // Create an engine, pipelines compiled in previous runs are loaded from the cache directory
+    static constexpr auto CACHE_DIRECTORY = "cache";
+    const auto engine = Engine::create(context->getSurface(), {}, CACHE_DIRECTORY);
 
     // Create a swap chain and a renderer
     const auto swapChain = engine->createSwapChain();
     const auto renderer = engine->createRenderer();
 
+    // Make sure the raster cube, the PCA vectors, the projected scores, the spectral angle and the band math buffers fit
+    // in GPU memory before uploading any band. We keep some headroom for the overlay, staging buffers and whatever else
+    // the driver may need
+    static constexpr auto BUDGET_HEADROOM = 0.9;
+    const auto bandCount = static_cast<uint64_t>(bandEnd - bandBegin);
+    const auto getRequiredMemory = [&] {
+        const auto pixelCount = static_cast<uint64_t>(bufferXSize) * bufferYSize;
+        return sizeof(float) * (bandCount * (pixelCount + pca::MAX_COMPONENTS + 1) + pixelCount * pca::MAX_COMPONENTS +
+            pixelCount * (1 + sam::ANGLE_BUFFER_COUNT + bandmath::RESULT_BUFFER_COUNT));
+    };
+    const auto availableMemory = static_cast<uint64_t>(getAvailableDeviceMemory(engine->getMemoryStatistics()) * BUDGET_HEADROOM);
+    while (getRequiredMemory() > availableMemory) {
+        PLOGW << "Loading at " << bufferXSize << " x " << bufferYSize << " requires " << getRequiredMemory() / (1024 * 1024)
+              << " MiB of GPU memory, only " << availableMemory / (1024 * 1024) << " MiB is available";
+        if (!autoDownscale || imgXSize / (downscaleFactor * 2) < 1 || imgYSize / (downscaleFactor * 2) < 1) {
+            PLOGE << "The dataset does not fit in GPU memory, try a larger downscaling factor";
+            engine->destroyRenderer(renderer);
+            engine->destroySwapChain(swapChain);
+            engine->destroy();
+            context->destroy();
+            GDALClose(dataset);
+            Trace::stop();
+            return 1;
+        }
+        downscaleFactor *= 2;
+        bufferXSize = static_cast<int>(imgXSize / downscaleFactor);
+        bufferYSize = static_cast<int>(imgYSize / downscaleFactor);
+        PLOGI << "Downscaling by a factor of " << downscaleFactor << " to " << bufferXSize << " x " << bufferYSize;
+    }
+
     // Create a quad
     static constexpr auto OFFSET_X = -1.0f;
     const auto imgRatio = static_cast<float>(imgXSize) / static_cast<float>(imgYSize);
@@ -154,89 +228,169 @@ int main(const int argc, char* argv[]) {
         .build(*engine);
     indexBuffer->setData(indices.data(), *engine);
 
-    const auto illuminant = UniformBuffer::Builder()
-        .dataByteSize(sizeof(Illuminant))
-        .build(*engine);
-
-    const auto sensor = UniformBuffer::Builder()
-        .dataByteSize(sizeof(Sensor))
+    const auto tristimulus = UniformBuffer::Builder()
+        .dataByteSize(sizeof(Tristimulus))
         .build(*engine);
 
     const auto dimension = UniformBuffer::Builder()
         .dataByteSize(sizeof(Dimension))
         .build(*engine);
-    const auto dimensionObject = Dimension{ bufferXSize, bufferYSize, bandEnd - bandBegin };
-    dimension->setData(&dimensionObject);
 
-    auto illuminantObject = Illuminant{};
-    auto sensorObject = Sensor{};
-    int index = 0;
-    for (auto b = bandBegin; b < bandEnd; ++b) {
-        const auto wavelength = centerWavelengths[b];
-        illuminantObject.data[index] = getIlluminantValueAt(wavelength, spd::Illuminant::D65);
-        sensorObject.x[index] = getSensorXValueAt(wavelength, spd::Sensor::CIE1931);
-        sensorObject.y[index] = getSensorYValueAt(wavelength, spd::Sensor::CIE1931);
-        sensorObject.z[index] = getSensorZValueAt(wavelength, spd::Sensor::CIE1931);
-        index += 4;
+    // Band responses are integrated against each illuminant and sensor the first time the pair gets selected, the
+    // band grid is fixed for the whole run
+    const auto residentCenters = std::span{ bandCenters }.subspan(bandBegin, bandEnd - bandBegin);
+    const auto residentWidths = std::span{ bandWidths }.subspan(bandBegin, bandEnd - bandBegin);
+    auto tristimulusCache = std::map<std::pair<spd::Illuminant, spd::Sensor>, Tristimulus>{};
+    const auto getTristimulus = [&](const spd::Illuminant illuminant, const spd::Sensor sensor) -> const Tristimulus& {
+        const auto [it, inserted] = tristimulusCache.try_emplace(std::pair{ illuminant, sensor });
+        if (inserted) {
+            const auto weightScope = Trace::Scope{ "Integrate band responses" };
+            std::ranges::copy(
+                spd::computeTristimulusWeights(residentCenters, residentWidths, illuminant, sensor),
+                it->second.weights.begin());
+        }
+        return it->second;
+    };
+    tristimulus->setData(&getTristimulus(spd::Illuminant::D65, spd::Sensor::CIE1931));
+
+    // The whole cube goes into a single buffer, band after band, which shaders read through its device address. It
+    // takes no descriptor, isn't limited by the maximum storage buffer range, and can be streamed in one band at a time.
+    // Rendering and compute jobs read it at the same time
+    const auto bandByteSize = sizeof(float) * bufferXSize * bufferYSize;
+    const auto cube = StorageBuffer::Builder()
+        .byteSize(bandByteSize * bandCount)
+        .deviceAddress()
+        .concurrent()
+        .build(*engine);
+
+    // Datasets opened again with the same parameters skip decoding and resampling, their preprocessed cube is
+    // decompressed from the cache directory across all threads, then uploaded. Changing the dataset or the parameters
+    // rebuilds it, as does editing any of its files, like the header of an ENVI dataset
+    auto sourceFiles = std::vector<std::filesystem::path>{};
+    if (const auto fileList = dataset->GetFileList(); fileList != nullptr) {
+        for (auto i = 0; fileList[i] != nullptr; ++i) {
+            sourceFiles.emplace_back(fileList[i]);
+        }
+        CSLDestroy(fileList);
     }
-    illuminant->setData(&illuminantObject);
-    sensor->setData(&sensorObject);
+    if (std::ranges::find(sourceFiles, pathAbsolute) == sourceFiles.end()) {
+        sourceFiles.push_back(pathAbsolute);
+    }
+    const auto cacheKey = cache::makeKey(sourceFiles, bufferXSize, bufferYSize, bandBegin, bandEnd);
+    const auto cubePath = cache::getCubePath(CACHE_DIRECTORY, pathAbsolute);
+    auto sceneStatistics = std::vector<BandStatistics>{};
+    auto cachedCube = std::optional<cache::Cube>{};
+    if (useCache) {
+        const auto readScope = Trace::Scope{ "Read cached cube", "ingest" };
+        cachedCube = cache::readCube(cubePath, cacheKey, residentCenters);
+    }
+    if (cachedCube) {
+        PLOGI << "Loading the preprocessed cube from " << cubePath.string();
+        const auto pixelCount = static_cast<std::size_t>(bufferXSize) * bufferYSize;
+        for (auto bandIndex = bandBegin; bandIndex < bandEnd; ++bandIndex) {
+            const auto uploadScope = Trace::Scope{ "Upload cached band", "ingest" };
+            const auto band = cachedCube->data.data() + pixelCount * (bandIndex - bandBegin);
+            cube->setData(band, bandByteSize * (bandIndex - bandBegin), bandByteSize, *engine);
+        }
+        sceneStatistics = std::move(cachedCube->statistics);
+        cachedCube.reset();
+    } else {
+        auto cubeWriter = useCache
+            ? std::optional<cache::CubeWriter>{ std::in_place, cubePath, cacheKey, residentCenters }
+            : std::nullopt;
+        // GDAL resamples to the nearest neighbour when reading into a smaller buffer, which aliases. Bands are read
+        // at full resolution instead and area averaged down to the buffer size
+        const auto downscaled = bufferXSize != imgXSize || bufferYSize != imgYSize;
+        const auto areaAverage = downscaled
+            ? std::optional<downscale::AreaAverage>{ std::in_place, imgXSize, imgYSize, bufferXSize, bufferYSize }
+            : std::nullopt;
+        auto sourceValues = std::vector<float>(downscaled ? static_cast<std::size_t>(imgXSize) * imgYSize : 0);
+        auto values = std::vector<float>(static_cast<std::size_t>(bufferXSize) * bufferYSize);
+        for (auto bandIndex = bandBegin; bandIndex < bandEnd; ++bandIndex) {
+            const auto bandScope = Trace::Scope{ "Load band", "ingest" };
+            {
+                // GDAL converts to float as part of the read
+                const auto readScope = Trace::Scope{ "Read and convert band", "ingest" };
+                const auto band = dataset->GetRasterBand(bandIndex + 1);
+                const auto target = downscaled ? sourceValues.data() : values.data();
+                const auto err = band->RasterIO(
+                    GF_Read, 0, 0, imgXSize, imgYSize, target, imgXSize, imgYSize, GDT_Float32, 0, 0);
 
-    const auto rasters = std::views::iota(bandBegin, bandEnd)
-        | std::views::transform([&](const int bandIndex) {
-            const auto raster = StorageBuffer::Builder()
-                .byteSize(sizeof(float) * bufferXSize * bufferYSize)
-                .build(*engine);
+                // A band that failed to read is shown as is for this run, but never cached for the next ones
+                if (err != CE_None && cubeWriter) {
+                    cubeWriter->fail(std::format("band {} could not be read", bandIndex + 1).c_str());
+                }
+            }
+            if (areaAverage) {
+                const auto downscaleScope = Trace::Scope{ "Downscale band", "ingest" };
+                areaAverage->apply(sourceValues, values);
+            }
 
-            auto values = std::vector<float>(imgXSize * imgYSize);
-            const auto band = dataset->GetRasterBand(bandIndex + 1);
-            [[maybe_unused]] const auto err = band->RasterIO(
-                GF_Read, 0, 0, imgXSize, imgYSize, values.data(), bufferXSize, bufferYSize, GDT_Float32, 0, 0);
+            const auto uploadScope = Trace::Scope{ "Upload band", "ingest" };
+            cube->setData(values.data(), bandByteSize * (bandIndex - bandBegin), bandByteSize, *engine);
+            if (cubeWriter) {
+                cubeWriter->append(values);
+            }
+        }
+        if (cubeWriter) {
+            cubeWriter->commit();
+        }
+    }
 
-            raster->setData(values.data(), *engine);
+    const auto dimensionObject = Dimension{
+        bufferXSize, bufferYSize, bandEnd - bandBegin, cube->getDeviceAddress(), bandByteSize };
+    dimension->setData(&dimensionObject);
 
-            return raster; })
-        | std::ranges::to<std::vector>();
+    // Storage buffer arrays only get as many elements written as there are vectors, and single elements can be
+    // swapped without recording the frame again
+    constexpr auto SPARSE_ARRAY =
+        vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind;
 
     const auto shader = GraphicShader::Builder()
         .vertexShader("shaders/shader.vert")
         .fragmentShader("shaders/xyz.frag")
-        .descriptorCount(4)
+        .descriptorCount(3)
         .descriptor(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
         .descriptor(1, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
         .descriptor(2, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
-        .descriptor(3, vk::DescriptorType::eStorageBuffer, 128, vk::ShaderStageFlagBits::eFragment)
+        .specializationConstant(0, bandEnd - bandBegin)
         .build(*engine, *swapChain);
 
+    const auto stretch = UniformBuffer::Builder()
+        .dataByteSize(sizeof(levels::Stretch))
+        .build(*engine);
+    auto stretchObject = levels::Stretch{};
+
     const auto shaderInstance = shader->createInstance(*engine);
-    shaderInstance->setDescriptor(0, illuminant, *engine);
-    shaderInstance->setDescriptor(1, sensor, *engine);
-    shaderInstance->setDescriptor(2, dimension, *engine);
-    shaderInstance->setDescriptor(3, rasters, *engine);
+    shaderInstance->setDescriptor(0, tristimulus, *engine);
+    shaderInstance->setDescriptor(1, dimension, *engine);
+    shaderInstance->setDescriptor(2, stretch, *engine);
 
     const auto xyzQuad = Drawable::Builder(1)
         .geometry(0, Drawable::Topology::TriangleStrip, vertexBuffer, indexBuffer, indices.size())
         .material(0, shaderInstance)
         .build(*engine);
     xyzQuad->setTransform(translate(glm::mat4{ 1.0f }, { OFFSET_X, 0.0f, 0.0f }));
+    xyzQuad->setName("XYZ quad");
 
-    const auto pcaShader = GraphicShader::Builder()
+    // The band count is fixed for the whole run, the component count is specialized per variant below
+    auto pcaShaderBuilder = GraphicShader::Builder()
         .vertexShader("shaders/shader.vert")
         .fragmentShader("shaders/pca.frag")
-        .descriptorCount(6)
+        .descriptorCount(4)
         .descriptor(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
         .descriptor(1, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
         .descriptor(2, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
-        .descriptor(3, vk::DescriptorType::eStorageBuffer, 128, vk::ShaderStageFlagBits::eFragment)
-        .descriptor(4, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
-        .descriptor(5, vk::DescriptorType::eStorageBuffer, 33, vk::ShaderStageFlagBits::eFragment)
-        .build(*engine, *swapChain);
+        .descriptor(3, vk::DescriptorType::eStorageBuffer, 33, vk::ShaderStageFlagBits::eFragment, SPARSE_ARRAY)
+        .specializationConstant(0, bandEnd - bandBegin);
 
     // Read eigenvectors and the mean vector, convert them to storage buffers
     const auto vectors = pca::readVectors("assets/pca.txt", bandEnd - bandBegin)
         | std::views::transform([&](const std::vector<float>& data) {
+            const auto scope = Trace::Scope{ "Upload PCA vector", "ingest" };
             const auto vector = StorageBuffer::Builder()
                 .byteSize(sizeof(float) * data.size())
+                .concurrent()
                 .build(*engine);
             vector->setData(data.data(), *engine);
             return vector; })
@@ -248,19 +402,264 @@ int main(const int argc, char* argv[]) {
     auto pcaObject = pca::PCA{ 3, pca::MAX_COMPONENTS };
     pca->setData(&pcaObject);
 
-    const auto pcaShaderInstance = pcaShader->createInstance(*engine);
-    pcaShaderInstance->setDescriptor(0, illuminant, *engine);
-    pcaShaderInstance->setDescriptor(1, sensor, *engine);
-    pcaShaderInstance->setDescriptor(2, dimension, *engine);
-    pcaShaderInstance->setDescriptor(3, rasters, *engine);
-    pcaShaderInstance->setDescriptor(4, pca, *engine);
-    pcaShaderInstance->setDescriptor(5, vectors, *engine);
+    // Project every pixel onto all principal components once, on the async compute queue if the device has one, so
+    // that the PCA quad only has to read the scores. Until they're handed over, it keeps projecting each fragment
+    const auto computeQueue = engine->createComputeQueue();
+    const auto scores = StorageBuffer::Builder()
+        .byteSize(sizeof(float) * bufferXSize * bufferYSize * pca::MAX_COMPONENTS)
+        .deviceAddress()
+        .build(*engine);
+
+    const auto projectionShader = ComputeShader::Builder()
+        .computeShader("shaders/pca.comp")
+        .descriptorCount(1)
+        .descriptor(0, vk::DescriptorType::eStorageBuffer, 33, vk::ShaderStageFlagBits::eCompute)
+        .specializationConstant(0, bandEnd - bandBegin)
+        .pushConstantSize(sizeof(pca::Projection))
+        .build(*engine);
+    const auto projectionInstance = projectionShader->createInstance(*engine);
+    projectionInstance->setDescriptor(0, vectors, *engine);
+
+    static constexpr auto PROJECTION_GROUP_SIZE = 64;  // local_size_x of pca.comp
+    const auto projection = pca::Projection{
+        cube->getDeviceAddress(), bandByteSize, scores->getDeviceAddress(), bufferXSize, bufferYSize };
+    const auto projectionTicket = computeQueue->dispatch(
+        projectionInstance,
+        static_cast<uint32_t>((bufferXSize + PROJECTION_GROUP_SIZE - 1) / PROJECTION_GROUP_SIZE),
+        static_cast<uint32_t>(bufferYSize), 1,
+        &projection, sizeof(projection), { scores });
+    PLOGI << "Projecting PCA scores on the " << (computeQueue->isAsync() ? "async compute" : "graphics") << " queue";
+
+    // Wake up the render loop once the scores are ready, it may be sleeping while rendering on demand
+    auto projectionWatcher = std::jthread{ [&computeQueue, projectionTicket] {
+        computeQueue->wait(projectionTicket);
+        Context::requestRedraw();
+    } };
+
+    // A shader specialized on some constants, together with its single instance
+    struct ShaderVariant {
+        Shader* shader;
+        ShaderInstance* instance;
+    };
+
+    // The spectral angle mapper compares every pixel to a clicked one. Inverse norms of all pixels are computed once,
+    // so that each query only has to take dot products with the reference
+    const auto pixelCount = static_cast<std::size_t>(bufferXSize) * bufferYSize;
+    const auto norms = StorageBuffer::Builder()
+        .byteSize(sizeof(float) * pixelCount)
+        .deviceAddress()
+        .build(*engine);
+    const auto angles = std::views::iota(0, sam::ANGLE_BUFFER_COUNT)
+        | std::views::transform([&](auto) {
+            return StorageBuffer::Builder()
+                .byteSize(sizeof(float) * pixelCount)
+                .deviceAddress()
+                .build(*engine); })
+        | std::ranges::to<std::vector>();
+
+    const auto normShader = ComputeShader::Builder()
+        .computeShader("shaders/norm.comp")
+        .specializationConstant(0, bandEnd - bandBegin)
+        .pushConstantSize(sizeof(sam::Normalization))
+        .build(*engine);
+    const auto normInstance = normShader->createInstance(*engine);
+
+    const auto angleShader = ComputeShader::Builder()
+        .computeShader("shaders/sam.comp")
+        .specializationConstant(0, bandEnd - bandBegin)
+        .pushConstantSize(sizeof(sam::Query))
+        .build(*engine);
+    const auto angleInstance = angleShader->createInstance(*engine);
+
+    static constexpr auto PIXEL_GROUP_SIZE = 64;  // local_size_x of norm.comp, sam.comp and bandmath.comp
+    const auto pixelGroupCountX = static_cast<uint32_t>((bufferXSize + PIXEL_GROUP_SIZE - 1) / PIXEL_GROUP_SIZE);
+    const auto normalization = sam::Normalization{
+        cube->getDeviceAddress(), bandByteSize, norms->getDeviceAddress(), bufferXSize, bufferYSize };
+    computeQueue->dispatch(
+        normInstance, pixelGroupCountX, static_cast<uint32_t>(bufferYSize), 1, &normalization, sizeof(normalization));
+
+    // Band math expressions are compiled into postfix programs specialized into kernels of their own. Kernels are
+    // cached by program, the pipeline cache keeps them across runs too
+    const auto residentWavelengths = std::span{ centerWavelengths }.subspan(bandBegin, bandEnd - bandBegin);
+    const auto bandMathResults = std::views::iota(0, bandmath::RESULT_BUFFER_COUNT)
+        | std::views::transform([&](auto) {
+            return StorageBuffer::Builder()
+                .byteSize(sizeof(float) * pixelCount)
+                .deviceAddress()
+                .build(*engine); })
+        | std::ranges::to<std::vector>();
+
+    const auto bandMathBuilder = ComputeShader::Builder()
+        .computeShader("shaders/bandmath.comp")
+        .pushConstantSize(sizeof(bandmath::Evaluation));
+    auto bandMathKernels = std::unordered_map<std::string, ShaderVariant>{};
+    const auto getBandMathKernel = [&](const bandmath::Program& program) {
+        const auto key = program.getKey();
+        if (const auto it = bandMathKernels.find(key); it != bandMathKernels.end()) {
+            return it->second.instance;
+        }
+
+        const auto kernelScope = Trace::Scope{ "Build band math kernel" };
+        auto builder = ComputeShader::Builder(bandMathBuilder);
+        builder.specializationConstant(0, static_cast<int>(program.instructions.size()));
+        for (uint32_t i = 0; i < program.instructions.size(); ++i) {
+            builder.specializationConstant(1 + i, program.instructions[i]);
+        }
+        for (uint32_t i = 0; i < program.constants.size(); ++i) {
+            builder.specializationConstant(1 + bandmath::MAX_INSTRUCTIONS + i, program.constants[i]);
+        }
+        const auto kernel = builder.build(*engine);
+        const auto instance = kernel->createInstance(*engine);
+
+        bandMathKernels.emplace(key, ShaderVariant{ kernel, instance });
+        return instance;
+    };
+
+    // The XYZ quad is contrast stretched to percentiles of per-channel histograms of its own colors. Both are computed
+    // on the compute queue and the levels stay on the GPU, the host only uploads the per-band tristimulus weights, and
+    // only when the illuminant or the sensor changes
+    const auto tristimulusWeights = StorageBuffer::Builder()
+        .byteSize(sizeof(glm::vec4) * bandCount)
+        .deviceAddress()
+        .concurrent()
+        .build(*engine);
+    const auto histogram = StorageBuffer::Builder()
+        .byteSize(sizeof(uint32_t) * 3 * levels::BIN_COUNT)
+        .deviceAddress()
+        .concurrent()
+        .build(*engine);
+    const auto emptyHistogram = std::array<uint32_t, 3 * levels::BIN_COUNT>{};
+    histogram->setData(emptyHistogram.data(), *engine);
+    const auto levelBuffers = std::views::iota(0, levels::LEVELS_BUFFER_COUNT)
+        | std::views::transform([&](auto) {
+            return StorageBuffer::Builder()
+                .byteSize(sizeof(levels::Levels))
+                .deviceAddress()
+                .build(*engine); })
+        | std::ranges::to<std::vector>();
+
+    const auto histogramShader = ComputeShader::Builder()
+        .computeShader("shaders/histogram.comp")
+        .specializationConstant(0, bandEnd - bandBegin)
+        .pushConstantSize(sizeof(levels::Binning))
+        .build(*engine);
+    const auto histogramInstance = histogramShader->createInstance(*engine);
+
+    const auto levelsShader = ComputeShader::Builder()
+        .computeShader("shaders/levels.comp")
+        .pushConstantSize(sizeof(levels::Percentiles))
+        .build(*engine);
+    const auto levelsInstance = levelsShader->createInstance(*engine);
+
+    static constexpr auto HISTOGRAM_GROUP_SIZE = 256;  // local_size_x of histogram.comp
+    const auto histogramGroupCountX =
+        static_cast<uint32_t>((bufferXSize + HISTOGRAM_GROUP_SIZE - 1) / HISTOGRAM_GROUP_SIZE);
+
+    // Statistics of a region dragged over the XYZ quad are reduced on the compute queue, all bands in one dispatch
+    using Subgroup = vk::SubgroupFeatureFlagBits;
+    const auto subgroupOperations = engine->getSubgroupOperations();
+    const auto regionSupported = (subgroupOperations & Subgroup::eArithmetic) && (subgroupOperations & Subgroup::eBasic);
+    if (!regionSupported) {
+        PLOGW << "Compute shaders lack subgroup arithmetic, region statistics are disabled";
+    }
+    const auto regionStatistics = StorageBuffer::Builder()
+        .byteSize(sizeof(BandStatistics) * bandCount)
+        .deviceAddress()
+        .hostReadable()
+        .build(*engine);
+    const auto regionShader = regionSupported
+        ? ComputeShader::Builder()
+            .computeShader("shaders/roi.comp")
+            .pushConstantSize(sizeof(RegionOfInterest))
+            .build(*engine)
+        : nullptr;
+    const auto regionInstance = regionSupported ? regionShader->createInstance(*engine) : nullptr;
+
+    logMemoryStatistics(engine->getMemoryStatistics());
+
+    // PCA variants specialized on the common component counts are built the first time each count gets selected,
+    // any other count is served by the generic variant which reads it from the PCA uniform
+    static constexpr auto MAX_SPECIALIZED_COMPONENTS = 8;
+    auto pcaVariants = std::map<int, ShaderVariant>{};
+    const auto getPcaVariant = [&](const int componentCount) {
+        const auto key = componentCount <= MAX_SPECIALIZED_COMPONENTS ? componentCount : 0;
+        if (const auto it = pcaVariants.find(key); it != pcaVariants.end()) {
+            return it->second.instance;
+        }
+
+        const auto variantScope = Trace::Scope{ "Build PCA variant" };
+        const auto variant = GraphicShader::Builder(pcaShaderBuilder)
+            .specializationConstant(1, key)
+            .build(*engine, *swapChain);
+
+        const auto instance = variant->createInstance(*engine);
+        instance->setDescriptor(0, tristimulus, *engine);
+        instance->setDescriptor(1, dimension, *engine);
+        instance->setDescriptor(2, pca, *engine);
+        instance->setDescriptor(3, vectors, *engine);
+
+        pcaVariants.emplace(key, ShaderVariant{ variant, instance });
+        return instance;
+    };
 
     const auto pcaQuad = Drawable::Builder(1)
         .geometry(0, Drawable::Topology::TriangleStrip, vertexBuffer, indexBuffer, indices.size())
-        .material(0, pcaShaderInstance)
+        .material(0, getPcaVariant(pcaObject.componentCount))
         .build(*engine);
     pcaQuad->setTransform(translate(glm::mat4{ 1.0f }, { -OFFSET_X, 0.0f, 0.0f }));
+    pcaQuad->setName("PCA quad");
+
+    const auto similarity = UniformBuffer::Builder()
+        .dataByteSize(sizeof(sam::Similarity))
+        .build(*engine);
+    auto similarityObject = sam::Similarity{};
+
+    const auto samShader = GraphicShader::Builder()
+        .vertexShader("shaders/shader.vert")
+        .fragmentShader("shaders/sam.frag")
+        .descriptorCount(2)
+        .descriptor(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
+        .descriptor(1, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
+        .build(*engine, *swapChain);
+
+    const auto samShaderInstance = samShader->createInstance(*engine);
+    samShaderInstance->setDescriptor(0, dimension, *engine);
+    samShaderInstance->setDescriptor(1, similarity, *engine);
+
+    // The similarity map sits next to the PCA quad, on the opposite side from the XYZ quad
+    static constexpr auto SAM_OFFSET_X = -3.0f * OFFSET_X;
+    const auto samQuad = Drawable::Builder(1)
+        .geometry(0, Drawable::Topology::TriangleStrip, vertexBuffer, indexBuffer, indices.size())
+        .material(0, samShaderInstance)
+        .build(*engine);
+    samQuad->setTransform(translate(glm::mat4{ 1.0f }, { SAM_OFFSET_X, 0.0f, 0.0f }));
+    samQuad->setName("SAM quad");
+
+    const auto bandMath = UniformBuffer::Builder()
+        .dataByteSize(sizeof(bandmath::BandMath))
+        .build(*engine);
+    auto bandMathObject = bandmath::BandMath{};
+
+    const auto bandMathShader = GraphicShader::Builder()
+        .vertexShader("shaders/shader.vert")
+        .fragmentShader("shaders/bandmath.frag")
+        .descriptorCount(2)
+        .descriptor(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
+        .descriptor(1, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eFragment)
+        .build(*engine, *swapChain);
+
+    const auto bandMathShaderInstance = bandMathShader->createInstance(*engine);
+    bandMathShaderInstance->setDescriptor(0, dimension, *engine);
+    bandMathShaderInstance->setDescriptor(1, bandMath, *engine);
+
+    // The band math quad sits next to the XYZ quad, on the opposite side from the PCA quad
+    static constexpr auto BAND_MATH_OFFSET_X = 3.0f * OFFSET_X;
+    const auto bandMathQuad = Drawable::Builder(1)
+        .geometry(0, Drawable::Topology::TriangleStrip, vertexBuffer, indexBuffer, indices.size())
+        .material(0, bandMathShaderInstance)
+        .build(*engine);
+    bandMathQuad->setTransform(translate(glm::mat4{ 1.0f }, { BAND_MATH_OFFSET_X, 0.0f, 0.0f }));
+    bandMathQuad->setName("Band math quad");
 
     const auto drawShader = GraphicShader::Builder()
         .vertexShader("shaders/draw.vert")
@@ -269,12 +668,23 @@ int main(const int argc, char* argv[]) {
 
     const auto drawShaderInstance = drawShader->createInstance(*engine);
 
+    // All marks share the same geometry and are drawn in a single call, each instance with its own offset and color
+    const auto markShader = GraphicShader::Builder()
+        .vertexShader("shaders/marker.vert")
+        .fragmentShader("shaders/draw.frag")
+        .build(*engine, *swapChain);
+
+    const auto markShaderInstance = markShader->createInstance(*engine);
+
     const auto markVertexBuffer = buildMarkVertexBuffer(*engine);
     const auto markIndexBuffer = buildMarkIndexBuffer(*engine);
-    const auto mark = Drawable::Builder(1)
+    const auto markInstances = buildMarkInstanceBuffer(*engine);
+    const auto marks = Drawable::Builder(1)
         .geometry(0, Drawable::Topology::TriangleFan, markVertexBuffer, markIndexBuffer, SUBDIVISION_COUNT + 2)
-        .material(0, drawShaderInstance)
+        .material(0, markShaderInstance)
+        .instances(markInstances)
         .build(*engine);
+    marks->setName("Marks");
 
     const auto frameVertexBuffer = buildFrameVertexBuffer(imgRatio, *engine);
     const auto frameIndexBuffer = buildFrameIndexBuffer(*engine);
@@ -282,6 +692,7 @@ int main(const int argc, char* argv[]) {
         .geometry(0, Drawable::Topology::LineStrip, frameVertexBuffer, frameIndexBuffer, 5)
         .material(0, drawShaderInstance)
         .build(*engine);
+    frame->setName("Frame");
 
     constexpr auto translateVector = glm::vec3{ -6.0f, 1.5f, 0.0f };
     frame->setTransform(translate(glm::mat4{ 1.0f }, translateVector));
@@ -289,7 +700,9 @@ int main(const int argc, char* argv[]) {
     const auto scene = Scene::create();
     scene->insert(xyzQuad);
     scene->insert(pcaQuad);
-    scene->insert(mark);
+    scene->insert(samQuad);
+    scene->insert(bandMathQuad);
+    scene->insert(marks);
     scene->insert(frame);
 
     // Create a camera
@@ -311,82 +724,361 @@ int main(const int argc, char* argv[]) {
     Overlay::init(context->getSurface(), *engine, *swapChain);
     const auto gui = std::make_shared<GUI>();
 
+    // Spectra come straight from the source dataset on a worker, which may take a while on a slow disk. The latest
+    // click wins, the loop is woken up to show its curve once read. Failing to open a second handle to the dataset
+    // only leaves the spectral curve empty
+    auto spectralProbe = std::unique_ptr<SpectralProbe>{};
+    try {
+        spectralProbe = std::make_unique<SpectralProbe>(pathAbsolute, [gui](
+            auto&& values, const int imgX, const int imgY, const auto requestTime) {
+            gui->updateSpectralCurve(std::move(values), imgX, imgY, requestTime);
+            Context::requestRedraw();
+        });
+    } catch (const std::runtime_error& e) {
+        PLOGW << "Spectral curves are disabled: " << e.what();
+    }
+
     float quadX{ 0.5f };
     float quadY{ 0.5f };
-    mark->setTransform(translate(glm::mat4{ 1.0f },
-        glm::vec3{ 0.7f * QUAD_SIDE_HALF_EXTENT * imgRatio * (quadX * 2.0f - 1.0f),
-            0.7f * QUAD_SIDE_HALF_EXTENT * (quadY * 2.0f - 1.0f), 0.0f } + translateVector));
+    const auto getMarkTransform = [&] {
+        return translate(glm::mat4{ 1.0f }, glm::vec3{ 0.7f * QUAD_SIDE_HALF_EXTENT * imgRatio * (quadX * 2.0f - 1.0f),
+            0.7f * QUAD_SIDE_HALF_EXTENT * (quadY * 2.0f - 1.0f), 0.0f });
+    };
+
+    // The first mark follows the probe, the rest are pinned samples
+    static constexpr auto PIN_COLORS = std::array{
+        glm::vec4{ 1.0f, 0.3f, 0.3f, 1.0f },
+        glm::vec4{ 0.3f, 1.0f, 0.3f, 1.0f },
+        glm::vec4{ 0.3f, 0.5f, 1.0f, 1.0f },
+        glm::vec4{ 1.0f, 1.0f, 0.3f, 1.0f },
+        glm::vec4{ 1.0f, 0.3f, 1.0f, 1.0f },
+        glm::vec4{ 0.3f, 1.0f, 1.0f, 1.0f },
+    };
+    auto markInstanceData = std::vector{ MarkInstance{ getMarkTransform(), glm::vec4{ 1.0f } } };
+    marks->setTransform(translate(glm::mat4{ 1.0f }, translateVector));
+
+    // Clicks coalesce into the latest reference pixel while angles are being computed, like dragged regions below
+    const auto getReferencePixel = [&](const float referenceX, const float referenceY) {
+        const auto pX = std::min(static_cast<int>(referenceX * static_cast<float>(bufferXSize)), bufferXSize - 1);
+        const auto pY = std::min(static_cast<int>(referenceY * static_cast<float>(bufferYSize)), bufferYSize - 1);
+        return pY * bufferXSize + pX;
+    };
+    auto pendingReference = std::optional{ getReferencePixel(0.5f, 0.5f) };
+    auto similarityTicket = std::optional<uint64_t>{};
+    auto displayedAngles = sam::ANGLE_BUFFER_COUNT - 1;
 
     Context::setOnMouseClick([&](const auto x, const auto y) {
+        const auto clickScope = Trace::Scope{ "Mouse click", "input" };
+        renderer->markInput();
         if (getQuadCoordinates(x, y, swapChain->getFramebufferSize(), imgRatio, OFFSET_X, &quadX, &quadY)) {
             // Find image coordinates at this quad location
             const auto imgX = std::min(static_cast<int>(std::round(static_cast<float>(imgXSize) * quadX)), imgXSize - 1);
             const auto imgY = std::min(static_cast<int>(std::round(static_cast<float>(imgYSize) * quadY)), imgYSize - 1);
 
-            gui->updateSpectralCurve(getSpectralValues(dataset, quadX, quadY));
-            gui->updateCurrentImageCoordinates(imgX, imgY);
-            mark->setTransform(translate(glm::mat4{ 1.0f },
-                glm::vec3{ 0.7f * QUAD_SIDE_HALF_EXTENT * imgRatio * (quadX * 2.0f - 1.0f),
-                    0.7f * QUAD_SIDE_HALF_EXTENT * (quadY * 2.0f - 1.0f), 0.0f } + translateVector));
+            if (spectralProbe) {
+                spectralProbe->request(imgX, imgY);
+            }
+            markInstanceData[0].transform = getMarkTransform();
+            pendingReference = getReferencePixel(quadX, quadY);
+        }
+    });
+
+    // Regions dragged while a reduction is in flight coalesce into the latest one, which goes out once it's done
+    auto pendingRegion = std::optional<RegionOfInterest>{};
+    auto dispatchedRegion = RegionOfInterest{};
+    auto regionTicket = std::optional<uint64_t>{};
+    Context::setOnMouseDrag([&](const auto x0, const auto y0, const auto x1, const auto y1, [[maybe_unused]] const auto released) {
+        float quadX0, quadY0, quadX1, quadY1;
+        if (!regionSupported ||
+            !getQuadCoordinates(x0, y0, swapChain->getFramebufferSize(), imgRatio, OFFSET_X, &quadX0, &quadY0) ||
+            !getQuadCoordinates(x1, y1, swapChain->getFramebufferSize(), imgRatio, OFFSET_X, &quadX1, &quadY1)) {
+            return;
         }
+
+        // Both corners are included, so that a click without moving gives the statistics of a single pixel
+        const auto toRaster = [](const float quadCoordinate, const int rasterSize) {
+            return std::clamp(static_cast<int>(quadCoordinate * static_cast<float>(rasterSize)), 0, rasterSize - 1);
+        };
+        pendingRegion = RegionOfInterest{
+            cube->getDeviceAddress(), bandByteSize, regionStatistics->getDeviceAddress(), bufferXSize,
+            toRaster(std::min(quadX0, quadX1), bufferXSize), toRaster(std::min(quadY0, quadY1), bufferYSize),
+            toRaster(std::max(quadX0, quadX1), bufferXSize) + 1, toRaster(std::max(quadY0, quadY1), bufferYSize) + 1 };
     });
 
+    // The whole scene is shown until a region is dragged. A cached cube comes with its statistics, otherwise they're
+    // reduced on the GPU like those of any region
+    if (!sceneStatistics.empty()) {
+        gui->updateRegionStatistics(0, 0, imgXSize, imgYSize, std::move(sceneStatistics));
+    } else if (regionSupported) {
+        pendingRegion = RegionOfInterest{
+            cube->getDeviceAddress(), bandByteSize, regionStatistics->getDeviceAddress(), bufferXSize,
+            0, 0, bufferXSize, bufferYSize };
+    }
+
+    // Newly compiled programs coalesce like regions, the last one evaluated is kept around for exporting
+    auto pendingProgram = std::optional<bandmath::Program>{};
+    auto evaluatedProgram = std::optional<bandmath::Program>{};
+    auto bandMathTicket = std::optional<uint64_t>{};
+    auto displayedResult = bandmath::RESULT_BUFFER_COUNT - 1;
+    const auto getEvaluation = [&](const StorageBuffer* const result) {
+        return bandmath::Evaluation{
+            cube->getDeviceAddress(), bandByteSize, result->getDeviceAddress(), bufferXSize, bufferYSize };
+    };
+    const auto exportBandMath = [&](const bandmath::Program& program) {
+        const auto exportScope = Trace::Scope{ "Export band math" };
+        const auto readback = StorageBuffer::Builder()
+            .byteSize(sizeof(float) * pixelCount)
+            .deviceAddress()
+            .hostReadable()
+            .build(*engine);
+        const auto evaluation = getEvaluation(readback);
+        const auto ticket = computeQueue->dispatch(
+            getBandMathKernel(program), pixelGroupCountX, static_cast<uint32_t>(bufferYSize), 1,
+            &evaluation, sizeof(evaluation));
+        computeQueue->wait(ticket);
+
+        auto values = std::vector<float>(pixelCount);
+        readback->getData(values.data(), sizeof(float) * pixelCount, *engine);
+        engine->destroyBuffer(readback);
+
+        const auto path = pathAbsolute.parent_path() /
+            std::format("{}_{:016x}.tif", pathAbsolute.stem().string(), std::hash<std::string>{}(program.getKey()));
+        bandmath::writeGeoTiff(path, values, bufferXSize, bufferYSize, dataset);
+        return path;
+    };
+
+    // Levels are recomputed when the illuminant or the sensor changes, the cube itself never does
+    auto stretchedInputs = std::optional<std::pair<spd::Illuminant, spd::Sensor>>{};
+    auto levelsTicket = std::optional<uint64_t>{};
+    auto displayedLevels = levels::LEVELS_BUFFER_COUNT - 1;
+
     // Set the initial indicator position
     const auto imgX = std::min(static_cast<int>(std::round(static_cast<float>(imgXSize) * 0.5f)), imgXSize - 1);
     const auto imgY = std::min(static_cast<int>(std::round(static_cast<float>(imgYSize) * 0.5f)), imgYSize - 1);
-    gui->updateSpectralCurve(getSpectralValues(dataset, 0.5f, 0.5f));
-    gui->updateCurrentImageCoordinates(imgX, imgY);
+    if (spectralProbe) {
+        spectralProbe->request(imgX, imgY);
+    }
 
     view->setLineWidth(3.0f);
 
-    // The render loop
-    context->loop([&] {
+    // The render loop. Waiting for the next frame slot before polling events lets clicks be sampled as late as possible.
+    // On demand, the loop sleeps until input arrives, all state shown comes from input handled on this thread
+    context->loop([&] { renderer->waitForNextFrame(); }, [&] {
+        context->setRenderOnDemand(gui->isRenderOnDemand());
+        renderer->setFramesInFlight(gui->getFramesInFlight());
+        swapChain->setPresentMode(gui->getPresentMode());
+
+        if (regionTicket && computeQueue->isComplete(*regionTicket)) {
+            auto values = std::vector<BandStatistics>(bandCount);
+            regionStatistics->getData(values.data(), sizeof(BandStatistics) * bandCount, *engine);
+            // Downscaling factors may be fractional, raster pixels don't always start on an image pixel
+            const auto toImageX = [&](const int rasterX) {
+                return static_cast<int>(std::round(static_cast<double>(rasterX) * imgXSize / bufferXSize));
+            };
+            const auto toImageY = [&](const int rasterY) {
+                return static_cast<int>(std::round(static_cast<double>(rasterY) * imgYSize / bufferYSize));
+            };
+            gui->updateRegionStatistics(
+                toImageX(dispatchedRegion.minX), toImageY(dispatchedRegion.minY),
+                toImageX(dispatchedRegion.maxX), toImageY(dispatchedRegion.maxY), std::move(values));
+            regionTicket.reset();
+        }
+        if (!regionTicket && pendingRegion) {
+            dispatchedRegion = *pendingRegion;
+            pendingRegion.reset();
+            regionTicket = computeQueue->dispatch(
+                regionInstance, static_cast<uint32_t>(bandCount), 1, 1, &dispatchedRegion, sizeof(dispatchedRegion));
+        }
+
+        // Switch the similarity map over to the new angles once handed over, then query the latest reference. The
+        // ring of angle buffers lets frames in flight keep reading the previous ones meanwhile
+        if (similarityTicket && computeQueue->isComplete(*similarityTicket)) {
+            displayedAngles = (displayedAngles + 1) % sam::ANGLE_BUFFER_COUNT;
+            similarityObject.angleAddress = angles[displayedAngles]->getDeviceAddress();
+            similarityTicket.reset();
+        }
+        if (!similarityTicket && pendingReference) {
+            const auto target = angles[(displayedAngles + 1) % sam::ANGLE_BUFFER_COUNT];
+            const auto query = sam::Query{
+                cube->getDeviceAddress(), bandByteSize, norms->getDeviceAddress(), target->getDeviceAddress(),
+                bufferXSize, bufferYSize, *pendingReference };
+            pendingReference.reset();
+            similarityTicket = computeQueue->dispatch(
+                angleInstance, pixelGroupCountX, static_cast<uint32_t>(bufferYSize), 1,
+                &query, sizeof(query), { target });
+        }
+
+        // Compile whatever expression has been submitted, reporting mistakes back to the band math window
+        if (const auto expression = gui->consumeBandMathExpression()) {
+            try {
+                pendingProgram = bandmath::compile(*expression, residentWavelengths, bandBegin);
+                gui->updateBandMathStatus({});
+            } catch (const std::invalid_argument& e) {
+                PLOGW << "Could not compile band math expression " << *expression << ": " << e.what();
+                gui->updateBandMathStatus(e.what());
+            }
+        }
+        if (bandMathTicket && computeQueue->isComplete(*bandMathTicket)) {
+            displayedResult = (displayedResult + 1) % bandmath::RESULT_BUFFER_COUNT;
+            bandMathObject.resultAddress = bandMathResults[displayedResult]->getDeviceAddress();
+            bandMathTicket.reset();
+        }
+        if (!bandMathTicket && pendingProgram) {
+            const auto target = bandMathResults[(displayedResult + 1) % bandmath::RESULT_BUFFER_COUNT];
+            const auto evaluation = getEvaluation(target);
+            bandMathTicket = computeQueue->dispatch(
+                getBandMathKernel(*pendingProgram), pixelGroupCountX, static_cast<uint32_t>(bufferYSize), 1,
+                &evaluation, sizeof(evaluation), { target });
+            evaluatedProgram = std::move(pendingProgram);
+            pendingProgram.reset();
+        }
+        if (gui->consumeBandMathExportRequest() && evaluatedProgram) {
+            try {
+                const auto path = exportBandMath(*evaluatedProgram);
+                PLOGI << "Exported band math to " << path;
+                gui->updateBandMathStatus(std::format("Exported to {}", path.string()));
+            } catch (const std::runtime_error& e) {
+                PLOGE << "Could not export band math: " << e.what();
+                gui->updateBandMathStatus(e.what());
+            }
+        }
+
+        // Stretch to the new levels once handed over. The levels pass empties the histogram as it reads it, so it's
+        // ready for the next pair of dispatches
+        if (levelsTicket && computeQueue->isComplete(*levelsTicket)) {
+            displayedLevels = (displayedLevels + 1) % levels::LEVELS_BUFFER_COUNT;
+            stretchObject.levelsAddress = levelBuffers[displayedLevels]->getDeviceAddress();
+            levelsTicket.reset();
+        }
+        if (const auto inputs = std::pair{ gui->getCurrentIlluminant(), gui->getCurrentSensor() };
+            !levelsTicket && stretchedInputs != inputs) {
+            tristimulusWeights->setData(getTristimulus(inputs.first, inputs.second).weights.data(), *engine);
+
+            const auto binning = levels::Binning{
+                cube->getDeviceAddress(), bandByteSize, tristimulusWeights->getDeviceAddress(),
+                histogram->getDeviceAddress(), bufferXSize, bufferYSize };
+            computeQueue->dispatch(
+                histogramInstance, histogramGroupCountX, static_cast<uint32_t>(bufferYSize), 1,
+                &binning, sizeof(binning));
+
+            const auto target = levelBuffers[(displayedLevels + 1) % levels::LEVELS_BUFFER_COUNT];
+            const auto percentiles = levels::Percentiles{
+                histogram->getDeviceAddress(), target->getDeviceAddress(), static_cast<uint32_t>(pixelCount) };
+            levelsTicket = computeQueue->dispatch(
+                levelsInstance, 1, 1, 1, &percentiles, sizeof(percentiles), { target });
+            stretchedInputs = inputs;
+        }
+
+        // Keep rendering until the statistics, angles, band math and levels are in, they take a frame or two to arrive
+        if (regionTicket || similarityTicket || bandMathTicket || levelsTicket) {
+            Context::requestRedraw();
+        }
+
         renderer->render(view, gui, swapChain, [&](const auto frameIndex) {
-            // Update current illuminant and sensor
-            int i = 0;
-            for (auto b = bandBegin; b < bandEnd; ++b) {
-                const auto wavelength = centerWavelengths[b];
-                illuminantObject.data[i] = getIlluminantValueAt(wavelength, gui->getCurrentIlluminant());
-                sensorObject.x[i] = getSensorXValueAt(wavelength, gui->getCurrentSensor());
-                sensorObject.y[i] = getSensorYValueAt(wavelength, gui->getCurrentSensor());
-                sensorObject.z[i] = getSensorZValueAt(wavelength, gui->getCurrentSensor());
-                i += 4;
+            // Weigh bands for the current illuminant and sensor
+            tristimulus->setData(frameIndex, &getTristimulus(gui->getCurrentIlluminant(), gui->getCurrentSensor()));
+            stretch->setData(frameIndex, &stretchObject);
+
+            // Switch over to the projected scores as soon as the compute queue has handed them over
+            if (pcaObject.scoreAddress == 0 && computeQueue->isComplete(projectionTicket)) {
+                pcaObject.scoreAddress = scores->getDeviceAddress();
             }
-            illuminant->setData(frameIndex, &illuminantObject);
-            sensor->setData(frameIndex, &sensorObject);
+
+            similarityObject.threshold = gui->getSimilarityThreshold();
+            similarity->setData(frameIndex, &similarityObject);
+
+            std::tie(bandMathObject.minimum, bandMathObject.maximum) = gui->getBandMathRange();
+            bandMath->setData(frameIndex, &bandMathObject);
 
             // Update current PCA count
             pcaObject.componentCount = gui->getCurrentComponentCount();
             pca->setData(frameIndex, &pcaObject);
+            pcaQuad->setMaterial(0, getPcaVariant(pcaObject.componentCount));
+
+            // Pin the current sample or clear all pins, then upload the marks for this frame
+            if (gui->consumePinRequest() && markInstanceData.size() < MAX_MARK_COUNT) {
+                const auto color = PIN_COLORS[(markInstanceData.size() - 1) % PIN_COLORS.size()];
+                markInstanceData.push_back({ markInstanceData[0].transform, color });
+            }
+            if (gui->consumeClearPinsRequest()) {
+                markInstanceData.resize(1);
+            }
+            gui->updatePinnedCount(static_cast<int>(markInstanceData.size()) - 1);
+            markInstances->setData(frameIndex, markInstanceData.data(), static_cast<uint32_t>(markInstanceData.size()));
+
+            // Timings of frames that have retired by now
+            gui->updateGpuTimings(renderer->getGpuTimings());
+            gui->updateInputLatency(renderer->getInputLatency());
+            gui->updateMemoryStatistics(engine->getMemoryStatistics());
         });
     });
 
-    // When we exit the loop, drawing and presentation operations may still be going on.
+    // When we exit the loop, drawing and presentation operations may still be going on, so might the projection.
     // Cleaning up resources while that is happening is a bad idea.
+    projectionWatcher.join();
+    spectralProbe.reset();
     engine->waitIdle();
 
     // Destroy Dear ImGUI components
     Overlay::teardown(*engine);
 
     // Destroy all rendering resources
+    engine->destroyShaderInstance(markShaderInstance);
     engine->destroyShaderInstance(drawShaderInstance);
-    engine->destroyShaderInstance(pcaShaderInstance);
+    for (const auto& [variantShader, variantInstance] : pcaVariants | std::views::values) {
+        engine->destroyShaderInstance(variantInstance);
+        engine->destroyShader(variantShader);
+    }
+    engine->destroyShaderInstance(bandMathShaderInstance);
+    engine->destroyShaderInstance(samShaderInstance);
     engine->destroyShaderInstance(shaderInstance);
+    if (regionSupported) {
+        engine->destroyShaderInstance(regionInstance);
+        engine->destroyShader(regionShader);
+    }
+    engine->destroyShaderInstance(levelsInstance);
+    engine->destroyShader(levelsShader);
+    engine->destroyShaderInstance(histogramInstance);
+    engine->destroyShader(histogramShader);
+    for (const auto& [kernel, kernelInstance] : bandMathKernels | std::views::values) {
+        engine->destroyShaderInstance(kernelInstance);
+        engine->destroyShader(kernel);
+    }
+    engine->destroyShaderInstance(angleInstance);
+    engine->destroyShader(angleShader);
+    engine->destroyShaderInstance(normInstance);
+    engine->destroyShader(normShader);
+    engine->destroyShaderInstance(projectionInstance);
+    engine->destroyShader(projectionShader);
+    engine->destroyShader(markShader);
     engine->destroyShader(drawShader);
-    engine->destroyShader(pcaShader);
+    engine->destroyShader(bandMathShader);
+    engine->destroyShader(samShader);
     engine->destroyShader(shader);
     std::ranges::for_each(vectors, [&engine](const auto it) { engine->destroyBuffer(it); });
-    std::ranges::for_each(rasters, [&engine](const auto it) { engine->destroyBuffer(it); });
+    std::ranges::for_each(levelBuffers, [&engine](const auto it) { engine->destroyBuffer(it); });
+    std::ranges::for_each(bandMathResults, [&engine](const auto it) { engine->destroyBuffer(it); });
+    std::ranges::for_each(angles, [&engine](const auto it) { engine->destroyBuffer(it); });
+    engine->destroyBuffer(norms);
+    engine->destroyBuffer(histogram);
+    engine->destroyBuffer(tristimulusWeights);
+    engine->destroyBuffer(regionStatistics);
+    engine->destroyBuffer(scores);
+    engine->destroyBuffer(cube);
     engine->destroyBuffer(frameIndexBuffer);
     engine->destroyBuffer(frameVertexBuffer);
+    engine->destroyBuffer(markInstances);
     engine->destroyBuffer(markIndexBuffer);
     engine->destroyBuffer(markVertexBuffer);
+    engine->destroyBuffer(stretch);
+    engine->destroyBuffer(bandMath);
+    engine->destroyBuffer(similarity);
     engine->destroyBuffer(pca);
     engine->destroyBuffer(dimension);
-    engine->destroyBuffer(sensor);
-    engine->destroyBuffer(illuminant);
+    engine->destroyBuffer(tristimulus);
     engine->destroyBuffer(indexBuffer);
     engine->destroyBuffer(vertexBuffer);
+    engine->destroyComputeQueue(computeQueue);
     engine->destroyRenderer(renderer);
     engine->destroySwapChain(swapChain);
     engine->destroy();
@@ -397,5 +1089,8 @@ int main(const int argc, char* argv[]) {
     // Close the dataset
     GDALClose(dataset);
 
+    // Write out the trace, if requested
+    Trace::stop();
+
     return 0;
 }
@@ -2,12 +2,20 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <plog/Log.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <exception>
+#include <format>
 #include <fstream>
 #include <map>
+#include <mutex>
 #include <numbers>
 #include <ranges>
+#include <thread>
 
 
 glm::mat4 getPanProjection(const float framebufferAspectRatio) {
@@ -90,23 +98,89 @@ std::vector<double> parseMetadata(char** const metadata, const int count) {
     return centers;
 }
 
-std::vector<float> getSpectralValues(GDALDataset* dataset, const float quadX, const float quadY) {
-    const auto imgYSize = dataset->GetRasterYSize();
-    const auto imgXSize = dataset->GetRasterXSize();
-    const auto imgX = std::min(static_cast<int>(std::round(static_cast<float>(imgXSize) * quadX)), imgXSize - 1);
-    const auto imgY = std::min(static_cast<int>(std::round(static_cast<float>(imgYSize) * quadY)), imgYSize - 1);
+std::vector<double> parseFullWidths(GDALDataset* const dataset, const std::vector<double>& centers) {
+    // GDAL exposes the ENVI header fields in their own domain, the widths as a list like { 5.8, 5.8, 5.9 }
+    if (const auto item = dataset->GetMetadataItem("fwhm", "ENVI"); item != nullptr) {
+        auto widths = std::vector<double>{};
+        for (auto position = item; *position != '\0';) {
+            char* end{};
+            const auto value = std::strtod(position, &end);
+            if (end == position) {
+                ++position;
+            } else {
+                widths.push_back(value);
+                position = end;
+            }
+        }
+        if (widths.size() == centers.size()) {
+            return widths;
+        }
+        PLOGW << "The header lists " << widths.size() << " band widths for " << centers.size()
+              << " bands, ignoring them";
+    }
 
-    const auto bandCount = dataset->GetRasterCount();
-    auto values = std::vector<float>(bandCount);
-    for (int i = 1; i <= bandCount; ++i) {
-        const auto band = dataset->GetRasterBand(i);
+    // Assume each band reaches halfway to its neighbors
+    auto widths = std::vector<double>(centers.size());
+    for (std::size_t i = 0; i < centers.size(); ++i) {
+        const auto lower = i > 0 ? centers[i] - centers[i - 1] : 0.0;
+        const auto upper = i + 1 < centers.size() ? centers[i + 1] - centers[i] : 0.0;
+        widths[i] = i > 0 && i + 1 < centers.size() ? (lower + upper) / 2.0 : std::max(lower, upper);
+    }
+    return widths;
+}
 
-        float pixelValue = 0.0f;
-        [[maybe_unused]] const auto err = band->RasterIO(GF_Read, imgX, imgY, 1, 1, &pixelValue, 1, 1, GDT_Float32, 0, 0);
+uint64_t getAvailableDeviceMemory(const MemoryStatistics& statistics) {
+    // Dedicated buffers end up in the largest device-local heap, assume that's where our data will go
+    auto available = uint64_t{ 0 };
+    for (const auto& heap : statistics.heaps) {
+        if (heap.deviceLocal && heap.budget > heap.usage) {
+            available = std::max(available, heap.budget - heap.usage);
+        }
+    }
+    return available;
+}
 
-        values[i - 1] = pixelValue;
+void logMemoryStatistics(const MemoryStatistics& statistics) {
+    static constexpr auto MiB = 1024.0 * 1024.0;
+    for (std::size_t i = 0; i < statistics.heaps.size(); ++i) {
+        const auto& heap = statistics.heaps[i];
+        PLOGI << std::format("Heap {}{}: {:.1f} / {:.1f} MiB used, {} allocations in {} blocks ({:.1f} MiB)",
+            i, heap.deviceLocal ? " (device local)" : "", heap.usage / MiB, heap.budget / MiB,
+            heap.allocationCount, heap.blockCount, heap.blockBytes / MiB);
+    }
+    for (int i = 0; i < RESOURCE_KIND_COUNT; ++i) {
+        const auto& [count, bytes] = statistics.resources[i];
+        if (count == 0) continue;
+        PLOGI << std::format("{}: {} allocations, {:.1f} MiB",
+            getResourceKindName(static_cast<ResourceKind>(i)), count, bytes / MiB);
+    }
+}
+
+void parallelFor(const uint64_t count, const std::function<void(uint64_t)>& task) {
+    auto next = std::atomic<uint64_t>{ 0 };
+    auto exception = std::exception_ptr{};
+    auto exceptionMutex = std::mutex{};
+    {
+        const auto workerCount = std::min<uint64_t>(std::max(std::thread::hardware_concurrency(), 1u), count);
+        auto workers = std::vector<std::jthread>{};
+        workers.reserve(workerCount);
+        for (uint64_t w = 0; w < workerCount; ++w) {
+            workers.emplace_back([&] {
+                try {
+                    for (auto i = next++; i < count; i = next++) {
+                        task(i);
+                    }
+                } catch (...) {
+                    next = count;
+                    const auto lock = std::lock_guard{ exceptionMutex };
+                    if (!exception) exception = std::current_exception();
+                }
+            });
+        }
+    }
+    if (exception) {
+        std::rethrow_exception(exception);
     }
-    return values;
 }
 
 struct RegionInfo {
@@ -198,6 +272,19 @@ VertexBuffer* buildMarkVertexBuffer(const Engine& engine) {
     return buffer;
 }
 
+InstanceBuffer* buildMarkInstanceBuffer(const Engine& engine) {
+    // Binding 0 and 1 are taken by the mark vertex buffer
+    return InstanceBuffer::Builder()
+        .capacity(static_cast<uint32_t>(MAX_MARK_COUNT))
+        .binding(2, sizeof(MarkInstance))
+        .attribute(2, AttributeFormat::Float4, offsetof(MarkInstance, transform) + 0 * sizeof(glm::vec4))
+        .attribute(3, AttributeFormat::Float4, offsetof(MarkInstance, transform) + 1 * sizeof(glm::vec4))
+        .attribute(4, AttributeFormat::Float4, offsetof(MarkInstance, transform) + 2 * sizeof(glm::vec4))
+        .attribute(5, AttributeFormat::Float4, offsetof(MarkInstance, transform) + 3 * sizeof(glm::vec4))
+        .attribute(6, AttributeFormat::Float4, offsetof(MarkInstance, color))
+        .build(engine);
+}
+
 IndexBuffer* buildMarkIndexBuffer(const Engine& engine) {
     auto indices = std::array<uint16_t, SUBDIVISION_COUNT + 2>{};
     std::ranges::generate_n(indices.begin(), SUBDIVISION_COUNT + 2, [n{ 0 }]() mutable { return n++; });
@@ -1,14 +1,18 @@
 #pragma once
 
 #include <engine/Engine.h>
+#include <engine/MemoryStatistics.h>
 #include <engine/VertexBuffer.h>
 #include <engine/IndexBuffer.h>
+#include <engine/InstanceBuffer.h>
 
 #include <gdal_priv.h>
 #include <glm/glm.hpp>
 
 #include <array>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -21,20 +25,40 @@ bool getQuadCoordinates(
     float x, float y, const std::pair<int, int>& framebufferSize, float quadAspectRatio,
     float offsetX, float* quadX, float* quadY, float* posX = nullptr, float* posY = nullptr);
 
-struct Illuminant {
-    alignas(16) std::array<float, 512> data{};
-};
+// The most bands the shaders take, bounded by the size of the Tristimulus uniform
+static constexpr auto MAX_RESIDENT_BANDS = 128;
 
-struct Sensor {
-    alignas(16) std::array<float, 512> x{};
-    alignas(16) std::array<float, 512> y{};
-    alignas(16) std::array<float, 512> z{};
+// Per-band weights of the illuminant and sensor, see spd::computeTristimulusWeights
+struct Tristimulus {
+    alignas(16) std::array<glm::vec4, MAX_RESIDENT_BANDS> weights{};
 };
 
 struct Dimension {
     alignas(4) int rasterX;
     alignas(4) int rasterY;
     alignas(4) int rasterCount;
+    alignas(8) uint64_t cubeAddress;
+    alignas(8) uint64_t bandByteStride;
+};
+
+// Push constants of the roi compute shader, the region spans [minX, maxX) x [minY, maxY) in raster coordinates
+struct RegionOfInterest {
+    alignas(8) uint64_t cubeAddress;
+    alignas(8) uint64_t bandByteStride;
+    alignas(8) uint64_t statisticsAddress;
+    alignas(4) int rasterX;
+    alignas(4) int minX;
+    alignas(4) int minY;
+    alignas(4) int maxX;
+    alignas(4) int maxY;
+};
+
+// What the roi compute shader writes for each band, as a vec4
+struct BandStatistics {
+    float mean;
+    float deviation;
+    float minimum;
+    float maximum;
 };
 
 struct Raster {
@@ -61,12 +85,30 @@ std::ostream& operator<<(std::ostream& os, Region region);
 std::vector<std::string> readHeaderFile(const std::filesystem::path& path);
 std::vector<double> parseMetadata(char** metadata, int count);
 
-std::vector<float> getSpectralValues(GDALDataset* dataset, float quadX, float quadY);
+// Full widths at half maximum from the ENVI header, estimated from the band spacing if the header doesn't list them
+std::vector<double> parseFullWidths(GDALDataset* dataset, const std::vector<double>& centers);
+
+// GPU memory
+uint64_t getAvailableDeviceMemory(const MemoryStatistics& statistics);
+void logMemoryStatistics(const MemoryStatistics& statistics);
+
+// Runs task(i) for every i in [0, count) across all hardware threads, rethrowing the first exception of any task
+void parallelFor(uint64_t count, const std::function<void(uint64_t)>& task);
 
 static constexpr auto SUBDIVISION_COUNT = 64;
 
 [[nodiscard]] VertexBuffer* buildMarkVertexBuffer(const Engine& engine);
 [[nodiscard]] IndexBuffer* buildMarkIndexBuffer(const Engine& engine);
 
+// Every mark, the current probe location and all pinned samples, is an instance of the same mesh drawn in one call
+struct MarkInstance {
+    glm::mat4 transform;
+    glm::vec4 color;
+};
+
+static constexpr std::size_t MAX_MARK_COUNT = 256;
+
+[[nodiscard]] InstanceBuffer* buildMarkInstanceBuffer(const Engine& engine);
+
 [[nodiscard]] VertexBuffer* buildFrameVertexBuffer(float imgRatio, const Engine& engine);
 [[nodiscard]] IndexBuffer* buildFrameIndexBuffer(const Engine& engine);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <filesystem>
 #include <vector>
 
@@ -12,6 +13,16 @@ namespace pca {
     struct PCA {
         alignas(4) int componentCount;
         alignas(4) int maxComponents{ MAX_COMPONENTS };
+        alignas(8) uint64_t scoreAddress{ 0 };
+    };
+
+    // Push constants of the pca compute shader
+    struct Projection {
+        alignas(8) uint64_t cubeAddress;
+        alignas(8) uint64_t bandByteStride;
+        alignas(8) uint64_t scoreAddress;
+        alignas(4) int rasterX;
+        alignas(4) int rasterY;
     };
 
     struct Vector {
@@ -0,0 +1,75 @@
+#include "probe.h"
+
+#include <engine/Trace.h>
+
+#include <plog/Log.h>
+
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+
+SpectralProbe::SpectralProbe(const std::filesystem::path& path, Callback&& onRead)
+    : _dataset{ static_cast<GDALDataset*>(GDALOpen(path.string().c_str(), GA_ReadOnly)) }
+    , _onRead{ std::move(onRead) } {
+    if (_dataset == nullptr) {
+        PLOGE << "Failed to open " << path.string() << " for probing";
+        throw std::runtime_error(std::format("Could not open {}", path.string()));
+    }
+    _worker = std::jthread{ [this](const std::stop_token& stopToken) { run(stopToken); } };
+}
+
+SpectralProbe::~SpectralProbe() {
+    _worker.request_stop();
+    _worker.join();
+    GDALClose(_dataset);
+}
+
+void SpectralProbe::request(const int imgX, const int imgY) {
+    {
+        const auto lock = std::lock_guard{ _requestMutex };
+        _pendingRequest = Request{ imgX, imgY, Clock::now(), ++_generation };
+    }
+    _requestCondition.notify_one();
+}
+
+void SpectralProbe::run(const std::stop_token& stopToken) {
+    while (true) {
+        auto request = Request{};
+        {
+            auto lock = std::unique_lock{ _requestMutex };
+            if (!_requestCondition.wait(lock, stopToken, [this] { return _pendingRequest.has_value(); })) {
+                return;
+            }
+            request = *std::exchange(_pendingRequest, std::nullopt);
+        }
+
+        const auto probeScope = Trace::Scope{ "Read spectral values", "probe" };
+        if (auto values = read(request, stopToken)) {
+            _onRead(std::move(*values), request.imgX, request.imgY, request.time);
+        }
+    }
+}
+
+std::optional<std::vector<float>> SpectralProbe::read(const Request& request, const std::stop_token& stopToken) const {
+    // Each band is a separate read, likely from a separate part of the file for band sequential layouts. Stale
+    // requests stop there rather than holding up the latest one
+    const auto bandCount = _dataset->GetRasterCount();
+    auto values = std::vector<float>(bandCount);
+    for (int i = 1; i <= bandCount; ++i) {
+        if (stopToken.stop_requested() || _generation != request.generation) {
+            return std::nullopt;
+        }
+
+        const auto band = _dataset->GetRasterBand(i);
+        const auto err = band->RasterIO(
+            GF_Read, request.imgX, request.imgY, 1, 1, &values[i - 1], 1, 1, GDT_Float32, 0, 0);
+
+        // A partly read curve would be shown as if it were real, the previous one stays up instead
+        if (err != CE_None) {
+            PLOGW << "Could not read band " << i << " at (" << request.imgX << ", " << request.imgY << ")";
+            return std::nullopt;
+        }
+    }
+    return values;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <gdal_priv.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Reads the spectrum of a pixel from the source dataset on a background thread, so that a slow disk never holds up the
+ * render thread. Requests coalesce: only the latest one is kept while a read is in progress, and a read is abandoned
+ * between bands as soon as a newer request comes in, so the curve always catches up with the last click.
+ */
+class SpectralProbe {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Called on the worker thread with the values of all bands at the requested pixel and the time the read was
+    // requested
+    using Callback = std::function<void(
+        std::vector<float>&& values, int imgX, int imgY, Clock::time_point requestTime)>;
+
+    /**
+     * Opens a handle to the dataset of its own, GDAL datasets must not be read from several threads at once.
+     *
+     * @throw std::runtime_error if the dataset can't be opened.
+     */
+    SpectralProbe(const std::filesystem::path& path, Callback&& onRead);
+
+    SpectralProbe(const SpectralProbe&) = delete;
+    SpectralProbe& operator=(const SpectralProbe&) = delete;
+
+    // Waits for a read in progress to be abandoned
+    ~SpectralProbe();
+
+    // Image coordinates are those of the source dataset, before any downscaling
+    void request(int imgX, int imgY);
+
+private:
+    struct Request {
+        int imgX;
+        int imgY;
+        Clock::time_point time;
+        uint64_t generation;
+    };
+
+    void run(const std::stop_token& stopToken);
+    std::optional<std::vector<float>> read(const Request& request, const std::stop_token& stopToken) const;
+
+    GDALDataset* _dataset;
+    Callback _onRead;
+
+    std::mutex _requestMutex{};
+    std::condition_variable_any _requestCondition{};
+    std::optional<Request> _pendingRequest{};
+    std::atomic<uint64_t> _generation{ 0 };
+
+    std::jthread _worker{};
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <engine/Renderer.h>
+
+#include <cstdint>
+
+
+namespace sam {
+    // Angles are written to a ring of buffers, frames keep reading the last completed one while the next is computed.
+    // A buffer gets written again only after every frame that could still be reading it has retired
+    static constexpr auto ANGLE_BUFFER_COUNT = Renderer::getMaxFramesInFlight() + 1;
+
+    // Push constants of the norm compute shader
+    struct Normalization {
+        alignas(8) uint64_t cubeAddress;
+        alignas(8) uint64_t bandByteStride;
+        alignas(8) uint64_t normAddress;
+        alignas(4) int rasterX;
+        alignas(4) int rasterY;
+    };
+
+    // Push constants of the sam compute shader, the reference is a pixel index into the raster
+    struct Query {
+        alignas(8) uint64_t cubeAddress;
+        alignas(8) uint64_t bandByteStride;
+        alignas(8) uint64_t normAddress;
+        alignas(8) uint64_t angleAddress;
+        alignas(4) int rasterX;
+        alignas(4) int rasterY;
+        alignas(4) int reference;
+    };
+
+    struct Similarity {
+        alignas(8) uint64_t angleAddress{ 0 };
+        alignas(4) float threshold;
+    };
+}
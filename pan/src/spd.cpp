@@ -1 +1,72 @@
 #include "spd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+
+namespace {
+    // The illuminant and sensor tables are sampled every nanometer over this range
+    constexpr auto SAMPLE_MIN = 360;
+    constexpr auto SAMPLE_MAX = 830;
+    constexpr auto SAMPLE_COUNT = SAMPLE_MAX - SAMPLE_MIN + 1;
+
+    // Band responses are cut off this many standard deviations away from their center
+    constexpr auto CUTOFF_DEVIATIONS = 4.0;
+
+    // Narrower bands would fall between samples
+    constexpr auto MIN_FULL_WIDTH = 1.0;
+}
+
+std::vector<glm::vec4> spd::computeTristimulusWeights(
+    const std::span<const double> centers,
+    const std::span<const double> fullWidths,
+    const Illuminant illuminant,
+    const Sensor sensor
+) {
+    // Tabulate the illuminant times the color matching functions once, integrating a band then takes one vec4
+    // multiply-add per sample over contiguous memory
+    auto products = std::array<glm::vec4, SAMPLE_COUNT>{};
+    for (auto s = 0; s < SAMPLE_COUNT; ++s) {
+        const auto wavelength = static_cast<uint32_t>(SAMPLE_MIN + s);
+        products[s] = getIlluminantValueAt(wavelength, illuminant) * glm::vec4{
+            getSensorXValueAt(wavelength, sensor),
+            getSensorYValueAt(wavelength, sensor),
+            getSensorZValueAt(wavelength, sensor),
+            0.0f };
+    }
+
+    auto response = std::array<float, SAMPLE_COUNT>{};
+    auto weights = std::vector<glm::vec4>(centers.size());
+    auto k = 0.0f;
+    for (std::size_t i = 0; i < centers.size(); ++i) {
+        const auto center = centers[i];
+        const auto deviation = std::max(fullWidths[i], MIN_FULL_WIDTH) / (2.0 * std::sqrt(2.0 * std::numbers::ln2));
+        const auto first = std::clamp(
+            static_cast<int>(std::floor(center - CUTOFF_DEVIATIONS * deviation)) - SAMPLE_MIN, 0, SAMPLE_COUNT);
+        const auto last = std::clamp(
+            static_cast<int>(std::ceil(center + CUTOFF_DEVIATIONS * deviation)) - SAMPLE_MIN + 1, first, SAMPLE_COUNT);
+
+        // A Gaussian of unit area, what falls outside the tables doesn't contribute
+        const auto scale = static_cast<float>(1.0 / (deviation * std::sqrt(2.0 * std::numbers::pi)));
+        const auto exponent = static_cast<float>(-0.5 / (deviation * deviation));
+        for (auto s = first; s < last; ++s) {
+            const auto distance = static_cast<float>(SAMPLE_MIN + s - center);
+            response[s] = scale * std::exp(exponent * distance * distance);
+        }
+
+        auto weight = glm::vec4{ 0.0f };
+        for (auto s = first; s < last; ++s) {
+            weight += response[s] * products[s];
+        }
+        weights[i] = weight;
+        k += weight.y;
+    }
+
+    if (k > 0.0f) {
+        for (auto& weight : weights) {
+            weight /= k;
+        }
+    }
+    return weights;
+}
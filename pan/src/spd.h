@@ -1,8 +1,12 @@
 #pragma once
 
+#include <glm/glm.hpp>
+
 #include <array>
 #include <cstdint>
+#include <span>
 #include <stdexcept>
+#include <vector>
 
 
 namespace spd {
@@ -512,4 +516,17 @@ namespace spd {
             default: throw std::runtime_error("Unrecognized sensor");
         }
     }
-}
\ No newline at end of file
+
+    /**
+     * Integrates the illuminant and the color matching functions of a sensor against the response of each band,
+     * modeled as a Gaussian of the band's full width at half maximum. The weights are normalized so that a perfect
+     * reflector has a Y of 1, and the tristimulus values of a spectrum are the sums of its reflectances times the
+     * weights of their bands.
+     *
+     * @param centers The center wavelengths of the bands, in nanometers.
+     * @param fullWidths The full widths at half maximum of the bands, in nanometers.
+     * @return One x, y, z weight per band, padded to a vec4.
+     */
+    [[nodiscard]] std::vector<glm::vec4> computeTristimulusWeights(
+        std::span<const double> centers, std::span<const double> fullWidths, Illuminant illuminant, Sensor sensor);
+}
@@ -0,0 +1,133 @@
+#include "bandmath.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+
+using bandmath::Opcode;
+
+static constexpr auto WAVELENGTHS = std::array<uint32_t, 3>{ 550, 670, 800 };
+
+static int failureCount = 0;
+
+static void check(const bool condition, const std::string_view what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failureCount;
+    }
+}
+
+static Opcode getOpcode(const uint32_t instruction) {
+    return static_cast<Opcode>(instruction >> 24);
+}
+
+static int getOperand(const uint32_t instruction) {
+    return static_cast<int>(instruction & 0xFFFFFF);
+}
+
+static bool contains(const bandmath::Program& program, const Opcode opcode) {
+    return std::ranges::any_of(program.instructions, [opcode](const auto it) { return getOpcode(it) == opcode; });
+}
+
+// Evaluates a program for one pixel as bandmath.comp does, for the opcodes the tests below use
+static float evaluate(const bandmath::Program& program, const std::array<float, WAVELENGTHS.size()>& reflectances) {
+    auto stack = std::vector<float>{};
+    for (const auto instruction : program.instructions) {
+        const auto operand = getOperand(instruction);
+        switch (getOpcode(instruction)) {
+            case Opcode::Band: stack.push_back(reflectances[operand]); break;
+            case Opcode::Constant: stack.push_back(program.constants[operand]); break;
+            case Opcode::Subtract: {
+                const auto right = stack.back();
+                stack.pop_back();
+                stack.back() -= right;
+                break;
+            }
+            case Opcode::Multiply: {
+                const auto right = stack.back();
+                stack.pop_back();
+                stack.back() *= right;
+                break;
+            }
+            case Opcode::Negate: stack.back() = -stack.back(); break;
+            case Opcode::IntegerPower: {
+                const auto exponent = operand - bandmath::INTEGER_POWER_BIAS;
+                auto result = 1.0f;
+                auto factor = stack.back();
+                for (auto n = std::abs(exponent); n > 0; n >>= 1) {
+                    if ((n & 1) != 0) {
+                        result *= factor;
+                    }
+                    factor *= factor;
+                }
+                stack.back() = exponent < 0 ? 1.0f / result : result;
+                break;
+            }
+            default:
+                check(false, "the program only uses the opcodes the test evaluates");
+                return NAN;
+        }
+    }
+    return stack.back();
+}
+
+static void testSquareOfNegativeBase() {
+    // R800 is darker than R670 here, pow would be undefined for the negative difference
+    const auto program = bandmath::compile("(R800 - R670)^2", WAVELENGTHS, 0);
+    check(!contains(program, Opcode::Power), "(R800 - R670)^2 is not lowered to pow");
+    check(contains(program, Opcode::IntegerPower), "(R800 - R670)^2 is lowered to an integer power");
+    check(program.constants.empty(), "the exponent of (R800 - R670)^2 leaves the constant table");
+    const auto value = evaluate(program, { 0.1f, 0.5f, 0.2f });
+    check(std::abs(value - 0.09f) < 1e-6f, std::format("(0.2 - 0.5)^2 is 0.09, got {}", value));
+}
+
+static void testNegativeExponent() {
+    const auto program = bandmath::compile("(R550 - R670)^-3", WAVELENGTHS, 0);
+    check(!contains(program, Opcode::Power), "a negated integer exponent is not lowered to pow");
+    const auto value = evaluate(program, { 0.0f, 0.5f, 0.0f });
+    check(std::abs(value + 8.0f) < 1e-5f, std::format("(0 - 0.5)^-3 is -8, got {}", value));
+}
+
+static void testSharedConstant() {
+    // The exponent is the same constant as the factor, which must stay in the table
+    const auto program = bandmath::compile("2 * R800^2", WAVELENGTHS, 0);
+    check(program.constants == std::vector{ 2.0f }, "a constant shared with the exponent stays in the table");
+    const auto value = evaluate(program, { 0.0f, 0.0f, 0.5f });
+    check(std::abs(value - 0.5f) < 1e-6f, std::format("2 * 0.5^2 is 0.5, got {}", value));
+}
+
+static void testSameKernelAsMultiplication() {
+    // A lowered power doesn't depend on how its exponent was written
+    const auto square = bandmath::compile("R800^2", WAVELENGTHS, 0);
+    const auto squareWithDecimals = bandmath::compile("R800^2.0", WAVELENGTHS, 0);
+    check(square.getKey() == squareWithDecimals.getKey(), "R800^2 and R800^2.0 share a kernel");
+}
+
+static void testNonIntegerExponent() {
+    const auto program = bandmath::compile("(R800 - R670)^0.5", WAVELENGTHS, 0);
+    check(contains(program, Opcode::Power), "non-integer exponents still use pow");
+    check(!contains(program, Opcode::IntegerPower), "non-integer exponents are not lowered");
+
+    const auto variable = bandmath::compile("R800^R670", WAVELENGTHS, 0);
+    check(contains(variable, Opcode::Power), "band exponents still use pow");
+}
+
+int main() {
+    testSquareOfNegativeBase();
+    testNegativeExponent();
+    testSharedConstant();
+    testSameKernelAsMultiplication();
+    testNonIntegerExponent();
+
+    if (failureCount > 0) {
+        std::cerr << failureCount << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All band math compiler checks passed" << std::endl;
+    return 0;
+}